@@ -0,0 +1,104 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "utils/HouseColumnStore.h"
+#include "utils/HouseTable.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <new>
+#include <numeric>
+
+using namespace std;
+
+namespace {
+
+atomic<size_t> allocationCount(0);
+
+const size_t DEFAULT_ROWS = 1000000;
+
+struct AllocationReport {
+    size_t allocations;
+    double buildMs;
+    double freeMs;
+};
+
+// build() собирает результат в куче; замеряются его выделения памяти и
+// время освобождения, без выделений внутри генератора данных
+template <typename Result, typename Build>
+AllocationReport measure(const Build& build) {
+    AllocationReport report;
+    size_t before = allocationCount.load(memory_order_relaxed);
+    BenchClock::time_point start = BenchClock::now();
+    Result* result = new Result(build());
+    report.buildMs = elapsedMs(start);
+    report.allocations = allocationCount.load(memory_order_relaxed) - before - 1;
+
+    start = BenchClock::now();
+    delete result;
+    report.freeMs = elapsedMs(start);
+    return report;
+}
+
+void printReport(const char* name, const AllocationReport& report) {
+    cout << name << ": выделений " << report.allocations << ", сборка " << setprecision(0) << report.buildMs
+         << " мс, освобождение " << setprecision(1) << report.freeMs << " мс" << endl;
+}
+
+}
+
+// Счетчик выделений для всей программы; остальные команды его не читают
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void* memory = malloc(size ? size : 1)) return memory;
+    throw bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+// Выделения памяти под результат на 1M строк: vector<House> (строка адреса
+// у каждого дома) против HouseTable (адреса в одном буфере), в том числе
+// выборка строк снимка, как в MainWindow::applyView
+int runAllocationBench(const vector<string>& args) {
+    size_t rows = args.empty() ? DEFAULT_ROWS : stoul(args[0]);
+
+    HouseGenerator generator;
+    vector<House> houses;
+    houses.reserve(rows);
+    for (size_t i = 0; i < rows; ++i) houses.push_back(generator.next());
+
+    HouseColumnStore store;
+    store.assign(HouseTable::fromHouses(houses));
+    vector<uint32_t> all(rows);
+    iota(all.begin(), all.end(), 0);
+
+    cout << fixed << "строк " << rows << endl;
+
+    printReport("vector<House>", measure<vector<House>>([&houses]() {
+        vector<House> copy;
+        copy.reserve(houses.size());
+        for (const House& house : houses) copy.push_back(house);
+        return copy;
+    }));
+    printReport("HouseTable::fromHouses", measure<HouseTable>([&houses]() {
+        return HouseTable::fromHouses(houses);
+    }));
+    printReport("снимок -> vector<House>", measure<vector<House>>([&store, &all]() {
+        vector<House> selected;
+        selected.reserve(all.size());
+        for (uint32_t row : all) selected.push_back(store.house(row));
+        return selected;
+    }));
+    printReport("снимок -> HouseColumnStore::extract", measure<HouseTable>([&store, &all]() {
+        HouseTable selected;
+        store.extract(all, selected);
+        return selected;
+    }));
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Команды HousingFundBench; args - аргументы после имени команды.
+// Возвращают код завершения программы
+int runExportBench(const vector<string>& args);
+int runFormatterBench(const vector<string>& args);
+int runSortBench(const vector<string>& args);
+int runCollationBench(const vector<string>& args);
+int runAllocationBench(const vector<string>& args);
+
+typedef chrono::steady_clock BenchClock;
+
+inline double elapsedMs(BenchClock::time_point start) {
+    return chrono::duration<double, milli>(BenchClock::now() - start).count();
+}
+
+#endif
@@ -0,0 +1,36 @@
+#include "BenchData.h"
+
+namespace {
+
+const char* const CITIES[] = {
+    "г. Москва", "г. Санкт-Петербург", "г. Екатеринбург", "г. Новосибирск", "г. Ёлкино"
+};
+const char* const STREETS[] = {
+    "ул. Ленина", "пр. Мира", "ул. Садовая", "Невский пр.", "ул. Гагарина",
+    "ул. Школьная", "ул. Юбилейная", "пер. Речной", "ш. Энтузиастов", "б-р Победы"
+};
+
+const size_t CITY_COUNT = sizeof(CITIES) / sizeof(CITIES[0]);
+const size_t STREET_COUNT = sizeof(STREETS) / sizeof(STREETS[0]);
+const size_t HOUSE_NUMBERS = 300;
+
+}
+
+HouseGenerator::HouseGenerator(uint32_t seed) : rng(seed), nextId(1) {}
+
+House HouseGenerator::next() {
+    House house;
+    house.id = nextId++;
+
+    size_t code = static_cast<size_t>(house.id - 1);
+    house.address = string(CITIES[code % CITY_COUNT]) + ", " + STREETS[code / CITY_COUNT % STREET_COUNT] +
+                    ", д. " + to_string(1 + code / (CITY_COUNT * STREET_COUNT) % HOUSE_NUMBERS);
+    size_t building = code / (CITY_COUNT * STREET_COUNT * HOUSE_NUMBERS);
+    if (building > 0) house.address += ", корп. " + to_string(building);
+
+    house.apartments = 1 + rng() % 400;
+    house.totalArea = Area(static_cast<int64_t>(1000 + rng() % 2000000));
+    house.buildYear = 1900 + rng() % 125;
+    house.floors = 1 + rng() % 40;
+    return house;
+}
@@ -0,0 +1,24 @@
+#ifndef BENCHDATA_H
+#define BENCHDATA_H
+
+#include <random>
+#include <cstdint>
+#include "models/House.h"
+
+using namespace std;
+
+// Дома для замеров: одна и та же последовательность при каждом запуске.
+// Адрес у каждого дома свой, как в фонде; соседние по id дома - в разных
+// городах и на разных улицах
+class HouseGenerator {
+public:
+    explicit HouseGenerator(uint32_t seed = 1);
+
+    House next();
+
+private:
+    mt19937 rng;
+    int nextId;
+};
+
+#endif
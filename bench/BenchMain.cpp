@@ -0,0 +1,37 @@
+#include "Bench.h"
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+void printUsage(const char* program) {
+    cerr << "Использование: " << program << " <команда> [аргументы]\n"
+         << "  export <строка подключения> [каталог] - параллельный экспорт против exportToFile\n"
+         << "  formatter [строк] [каталог] - прежний экспорт из памяти против ExportFormatter\n"
+         << "  sort [строк...] - HouseSortKeys::sort на 1M и 10M строк при 1/2/4/8 потоках\n"
+         << "  collation [строк] - прежний компаратор и QCollator против HouseSortKeys\n"
+         << "  allocations [строк] - выделения памяти: vector<House> против HouseTable\n";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    string command = argv[1];
+    vector<string> args(argv + 2, argv + argc);
+    
+    if (command == "export") return runExportBench(args);
+    if (command == "formatter") return runFormatterBench(args);
+    if (command == "sort") return runSortBench(args);
+    if (command == "collation") return runCollationBench(args);
+    if (command == "allocations") return runAllocationBench(args);
+    
+    cerr << "Неизвестная команда: " << command << endl;
+    printUsage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,126 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "ui/HouseSortKeys.h"
+#include "ui/HouseTableModel.h"
+#include "utils/HouseColumnStore.h"
+#include "utils/HouseTable.h"
+#include <QCollator>
+#include <QLocale>
+#include <QString>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+
+namespace {
+
+const size_t DEFAULT_ROWS = 1000000;
+
+// Прежнее сравнение домов в MainWindow: оба адреса переводятся в QString
+// на каждом сравнении и сравниваются по кодам UTF-16, без правил локали
+bool previousLess(const House& a, const House& b, const vector<HouseSortKey>& keys) {
+    for (const HouseSortKey& key : keys) {
+        int comparison = 0;
+
+        switch (key.column) {
+            case HouseTableModel::COLUMN_ADDRESS:
+                comparison = QString::fromStdString(a.address).compare(QString::fromStdString(b.address));
+                break;
+            case HouseTableModel::COLUMN_APARTMENTS:
+                comparison = a.apartments - b.apartments;
+                break;
+            case HouseTableModel::COLUMN_TOTAL_AREA:
+                comparison = (a.totalArea < b.totalArea) ? -1 : (a.totalArea > b.totalArea) ? 1 : 0;
+                break;
+            case HouseTableModel::COLUMN_BUILD_YEAR:
+                comparison = a.buildYear - b.buildYear;
+                break;
+            case HouseTableModel::COLUMN_FLOORS:
+                comparison = a.floors - b.floors;
+                break;
+            default:
+                continue;
+        }
+
+        if (comparison != 0) {
+            return key.ascending ? (comparison < 0) : (comparison > 0);
+        }
+    }
+    return false;
+}
+
+}
+
+// Сортировка по адресу по правилам русской локали: прежний компаратор,
+// QCollator::compare на каждом сравнении и ключи HouseSortKeys на одних и
+// тех же сгенерированных домах. Порядок HouseSortKeys должен совпадать с
+// устойчивой сортировкой через QCollator::compare
+int runCollationBench(const vector<string>& args) {
+    size_t rows = args.empty() ? DEFAULT_ROWS : stoul(args[0]);
+
+    HouseGenerator generator;
+    vector<House> houses;
+    houses.reserve(rows);
+    for (size_t i = 0; i < rows; ++i) houses.push_back(generator.next());
+    HouseColumnStore store;
+    store.assign(HouseTable::fromHouses(houses));
+
+    const vector<vector<HouseSortKey>> cases = {
+        {{HouseTableModel::COLUMN_ADDRESS, true}},
+        {{HouseTableModel::COLUMN_ADDRESS, true}, {HouseTableModel::COLUMN_TOTAL_AREA, true}},
+        {{HouseTableModel::COLUMN_BUILD_YEAR, true}, {HouseTableModel::COLUMN_APARTMENTS, true}}
+    };
+    const char* const names[] = {"адрес", "адрес, площадь", "год, квартиры"};
+
+    vector<uint32_t> all(rows);
+    iota(all.begin(), all.end(), 0);
+
+    cout << fixed << setprecision(0);
+    cout << "строк " << rows << endl;
+
+    HouseSortKeys sorter;
+    vector<uint32_t> keyOrder = all;
+    BenchClock::time_point start = BenchClock::now();
+    sorter.sort(keyOrder, store, cases[0]);
+    cout << "HouseSortKeys, первая сортировка по адресу (с ключами адресов): " << elapsedMs(start) << " мс" << endl;
+
+    for (size_t c = 0; c < cases.size(); ++c) {
+        vector<House> previous = houses;
+        start = BenchClock::now();
+        sort(previous.begin(), previous.end(), [&](const House& a, const House& b) {
+            return previousLess(a, b, cases[c]);
+        });
+        double previousMs = elapsedMs(start);
+
+        vector<uint32_t> positions = all;
+        start = BenchClock::now();
+        sorter.sort(positions, store, cases[c]);
+        double keysMs = elapsedMs(start);
+
+        cout << names[c] << ": прежний компаратор " << previousMs << " мс, HouseSortKeys " << keysMs << " мс" << endl;
+    }
+
+    // Ключ сопоставления на каждом сравнении: так сортировал бы прежний
+    // компаратор, если бы сравнивал адреса по правилам локали
+    QCollator collator(QLocale(QLocale::Russian, QLocale::Russia));
+    collator.setNumericMode(true);
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    vector<uint32_t> collatorOrder = all;
+    start = BenchClock::now();
+    stable_sort(collatorOrder.begin(), collatorOrder.end(), [&](uint32_t a, uint32_t b) {
+        string_view left = store.address(a);
+        string_view right = store.address(b);
+        return collator.compare(QString::fromUtf8(left.data(), static_cast<qsizetype>(left.size())),
+                                QString::fromUtf8(right.data(), static_cast<qsizetype>(right.size()))) < 0;
+    });
+    cout << "адрес, QCollator::compare на каждом сравнении: " << elapsedMs(start) << " мс" << endl;
+
+    if (collatorOrder != keyOrder) {
+        cout << "порядок HouseSortKeys отличается от QCollator::compare" << endl;
+        return 2;
+    }
+    cout << "порядок HouseSortKeys совпадает с QCollator::compare" << endl;
+    return 0;
+}
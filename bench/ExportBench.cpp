@@ -0,0 +1,104 @@
+#include "Bench.h"
+#include "database/DatabaseManager.h"
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+
+const size_t THREAD_COUNTS[] = {1, 2, 4, 8};
+const size_t COMPARE_BUFFER_SIZE = 1 << 20;
+
+long long fileSize(const string& filename) {
+    ifstream file(filename, ios::binary | ios::ate);
+    return file ? static_cast<long long>(file.tellg()) : -1;
+}
+
+// Смещение первого различающегося байта; -1, если файлы совпадают
+long long firstDifference(const string& expected, const string& actual) {
+    ifstream left(expected, ios::binary);
+    ifstream right(actual, ios::binary);
+    if (!left || !right) return 0;
+
+    vector<char> leftBuffer(COMPARE_BUFFER_SIZE);
+    vector<char> rightBuffer(COMPARE_BUFFER_SIZE);
+    long long offset = 0;
+    while (true) {
+        left.read(leftBuffer.data(), leftBuffer.size());
+        right.read(rightBuffer.data(), rightBuffer.size());
+        streamsize leftCount = left.gcount();
+        streamsize rightCount = right.gcount();
+
+        streamsize common = min(leftCount, rightCount);
+        for (streamsize i = 0; i < common; ++i) {
+            if (leftBuffer[i] != rightBuffer[i]) return offset + i;
+        }
+        if (leftCount != rightCount) return offset + common;
+        if (leftCount == 0) return -1;
+        offset += leftCount;
+    }
+}
+
+}
+
+// Экспорт всех полей через exportToFile и через exportToFileParallel на
+// 1/2/4/8 потоках. Файл параллельного экспорта должен совпадать с
+// последовательным побайтно. Пул соединений копирования ограничивает
+// число рабочих потоков размером пула минус координатор
+int runExportBench(const vector<string>& args) {
+    if (args.empty()) {
+        cerr << "Ошибка: не задана строка подключения" << endl;
+        return 1;
+    }
+    string directory = args.size() > 1 ? args[1] : ".";
+
+    DatabaseManager db(args[0]);
+    if (!db.connect()) {
+        cerr << "Ошибка подключения к базе данных" << endl;
+        return 1;
+    }
+
+    vector<string> fields = {"id", "address", "apartments", "total_area", "build_year", "floors", "age"};
+    string reference = directory + "/bench_export_serial.txt";
+    remove(reference.c_str());
+
+    BenchClock::time_point start = BenchClock::now();
+    if (!db.exportToFile(reference, fields)) {
+        cerr << "Ошибка последовательного экспорта" << endl;
+        return 1;
+    }
+    double serialMs = elapsedMs(start);
+
+    cout << fixed << setprecision(0);
+    cout << "exportToFile: " << serialMs << " мс, " << fileSize(reference) << " байт" << endl;
+
+    bool identical = true;
+    for (size_t threads : THREAD_COUNTS) {
+        string output = directory + "/bench_export_parallel_" + to_string(threads) + ".txt";
+        remove(output.c_str());
+
+        start = BenchClock::now();
+        if (!db.exportToFileParallel(output, fields, "\t", true, 0, threads)) {
+            cerr << "Ошибка параллельного экспорта на " << threads << " потоках" << endl;
+            return 1;
+        }
+        double parallelMs = elapsedMs(start);
+
+        long long difference = firstDifference(reference, output);
+        cout << "exportToFileParallel, потоков " << threads << ": " << parallelMs << " мс, ускорение "
+             << setprecision(2) << serialMs / parallelMs << setprecision(0) << ", ";
+        if (difference < 0) {
+            cout << "файл совпадает" << endl;
+        } else {
+            cout << "файл отличается с байта " << difference << endl;
+            identical = false;
+        }
+        remove(output.c_str());
+    }
+
+    remove(reference.c_str());
+    return identical ? 0 : 2;
+}
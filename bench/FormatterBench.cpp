@@ -0,0 +1,96 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "utils/ExportFormatter.h"
+#include "utils/HouseTable.h"
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+
+const size_t DEFAULT_ROWS = 1000000;
+const int REPEATS = 3;
+
+// Прежний экспорт из памяти: имя поля сравнивается на каждой ячейке,
+// значения выводятся через ofstream, площадь - как double
+bool previousExport(const vector<House>& houses, const string& filename,
+                    const vector<string>& fields, const string& delimiter, bool includeHeader) {
+    ofstream file(filename);
+    if (!file.is_open()) return false;
+
+    if (includeHeader) {
+        for (size_t i = 0; i < fields.size(); ++i) {
+            file << fields[i];
+            if (i < fields.size() - 1) file << delimiter;
+        }
+        file << "\n";
+    }
+
+    for (const auto& house : houses) {
+        for (size_t i = 0; i < fields.size(); ++i) {
+            const auto& field = fields[i];
+            if (field == "id") file << house.id;
+            else if (field == "address") file << house.address;
+            else if (field == "apartments") file << house.apartments;
+            else if (field == "total_area") file << house.totalArea.hundredths / 100.0;
+            else if (field == "build_year") file << house.buildYear;
+            else if (field == "floors") file << house.floors;
+            else if (field == "age") file << house.getAge();
+            if (i < fields.size() - 1) file << delimiter;
+        }
+        file << "\n";
+    }
+
+    file.close();
+    return true;
+}
+
+}
+
+// Прежний экспорт против ExportFormatter::writeFile на одних и тех же
+// сгенерированных домах: все поля, с заголовком, без сжатия
+int runFormatterBench(const vector<string>& args) {
+    size_t rows = args.empty() ? DEFAULT_ROWS : stoul(args[0]);
+    string directory = args.size() > 1 ? args[1] : ".";
+
+    HouseGenerator generator;
+    vector<House> houses;
+    houses.reserve(rows);
+    for (size_t i = 0; i < rows; ++i) houses.push_back(generator.next());
+    HouseTable table = HouseTable::fromHouses(houses);
+
+    vector<string> fields = {"id", "address", "apartments", "total_area", "build_year", "floors", "age"};
+    string previousFile = directory + "/bench_formatter_previous.txt";
+    string formatterFile = directory + "/bench_formatter.txt";
+
+    cout << fixed << setprecision(0);
+    for (char delimiter : {';', '\t'}) {
+        ExportFormatter formatter(fields, delimiter);
+        for (int repeat = 0; repeat < REPEATS; ++repeat) {
+            BenchClock::time_point start = BenchClock::now();
+            if (!previousExport(houses, previousFile, fields, string(1, delimiter), true)) {
+                cerr << "Ошибка записи файла: " << previousFile << endl;
+                return 1;
+            }
+            double previousMs = elapsedMs(start);
+
+            start = BenchClock::now();
+            if (!formatter.writeFile(table, formatterFile, true)) {
+                cerr << "Ошибка записи файла: " << formatterFile << endl;
+                return 1;
+            }
+            double formatterMs = elapsedMs(start);
+
+            cout << "разделитель " << (delimiter == '\t' ? "tab" : "';'") << ", строк " << rows
+                 << ": прежний " << previousMs << " мс, ExportFormatter " << formatterMs
+                 << " мс, ускорение " << setprecision(1) << previousMs / formatterMs << setprecision(0) << endl;
+        }
+    }
+
+    remove(previousFile.c_str());
+    remove(formatterFile.c_str());
+    return 0;
+}
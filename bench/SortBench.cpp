@@ -0,0 +1,101 @@
+#include "Bench.h"
+#include "BenchData.h"
+#include "ui/HouseSortKeys.h"
+#include "ui/HouseTableModel.h"
+#include "utils/HouseColumnStore.h"
+#include "utils/HouseTable.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+const size_t DEFAULT_ROWS[] = {1000000, 10000000};
+
+struct SortCase {
+    const char* name;
+    vector<HouseSortKey> keys;
+};
+
+vector<SortCase> sortCases() {
+    return {
+        {"площадь по убыванию", {{HouseTableModel::COLUMN_TOTAL_AREA, false}}},
+        {"год, этажность", {{HouseTableModel::COLUMN_BUILD_YEAR, true}, {HouseTableModel::COLUMN_FLOORS, true}}},
+        {"адрес", {{HouseTableModel::COLUMN_ADDRESS, true}}},
+        {"год, адрес по убыванию", {{HouseTableModel::COLUMN_BUILD_YEAR, true}, {HouseTableModel::COLUMN_ADDRESS, false}}}
+    };
+}
+
+// 1, 2, 4, 8 и число ядер, если его нет среди них
+vector<size_t> workerSweep() {
+    vector<size_t> workers = {1, 2, 4, 8};
+    size_t cores = max<unsigned>(1, thread::hardware_concurrency());
+    if (find(workers.begin(), workers.end(), cores) == workers.end()) workers.push_back(cores);
+    std::sort(workers.begin(), workers.end());
+    return workers;
+}
+
+}
+
+// HouseSortKeys::sort по сгенерированному снимку на 1M и 10M строк
+// (или на заданном числе строк) при разном числе потоков. Ключи адресов
+// строятся при первой сортировке по адресу и замеряются отдельно.
+// Порядок строк при любом числе потоков должен совпадать с однопоточным
+int runSortBench(const vector<string>& args) {
+    vector<size_t> sizes;
+    for (const string& arg : args) sizes.push_back(stoul(arg));
+    if (sizes.empty()) sizes.assign(begin(DEFAULT_ROWS), end(DEFAULT_ROWS));
+
+    vector<SortCase> cases = sortCases();
+    vector<size_t> sweep = workerSweep();
+    bool consistent = true;
+
+    cout << fixed << setprecision(0);
+    for (size_t rows : sizes) {
+        HouseColumnStore store;
+        {
+            HouseGenerator generator;
+            HouseTable table;
+            table.reserve(rows);
+            for (size_t i = 0; i < rows; ++i) table.append(generator.next());
+            store.assign(table);
+        }
+        cout << "строк " << rows << ", адресов в словаре " << store.dictionarySize() << endl;
+
+        vector<uint32_t> all(rows);
+        iota(all.begin(), all.end(), 0);
+        vector<vector<uint32_t>> expected(cases.size());
+
+        for (size_t workers : sweep) {
+            HouseSortKeys sorter;
+            sorter.setMaxWorkers(workers);
+
+            vector<uint32_t> positions = all;
+            BenchClock::time_point start = BenchClock::now();
+            sorter.sort(positions, store, {{HouseTableModel::COLUMN_ADDRESS, true}});
+            cout << "  потоков " << workers << ": первая сортировка по адресу (с ключами адресов) "
+                 << elapsedMs(start) << " мс" << endl;
+
+            for (size_t c = 0; c < cases.size(); ++c) {
+                positions = all;
+                start = BenchClock::now();
+                sorter.sort(positions, store, cases[c].keys);
+                double sortMs = elapsedMs(start);
+
+                cout << "    " << cases[c].name << ": " << sortMs << " мс";
+                if (expected[c].empty()) {
+                    expected[c] = move(positions);
+                } else if (positions != expected[c]) {
+                    cout << ", порядок отличается от однопоточного";
+                    consistent = false;
+                }
+                cout << endl;
+            }
+        }
+    }
+    return consistent ? 0 : 2;
+}
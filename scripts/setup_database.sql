@@ -9,6 +9,8 @@ BEGIN
     DROP FUNCTION IF EXISTS get_houses_older_than(INTEGER) CASCADE;
     DROP FUNCTION IF EXISTS house_exists(TEXT) CASCADE;
     DROP FUNCTION IF EXISTS house_exists_except_id(TEXT, INTEGER) CASCADE; 
+    DROP FUNCTION IF EXISTS address_taken(TEXT, INTEGER) CASCADE;
+    DROP FUNCTION IF EXISTS get_house_addresses() CASCADE;
     DROP FUNCTION IF EXISTS add_user(TEXT, TEXT, TEXT) CASCADE;
     DROP FUNCTION IF EXISTS authenticate_user(TEXT, TEXT) CASCADE;
     DROP FUNCTION IF EXISTS get_user_by_login(TEXT) CASCADE;
@@ -36,11 +38,123 @@ CREATE TABLE IF NOT EXISTS houses (
     created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
 );
 
+-- Отслеживание изменений для инкрементального экспорта.
+-- Метки с часовым поясом: сравнение не зависит от TimeZone сессии клиента
+ALTER TABLE houses ADD COLUMN IF NOT EXISTS updated_at TIMESTAMPTZ DEFAULT CURRENT_TIMESTAMP;
+
+CREATE TABLE IF NOT EXISTS house_tombstones (
+    house_id INT NOT NULL,
+    deleted_at TIMESTAMPTZ NOT NULL DEFAULT CURRENT_TIMESTAMP
+);
+
+CREATE TABLE IF NOT EXISTS export_watermarks (
+    name TEXT PRIMARY KEY,
+    exported_until TIMESTAMPTZ NOT NULL
+);
+
+-- Базы, созданные с TIMESTAMP: прежние значения читаются в поясе TimeZone этой сессии
+DO $$
+DECLARE
+    col RECORD;
+BEGIN
+    FOR col IN
+        SELECT table_name, column_name FROM information_schema.columns
+        WHERE table_schema = current_schema()
+          AND (table_name, column_name) IN (('houses', 'updated_at'),
+                                            ('house_tombstones', 'deleted_at'),
+                                            ('export_watermarks', 'exported_until'))
+          AND data_type = 'timestamp without time zone'
+    LOOP
+        EXECUTE format('ALTER TABLE %I ALTER COLUMN %I TYPE TIMESTAMPTZ', col.table_name, col.column_name);
+    END LOOP;
+END $$;
+
+-- Метка экспорта и синхронизации снимка берется по началу самой старой
+-- транзакции в pg_stat_activity; транзакции других ролей видны только членам
+-- pg_read_all_stats. Без роли метка не сдвигается и выгрузки повторяются
+DO $$
+BEGIN
+    IF EXISTS (SELECT 1 FROM pg_roles WHERE rolname = 'housing_user') THEN
+        GRANT pg_read_all_stats TO housing_user;
+    END IF;
+EXCEPTION
+    WHEN insufficient_privilege THEN
+        RAISE WARNING 'Выдайте роль pg_read_all_stats пользователю housing_user от имени суперпользователя';
+END $$;
+
 -- Индексы
 CREATE INDEX IF NOT EXISTS idx_users_login ON users(login);
 CREATE INDEX IF NOT EXISTS idx_houses_address ON houses(address);
+CREATE INDEX IF NOT EXISTS idx_houses_updated_at ON houses(updated_at);
+CREATE INDEX IF NOT EXISTS idx_house_tombstones_deleted_at ON house_tombstones(deleted_at);
+
+-- Порядок адресов постраничной выборки совпадает с сортировкой в памяти
+-- (QCollator ru_RU: "д. 9" раньше "д. 10", регистр не различается).
+-- Сервер без ICU сравнивает адреса побайтно, и порядок режимов расходится
+DO $$
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM pg_collation WHERE collname = 'housing_address') THEN
+        BEGIN
+            CREATE COLLATION housing_address (provider = icu, locale = 'ru-RU-u-kn-true-ks-level2');
+        EXCEPTION
+            WHEN feature_not_supported OR invalid_parameter_value THEN
+                RAISE WARNING 'PostgreSQL без ICU: адреса сортируются побайтно';
+                CREATE COLLATION housing_address FROM "C";
+        END;
+    END IF;
+END $$;
+
+-- Индексы для постраничной выборки (keyset по ключу сортировки и id)
+DROP INDEX IF EXISTS idx_houses_address_c_id;
+CREATE INDEX IF NOT EXISTS idx_houses_address_sort_id ON houses((address COLLATE housing_address), id);
+CREATE INDEX IF NOT EXISTS idx_houses_apartments_id ON houses(apartments, id);
+CREATE INDEX IF NOT EXISTS idx_houses_total_area_id ON houses(total_area, id);
+CREATE INDEX IF NOT EXISTS idx_houses_build_year_id ON houses(build_year, id);
+CREATE INDEX IF NOT EXISTS idx_houses_floors_id ON houses(floors, id);
+
+-- Время изменения - начало транзакции (now()), а не момент записи:
+-- так экспорт может сдвигать метку по самой старой активной транзакции
+CREATE OR REPLACE FUNCTION houses_touch_updated_at()
+RETURNS TRIGGER AS $$
+BEGIN
+    NEW.updated_at := now();
+    RETURN NEW;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE OR REPLACE FUNCTION houses_record_tombstone()
+RETURNS TRIGGER AS $$
+BEGIN
+    INSERT INTO house_tombstones (house_id, deleted_at) VALUES (OLD.id, now());
+    RETURN OLD;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS trg_houses_updated_at ON houses;
+CREATE TRIGGER trg_houses_updated_at
+    BEFORE INSERT OR UPDATE ON houses
+    FOR EACH ROW EXECUTE FUNCTION houses_touch_updated_at();
+
+DROP TRIGGER IF EXISTS trg_houses_tombstone ON houses;
+CREATE TRIGGER trg_houses_tombstone
+    AFTER DELETE ON houses
+    FOR EACH ROW EXECUTE FUNCTION houses_record_tombstone();
 
 -- 1. ДОМА 
+-- Единственность адреса проверяется здесь: клиентский фильтр адресов строится
+-- при подключении и не видит домов, добавленных с других рабочих мест.
+-- Блокировка по адресу не дает двум транзакциям одновременно пройти проверку.
+-- Импорт из файла проверяет все адреса сразу и берет общий ключ адресов
+-- монопольно; здесь он берется совместно, поэтому проверки ждут конца импорта
+CREATE OR REPLACE FUNCTION address_taken(p_address TEXT, p_except_id INTEGER)
+RETURNS BOOLEAN AS $$
+BEGIN
+    PERFORM pg_advisory_xact_lock_shared(hashtext('houses.address'), 0);
+    PERFORM pg_advisory_xact_lock(hashtext(p_address));
+    RETURN EXISTS (SELECT 1 FROM houses WHERE address = p_address AND id IS DISTINCT FROM p_except_id);
+END;
+$$ LANGUAGE plpgsql;
+
 CREATE OR REPLACE FUNCTION add_house(
     p_address TEXT,
     p_apartments INTEGER,
@@ -51,6 +165,9 @@ CREATE OR REPLACE FUNCTION add_house(
 DECLARE
     new_id INTEGER;
 BEGIN
+    IF address_taken(p_address, NULL) THEN
+        RETURN -1;
+    END IF;
     INSERT INTO houses (address, apartments, total_area, build_year, floors)
     VALUES (p_address, p_apartments, p_total_area, p_build_year, p_floors)
     RETURNING id INTO new_id;
@@ -69,6 +186,9 @@ CREATE OR REPLACE FUNCTION update_house(
     p_floors INTEGER
 ) RETURNS BOOLEAN AS $$
 BEGIN
+    IF address_taken(p_address, p_id) THEN
+        RETURN FALSE;
+    END IF;
     UPDATE houses 
     SET address = p_address,
         apartments = p_apartments,
@@ -171,6 +291,18 @@ BEGIN
 END;
 $$ LANGUAGE plpgsql;
 
+-- Компактная выгрузка адресов для клиентского фильтра house_exists
+CREATE OR REPLACE FUNCTION get_house_addresses()
+RETURNS TABLE(
+    house_address TEXT
+) AS $$
+BEGIN
+    RETURN QUERY 
+    SELECT DISTINCT address
+    FROM houses;
+END;
+$$ LANGUAGE plpgsql;
+
 -- 2. ПОЛЬЗОВАТЕЛИ 
 CREATE OR REPLACE FUNCTION add_user(
     p_login TEXT,
@@ -14,6 +14,46 @@ public:
     static constexpr int MAX_PASSWORD_LENGTH = 50;
     static constexpr int MIN_LOGIN_LENGTH = 3;
     
+    // Начиная с этого числа домов таблица подгружается страницами
+    static long long getPagedTableThreshold() {
+        const char* threshold = getenv("HOUSING_PAGED_THRESHOLD");
+        return threshold ? atoll(threshold) : 50000;
+    }
+    
+    // Файл локального снимка домов; пустая строка - без кэша.
+    // HOUSING_SNAPSHOT_CACHE= (пустое значение) отключает кэш
+    static string getSnapshotCachePath() {
+        const char* path = getenv("HOUSING_SNAPSHOT_CACHE");
+        if (path) return path;
+        
+        const char* cacheHome = getenv("XDG_CACHE_HOME");
+        if (cacheHome && *cacheHome) return string(cacheHome) + "/housing_fund/houses.hsc";
+        const char* home = getenv("HOME");
+        if (home && *home) return string(home) + "/.cache/housing_fund/houses.hsc";
+        return "";
+    }
+    
+    // Имя общего снимка в общей памяти (shm_open), например "/housing_fund";
+    // пустая строка - программа загружает дома сама
+    static string getSharedSnapshotName() {
+        const char* name = getenv("HOUSING_SHARED_SNAPSHOT");
+        return name ? name : "";
+    }
+    
+    // Пользователь издателя общего снимка (имя или uid): программа принимает
+    // только его сегменты; пустая строка - общий снимок не читается
+    static string getSharedSnapshotOwner() {
+        const char* owner = getenv("HOUSING_SHARED_SNAPSHOT_OWNER");
+        return owner ? owner : "";
+    }
+    
+    // Группа пользователей программы, которой издатель открывает снимок на чтение;
+    // пустая строка - основная группа издателя
+    static string getSharedSnapshotGroup() {
+        const char* group = getenv("HOUSING_SHARED_SNAPSHOT_GROUP");
+        return group ? group : "";
+    }
+    
     static string getConnectionString() {
         // Получаем переменные окружения
         const char* host = getenv("DB_HOST");
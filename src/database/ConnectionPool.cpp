@@ -0,0 +1,140 @@
+#include "ConnectionPool.h"
+#include <libpq-fe.h>
+#include <iostream>
+
+using namespace std;
+
+ConnectionPool::ConnectionPool(const string& connStr, size_t maxSize)
+    : connectionString(connStr), maxConnections(maxSize > 0 ? maxSize : 1), openConnections(0) {}
+
+ConnectionPool::~ConnectionPool() {
+    lock_guard<mutex> lock(poolMutex);
+    for (PGconn* conn : idle) {
+        PQfinish(conn);
+    }
+    idle.clear();
+}
+
+PGconn* ConnectionPool::acquire() {
+    {
+        unique_lock<mutex> lock(poolMutex);
+        released.wait(lock, [this]() {
+            return !idle.empty() || openConnections < maxConnections;
+        });
+        
+        if (!idle.empty()) {
+            PGconn* conn = idle.back();
+            idle.pop_back();
+            return conn;
+        }
+        openConnections++;
+    }
+    
+    // Подключение выполняется без блокировки пула
+    PGconn* conn = connectNew();
+    if (!conn) {
+        lock_guard<mutex> lock(poolMutex);
+        openConnections--;
+        released.notify_one();
+    }
+    return conn;
+}
+
+void ConnectionPool::release(PGconn* conn) {
+    if (!conn) return;
+    
+    // Соединение с оборванной связью или незакрытой транзакцией в пул не возвращаем
+    bool reusable = PQstatus(conn) == CONNECTION_OK &&
+                    PQtransactionStatus(conn) == PQTRANS_IDLE;
+    if (!reusable) {
+        PQfinish(conn);
+    }
+    
+    lock_guard<mutex> lock(poolMutex);
+    if (reusable) {
+        idle.push_back(conn);
+    } else {
+        openConnections--;
+    }
+    released.notify_one();
+}
+
+size_t ConnectionPool::warmUp(size_t count) {
+    count = min(count, maxConnections);
+    
+    vector<PGconn*> warmed;
+    while (true) {
+        {
+            lock_guard<mutex> lock(poolMutex);
+            if (idle.size() + warmed.size() >= count || openConnections >= maxConnections) break;
+            openConnections++;
+        }
+        PGconn* conn = connectNew();
+        if (!conn) {
+            lock_guard<mutex> lock(poolMutex);
+            openConnections--;
+            break;
+        }
+        warmed.push_back(conn);
+    }
+    
+    lock_guard<mutex> lock(poolMutex);
+    idle.insert(idle.end(), warmed.begin(), warmed.end());
+    released.notify_all();
+    return idle.size();
+}
+
+void ConnectionPool::addPreparedStatement(const string& name, const string& sql) {
+    lock_guard<mutex> lock(poolMutex);
+    preparedStatements.emplace_back(name, sql);
+}
+
+size_t ConnectionPool::maxSize() const {
+    return maxConnections;
+}
+
+size_t ConnectionPool::idleCount() const {
+    lock_guard<mutex> lock(poolMutex);
+    return idle.size();
+}
+
+PGconn* ConnectionPool::connectNew() {
+    PGconn* conn = PQconnectdb(connectionString.c_str());
+    if (PQstatus(conn) != CONNECTION_OK) {
+        cerr << "Ошибка подключения к БД (пул): " << PQerrorMessage(conn) << endl;
+        PQfinish(conn);
+        return nullptr;
+    }
+    
+    vector<pair<string, string>> statements;
+    {
+        lock_guard<mutex> lock(poolMutex);
+        statements = preparedStatements;
+    }
+    for (const auto& statement : statements) {
+        PGresult* res = PQprepare(conn, statement.first.c_str(), statement.second.c_str(), 0, nullptr);
+        bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        PQclear(res);
+        if (!ok) {
+            cerr << "Ошибка подготовки запроса " << statement.first << ": " << PQerrorMessage(conn) << endl;
+            PQfinish(conn);
+            return nullptr;
+        }
+    }
+    return conn;
+}
+
+PooledConnection::PooledConnection(ConnectionPool& pool)
+    : pool(pool), conn(pool.acquire()) {}
+
+PooledConnection::~PooledConnection() {
+    pool.release(conn);
+}
+
+PGconn* PooledConnection::get() const {
+    return conn;
+}
+
+PooledConnection::operator bool() const {
+    return conn != nullptr;
+}
@@ -0,0 +1,65 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+typedef struct pg_conn PGconn;
+
+// Пул соединений libpq для потоковых операций (COPY) из нескольких потоков
+class ConnectionPool {
+public:
+    explicit ConnectionPool(const string& connStr, size_t maxSize = 8);
+    ~ConnectionPool();
+    
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+    
+    // Ждет свободное соединение; nullptr, если подключиться не удалось
+    PGconn* acquire();
+    void release(PGconn* conn);
+    
+    // Заранее открывает соединения, чтобы первый запрос не ждал подключения
+    size_t warmUp(size_t count);
+    // Оператор готовится на каждом новом соединении сразу после подключения;
+    // добавлять до первого acquire()
+    void addPreparedStatement(const string& name, const string& sql);
+    
+    size_t maxSize() const;
+    size_t idleCount() const;
+
+private:
+    string connectionString;
+    size_t maxConnections;
+    size_t openConnections;
+    vector<PGconn*> idle;
+    vector<pair<string, string>> preparedStatements;
+    mutable mutex poolMutex;
+    condition_variable released;
+    
+    PGconn* connectNew();
+};
+
+// Соединение из пула, возвращается при выходе из области видимости
+class PooledConnection {
+public:
+    explicit PooledConnection(ConnectionPool& pool);
+    ~PooledConnection();
+    
+    PooledConnection(const PooledConnection&) = delete;
+    PooledConnection& operator=(const PooledConnection&) = delete;
+    
+    PGconn* get() const;
+    explicit operator bool() const;
+
+private:
+    ConnectionPool& pool;
+    PGconn* conn;
+};
+
+#endif
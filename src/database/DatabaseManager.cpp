@@ -1,18 +1,551 @@
 #include "DatabaseManager.h"
 #include "config/Config.h"
 #include "../utils/HashUtils.h"
+#include "../utils/MappedFile.h"
+#include "../utils/DelimitedParser.h"
+#include "../utils/BufferedFileWriter.h"
+#include "../utils/ColumnarFormat.h"
+#include "../utils/ExportCheckpoint.h"
+#include "../utils/HouseFields.h"
+#include <libpq-fe.h>
 #include <fstream>
 #include <iostream>
-#include <iomanip>
-#include <sstream>
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <regex>
+#include <deque>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 using namespace std;
 
+namespace {
+
+// Размер части файла, которую разбирает один поток
+const size_t IMPORT_CHUNK_SIZE = 8 * 1024 * 1024;
+
+struct RejectedLine {
+    size_t line;        // номер строки внутри части
+    string reason;
+    string_view text;
+};
+
+// Результат разбора одной части файла
+struct ImportChunk {
+    vector<House> houses;
+    vector<size_t> houseLines;      // номер строки каждого дома внутри части
+    vector<RejectedLine> rejected;
+    size_t lineCount = 0;   // строк файла, а не записей
+};
+
+ImportChunk parseImportChunk(const char* begin, const char* end,
+                             const DelimitedParser& parser, const ImportLayout& layout) {
+    ImportChunk chunk;
+    chunk.houses.reserve((end - begin) / 48);
+    chunk.houseLines.reserve((end - begin) / 48);
+    
+    vector<DelimitedField> fields;
+    House house;
+    string error;
+    
+    const char* p = begin;
+    while (p < end) {
+        const char* lineEnd = parser.findRecordEnd(p, p, end);
+        string_view line(p, lineEnd - p);
+        // Номер первой строки файла, занятой записью; поле в кавычках может занимать несколько
+        size_t lineIndex = chunk.lineCount;
+        chunk.lineCount += 1 + count(line.begin(), line.end(), '\n');
+        p = lineEnd + 1;
+        
+        if (line.empty() || line == "\r") continue;
+        
+        if (!parser.splitLine(line, fields)) {
+            chunk.rejected.push_back({lineIndex, "некорректные кавычки", line});
+        } else if (!parser.parseHouse(fields, layout, house, error)) {
+            chunk.rejected.push_back({lineIndex, error, line});
+        } else {
+            chunk.houses.push_back(move(house));
+            chunk.houseLines.push_back(lineIndex);
+        }
+    }
+    return chunk;
+}
+
+// Пустая маска читает только id
+unsigned normalizedHouseFields(unsigned fields) {
+    fields &= HOUSE_FIELDS_ALL;
+    return fields ? fields : HOUSE_FIELD_ID;
+}
+
+// Список столбцов процедуры для маски полей, в порядке HouseFields::Stored
+string houseProjection(unsigned fields) {
+    fields = normalizedHouseFields(fields);
+    string columns;
+    HouseFields::Stored::forEach([&](auto field) {
+        typedef decltype(field) Field;
+        if (!(fields & Field::MASK)) return;
+        if (!columns.empty()) columns += ", ";
+        columns += Field::PROCEDURE_COLUMN;
+    });
+    return columns;
+}
+
+// Столбцы таблицы houses в порядке HouseFields::Stored; невыбранные поля
+// заменяются константой своего типа, чтобы не передавать их значения
+template <typename T> const char* emptySqlValue();
+template <> const char* emptySqlValue<int>() { return "0"; }
+template <> const char* emptySqlValue<string>() { return "''"; }
+template <> const char* emptySqlValue<Area>() { return "0::numeric"; }
+
+string houseColumns(unsigned fields = HOUSE_FIELDS_ALL) {
+    string columns;
+    HouseFields::Stored::forEach([&](auto field) {
+        typedef decltype(field) Field;
+        if (!columns.empty()) columns += ", ";
+        columns += (fields & Field::MASK) ? Field::SQL : emptySqlValue<typename Field::Type>();
+    });
+    return columns;
+}
+
+// Значение как текстовый параметр запроса
+string sqlText(int value) { return to_string(value); }
+string sqlText(Area value) { return value.toString(); }
+string sqlText(const string& value) { return value; }
+
+// Ключ сортировки страницы по столбцу модели (номер в HouseFields::Stored).
+// id не сортируется отдельно: он всегда последний ключ
+struct SortKeySql {
+    const char* expression = nullptr;
+    const char* cast = nullptr;
+    string value;
+};
+
+// value заполняется, если задана строка after
+bool sortKeySql(int column, const House* after, SortKeySql& key) {
+    if (column <= 0) return false;
+    return HouseFields::Stored::at(static_cast<size_t>(column), [&](auto field) {
+        typedef decltype(field) Field;
+        key.expression = Field::SORT_SQL;
+        key.cast = Field::SQL_CAST;
+        if (after) key.value = sqlText(after->*Field::MEMBER);
+    });
+}
+
+bool isSortKeyColumn(int column) {
+    return column > 0 && static_cast<size_t>(column) < HouseFields::Stored::COUNT;
+}
+
+// Экранирует % и _ для подстроки в ILIKE
+string likeContains(const string& text) {
+    string pattern = "%";
+    for (char c : text) {
+        if (c == '%' || c == '_' || c == '\\') pattern += '\\';
+        pattern += c;
+    }
+    return pattern + "%";
+}
+
+// SQL-выражение для поля экспорта; пустая строка для неизвестного поля
+string exportColumnExpression(const string& field) {
+    string expression;
+    HouseFields::Exported::find(field, [&expression](auto descriptor) {
+        expression = decltype(descriptor)::SQL;
+    });
+    return expression;
+}
+
+// Список столбцов с псевдонимами, которые дают имена столбцов заголовка
+string buildExportColumns(const vector<string>& fields) {
+    string columns;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        string expression = exportColumnExpression(fields[i]);
+        if (expression.empty()) return "";
+        
+        if (i > 0) columns += ", ";
+        columns += expression + " AS \"" + fields[i] + "\"";
+    }
+    return columns;
+}
+
+string buildExportSelect(const vector<string>& fields) {
+    string columns = buildExportColumns(fields);
+    return columns.empty() ? "" : "SELECT " + columns + " FROM houses";
+}
+
+// Строк между контрольными точками возобновляемого экспорта
+const long long EXPORT_CHECKPOINT_ROWS = 100000;
+
+// Параметры, при которых сохраненную контрольную точку можно продолжить
+string exportSignature(const vector<string>& fields, const string& delimiter, bool includeHeader) {
+    string signature = "fields=";
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (i > 0) signature += ",";
+        signature += fields[i];
+    }
+    signature += ";delimiter=" + (delimiter == "\t" ? string("tab") : delimiter);
+    signature += string(";header=") + (includeHeader ? "1" : "0");
+    return signature;
+}
+
+string copyOptions(const string& delimiter, bool includeHeader) {
+    string literal;
+    if (delimiter == "\t") literal = "E'\\t'";
+    else literal = "'" + delimiter + "'";
+    
+    return string(" WITH (FORMAT csv, DELIMITER ") + literal +
+           ", HEADER " + (includeHeader ? "true" : "false") + ")";
+}
+
+// Метка изменений не позже начала самой старой активной транзакции: ее изменения
+// получат updated_at раньше нашего now() и иначе были бы пропущены.
+// Граничные строки могут выгрузиться повторно, но не потеряться.
+// Второй столбец - есть ли сессии, чье начало транзакции скрыто от этой роли
+const char* NEXT_WATERMARK_SQL =
+    "SELECT LEAST(now(), COALESCE((SELECT MIN(xact_start) FROM pg_stat_activity "
+    "WHERE xact_start IS NOT NULL AND pid <> pg_backend_pid() "
+    "AND datname = current_database()), now()))::timestamptz::text, "
+    "EXISTS (SELECT 1 FROM pg_stat_activity WHERE pid <> pg_backend_pid() "
+    "AND datname = current_database() AND backend_type = 'client backend' AND state IS NULL)::text";
+
+// Выполняет команду без результата на соединении libpq
+bool execCommand(PGconn* pg, const string& sql) {
+    PGresult* res = PQexec(pg, sql.c_str());
+    bool ok = PQresultStatus(res) == PGRES_COMMAND_OK || PQresultStatus(res) == PGRES_TUPLES_OK;
+    if (!ok) {
+        cerr << "Ошибка выполнения запроса: " << PQerrorMessage(pg) << endl;
+    }
+    PQclear(res);
+    return ok;
+}
+
+// Значение первого столбца единственной строки результата
+bool queryValue(PGconn* pg, const string& sql, string& value) {
+    PGresult* res = PQexec(pg, sql.c_str());
+    bool ok = PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1 && !PQgetisnull(res, 0, 0);
+    if (ok) {
+        value = PQgetvalue(res, 0, 0);
+    } else if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        cerr << "Ошибка выполнения запроса: " << PQerrorMessage(pg) << endl;
+    }
+    PQclear(res);
+    return ok;
+}
+
+// Начало чужих транзакций в pg_stat_activity видят только суперпользователь и
+// члены pg_read_all_stats (setup_database.sql выдает роль housing_user). Если
+// часть сессий скрыта, метка не сдвигается дальше fallback: изменения
+// повторяются при следующей выгрузке, но не теряются
+bool nextWatermark(PGconn* pg, const string& fallback, string& watermark) {
+    PGresult* res = PQexec(pg, NEXT_WATERMARK_SQL);
+    bool ok = PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1 && PQnfields(res) == 2;
+    if (!ok) {
+        cerr << "Ошибка выполнения запроса: " << PQerrorMessage(pg) << endl;
+    } else if (string(PQgetvalue(res, 0, 1)) == "true") {
+        cerr << "Ошибка метки изменений: транзакции других сессий не видны, "
+                "роли нужна pg_read_all_stats" << endl;
+        watermark = fallback;
+    } else {
+        watermark = PQgetvalue(res, 0, 0);
+    }
+    PQclear(res);
+    return ok;
+}
+
+string escapeLiteral(PGconn* pg, const string& value) {
+    char* escaped = PQescapeLiteral(pg, value.c_str(), value.size());
+    if (!escaped) return "NULL";
+    string result(escaped);
+    PQfreemem(escaped);
+    return result;
+}
+
+// Передает вывод COPY ... TO STDOUT в sink(data, size) без промежуточного
+// хранения строк; sink возвращает false при ошибке записи
+template <typename Sink>
+bool copyOut(PGconn* pg, const string& copySql, Sink&& sink, uint64_t* rowCount) {
+    PGresult* res = PQexec(pg, copySql.c_str());
+    if (PQresultStatus(res) != PGRES_COPY_OUT) {
+        cerr << "Ошибка запуска COPY: " << PQerrorMessage(pg) << endl;
+        PQclear(res);
+        return false;
+    }
+    PQclear(res);
+    
+    bool ok = true;
+    char* buffer = nullptr;
+    int length;
+    while ((length = PQgetCopyData(pg, &buffer, 0)) > 0) {
+        // После ошибки записи дочитываем поток, чтобы соединение осталось рабочим
+        if (ok) ok = sink(buffer, static_cast<size_t>(length));
+        PQfreemem(buffer);
+    }
+    if (length == -2) ok = false;
+    
+    while ((res = PQgetResult(pg)) != nullptr) {
+        if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+            cerr << "Ошибка COPY: " << PQresultErrorMessage(res) << endl;
+            ok = false;
+        } else if (rowCount) {
+            *rowCount = strtoull(PQcmdTuples(res), nullptr, 10);
+        }
+        PQclear(res);
+    }
+    return ok;
+}
+
+// Значение в текстовом формате COPY: обратная косая черта и управляющие
+// символы экранируются, разделитель - табуляция
+void appendCopyText(string_view value, string& out) {
+    for (char c : value) {
+        switch (c) {
+        case '\\': out += "\\\\"; break;
+        case '\t': out += "\\t"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        default: out += c;
+        }
+    }
+}
+
+// Строки импорта: номер строки файла и поля дома в порядке столбцов import_staging
+void appendStagingRow(size_t line, const House& house, string& out) {
+    out += to_string(line);
+    out += '\t';
+    appendCopyText(house.address, out);
+    out += '\t';
+    out += to_string(house.apartments);
+    out += '\t';
+    house.totalArea.appendTo(out);
+    out += '\t';
+    out += to_string(house.buildYear);
+    out += '\t';
+    out += to_string(house.floors);
+    out += '\n';
+}
+
+// Целые двоичного формата PostgreSQL - big-endian
+uint16_t readUint16(const char* data) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+}
+
+int32_t readInt32(const char* data) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<int32_t>((uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) |
+                                (uint32_t(bytes[2]) << 8) | uint32_t(bytes[3]));
+}
+
+// NUMERIC в двоичном формате: ndigits, weight, sign, dscale (int16), затем
+// ndigits цифр по основанию 10000; цифра i имеет вес 10000^(weight - i).
+// Знаки дробной части после второго (их нет у DECIMAL(10,2)) отбрасываются
+bool decodeNumeric(const char* data, int length, Area& area) {
+    if (length < 8) return false;
+    int digitCount = readUint16(data);
+    int weight = static_cast<int16_t>(readUint16(data + 2));
+    uint16_t sign = readUint16(data + 4);
+    if (sign == 0xC000 || length < 8 + 2 * digitCount) return false;  // NaN
+
+    auto digit = [data, digitCount](int index) -> int64_t {
+        return index >= 0 && index < digitCount ? readUint16(data + 8 + 2 * index) : 0;
+    };
+    int64_t value = 0;
+    for (int position = weight; position >= 0; --position) {
+        value = value * 10000 + digit(weight - position);
+    }
+    value = value * 100 + digit(weight + 1) / 100;
+    area.hundredths = sign == 0x4000 ? -value : value;
+    return true;
+}
+
+// Значение столбца двоичного результата по типу поля
+void decodeBinary(const char* data, int, int& value) {
+    value = readInt32(data);
+}
+
+void decodeBinary(const char* data, int length, string& value) {
+    value.assign(data, length);
+}
+
+void decodeBinary(const char* data, int length, Area& value) {
+    decodeNumeric(data, length, value);
+}
+
+// Строка страницы домов: столбцы идут в порядке HouseFields::Stored
+void decodeHouseRow(const PGresult* res, int row, House& house) {
+    int column = 0;
+    HouseFields::Stored::forEach([&](auto field) {
+        typedef decltype(field) Field;
+        decodeBinary(PQgetvalue(res, row, column), PQgetlength(res, row, column), house.*Field::MEMBER);
+        ++column;
+    });
+}
+
+// Все строки двоичного результата в таблицу
+void appendHouseRows(const PGresult* res, HouseTable& houses) {
+    int rows = PQntuples(res);
+    size_t addressBytes = 0;
+    for (int row = 0; row < rows; ++row) {
+        addressBytes += PQgetlength(res, row, 1);
+    }
+    houses.reserve(houses.size() + rows, houses.addressBytes() + addressBytes);
+    
+    // Один House на результат: буфер адреса переиспользуется
+    House house;
+    for (int row = 0; row < rows; ++row) {
+        decodeHouseRow(res, row, house);
+        houses.append(house);
+    }
+}
+
+// Значение столбца текстового результата pqxx по типу поля
+void decodeText(const pqxx::field& field, int& value) {
+    value = field.as<int>();
+}
+
+void decodeText(const pqxx::field& field, string& value) {
+    string_view text = field.view();
+    value.assign(text.data(), text.size());
+}
+
+void decodeText(const pqxx::field& field, Area& value) {
+    Area::parse(field.view(), value);
+}
+
+// Вся таблица по id страницами: начальная загрузка снимка. Готовится на
+// каждом соединении пула при подключении, чтобы не разбирать запрос заново
+const char* HOUSE_PAGE_BY_ID = "house_page_by_id";
+
+string housePageByIdSql() {
+    return "SELECT " + houseColumns() + " FROM houses WHERE id > $1::int ORDER BY id LIMIT $2::bigint";
+}
+
+// Выполняет запрос страницы (statement - имя подготовленного оператора или
+// nullptr для sql) с результатом в двоичном формате
+PGresult* runHousePage(PGconn* pg, const char* statement, const string& sql, const vector<string>& params,
+                       QueryCanceler* canceler) {
+    vector<const char*> values;
+    for (const auto& value : params) {
+        values.push_back(value.c_str());
+    }
+    
+    if (canceler && !canceler->attach(pg)) return nullptr;
+    PGresult* res = statement
+        ? PQexecPrepared(pg, statement, static_cast<int>(values.size()), values.data(), nullptr, nullptr, 1)
+        : PQexecParams(pg, sql.c_str(), static_cast<int>(values.size()), nullptr,
+                       values.data(), nullptr, nullptr, 1);
+    if (canceler) canceler->detach();
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        // Отмененный запрос - не ошибка
+        if (!canceler || !canceler->isCanceled()) {
+            cerr << "Ошибка получения страницы домов: " << PQerrorMessage(pg) << endl;
+        }
+        PQclear(res);
+        return nullptr;
+    }
+    return res;
+}
+
+// Запрос страницы домов со всеми хранимыми полями (порядок HouseFields::Stored).
+// Результат в двоичном формате: числа без разбора текста, площадь - точно.
+// nullptr при ошибке или отмене
+PGresult* execHousePage(PGconn* pg, const HouseQuery& query, const House* after, size_t limit,
+                        QueryCanceler* canceler) {
+    vector<string> params;
+    auto param = [&params](const string& value, const char* cast) {
+        params.push_back(value);
+        return "$" + to_string(params.size()) + cast;
+    };
+    
+    vector<string> conditions;
+    if (query.filtered) {
+        conditions.push_back("build_year BETWEEN " + param(to_string(query.minYear), "::int") +
+                             " AND " + param(to_string(query.maxYear), "::int"));
+        conditions.push_back("apartments BETWEEN " + param(to_string(query.minApartments), "::int") +
+                             " AND " + param(to_string(query.maxApartments), "::int"));
+        conditions.push_back("total_area BETWEEN " + param(query.minArea.toString(), "::numeric") +
+                             " AND " + param(query.maxArea.toString(), "::numeric"));
+        conditions.push_back("floors BETWEEN " + param(to_string(query.minFloors), "::int") +
+                             " AND " + param(to_string(query.maxFloors), "::int"));
+    }
+    if (!query.addressPattern.empty()) {
+        conditions.push_back("address ILIKE " + param(likeContains(query.addressPattern), "::text"));
+    }
+    
+    // Ключи сортировки и id как последний ключ: порядок строк полностью определен
+    vector<HouseSortKey> keys;
+    for (const auto& key : query.sortKeys) {
+        if (isSortKeyColumn(key.column)) keys.push_back(key);
+    }
+    
+    // Без фильтров и сортировки: подготовленный оператор (id начинаются с 1)
+    if (!query.filtered && query.addressPattern.empty() && keys.empty() && limit > 0) {
+        vector<string> pageParams = {to_string(after ? after->id : 0), to_string(limit)};
+        return runHousePage(pg, HOUSE_PAGE_BY_ID, "", pageParams, canceler);
+    }
+    
+    // Выражение, приведение и значение каждого ключа выбираются один раз
+    vector<SortKeySql> keySql(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        sortKeySql(keys[i].column, after, keySql[i]);
+    }
+    
+    string orderBy;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        orderBy += string(keySql[i].expression) + (keys[i].ascending ? " ASC, " : " DESC, ");
+    }
+    orderBy += "id ASC";
+    
+    if (after) {
+        bool allAscending = all_of(keys.begin(), keys.end(),
+                                   [](const HouseSortKey& key) { return key.ascending; });
+        if (allAscending) {
+            // Сравнение кортежей использует составной индекс
+            string left, right;
+            for (const auto& key : keySql) {
+                left += string(key.expression) + ", ";
+                right += param(key.value, key.cast) + ", ";
+            }
+            conditions.push_back("(" + left + "id) > (" + right + param(to_string(after->id), "::int") + ")");
+        } else {
+            // Разные направления: (k1 > v1) OR (k1 = v1 AND k2 < v2) OR ...
+            string keyset;
+            string equalPrefix;
+            for (size_t i = 0; i <= keys.size(); ++i) {
+                bool isId = i == keys.size();
+                string expression = isId ? "id" : keySql[i].expression;
+                string value = isId ? param(to_string(after->id), "::int")
+                                    : param(keySql[i].value, keySql[i].cast);
+                bool ascending = isId || keys[i].ascending;
+                
+                if (!keyset.empty()) keyset += " OR ";
+                keyset += "(" + equalPrefix + expression + (ascending ? " > " : " < ") + value + ")";
+                equalPrefix += expression + " = " + value + " AND ";
+            }
+            conditions.push_back("(" + keyset + ")");
+        }
+    }
+    
+    string sql = "SELECT " + houseColumns() + " FROM houses";
+    for (size_t i = 0; i < conditions.size(); ++i) {
+        sql += (i == 0 ? " WHERE " : " AND ") + conditions[i];
+    }
+    sql += " ORDER BY " + orderBy;
+    if (limit > 0) sql += " LIMIT " + to_string(limit);
+    
+    return runHousePage(pg, nullptr, sql, params, canceler);
+}
+
+}
+
 DatabaseManager::DatabaseManager(const string& connStr) 
-    : connectionString(connStr), conn(nullptr) {}
+    : connectionString(connStr), conn(nullptr), copyPool(connStr), addressFilterReady(false) {
+    copyPool.addPreparedStatement(HOUSE_PAGE_BY_ID, housePageByIdSql());
+}
 
 DatabaseManager::~DatabaseManager() {
     disconnect();
@@ -21,7 +554,11 @@ DatabaseManager::~DatabaseManager() {
 bool DatabaseManager::connect() {
     try {
         conn = new pqxx::connection(connectionString);
-        return conn->is_open();
+        if (!conn->is_open()) return false;
+        
+        // Фильтр адресов загружается отдельно (loadAddressFilter), пока он
+        // не готов, проверки идут на сервер
+        return true;
     } catch (const exception& e) {
         cerr << "Ошибка подключения к БД: " << e.what() << endl;
         return false;
@@ -39,8 +576,12 @@ bool DatabaseManager::isConnected() const {
     return conn && conn->is_open();
 }
 
+size_t DatabaseManager::warmUp(size_t connections) {
+    return copyPool.warmUp(connections);
+}
+
 // ДОМА 
-bool DatabaseManager::addHouse(const House& house) {
+bool DatabaseManager::addHouse(House& house) {
     if (!isConnected() || !house.isValid()) return false;
     
     try {
@@ -49,7 +590,7 @@ bool DatabaseManager::addHouse(const House& house) {
             "SELECT add_house($1, $2, $3, $4, $5)",
             house.address, 
             house.apartments, 
-            house.totalArea, 
+            house.totalArea.toString(), 
             house.buildYear, 
             house.floors
         );
@@ -58,6 +599,10 @@ bool DatabaseManager::addHouse(const House& house) {
         
         if (!res.empty()) {
             int result = res[0][0].as<int>();
+            if (result > 0) {
+                house.id = result;
+                rememberAddress(house.address);
+            }
             return result > 0;
         }
         return false;
@@ -77,13 +622,18 @@ bool DatabaseManager::updateHouse(const House& house) {
             house.id,
             house.address, 
             house.apartments, 
-            house.totalArea, 
+            house.totalArea.toString(), 
             house.buildYear, 
             house.floors
         );
         
         txn.commit();
-        return !res.empty() && res[0][0].as<bool>();
+        
+        bool updated = !res.empty() && res[0][0].as<bool>();
+        if (updated) {
+            rememberAddress(house.address);
+        }
+        return updated;
     } catch (const exception& e) {
         cerr << "Ошибка обновления дома: " << e.what() << endl;
         return false;
@@ -108,17 +658,15 @@ bool DatabaseManager::deleteHouse(int id) {
     }
 }
 
-vector<House> DatabaseManager::getAllHouses() {
-    vector<House> houses;
+HouseTable DatabaseManager::getAllHouses(unsigned fields) {
+    HouseTable houses;
     if (!isConnected()) return houses;
     
     try {
         pqxx::nontransaction ntx(*conn);
-        pqxx::result res = ntx.exec("SELECT * FROM get_all_houses()");
+        pqxx::result res = ntx.exec("SELECT " + houseProjection(fields) + " FROM get_all_houses()");
         
-        for (const auto& row : res) {
-            houses.push_back(rowToHouseFromProcedure(row));
-        }
+        appendHouses(res, fields, houses);
     } catch (const exception& e) {
         cerr << "Ошибка получения списка домов: " << e.what() << endl;
     }
@@ -161,14 +709,14 @@ bool DatabaseManager::deleteHousesByApartments(int minApartments, int maxApartme
     }
 }
 
-bool DatabaseManager::deleteHousesByArea(double minArea, double maxArea) {
-    if (!isConnected() || minArea < 0 || maxArea < minArea) return false;
+bool DatabaseManager::deleteHousesByArea(Area minArea, Area maxArea) {
+    if (!isConnected() || minArea < Area() || maxArea < minArea) return false;
     
     try {
         pqxx::work txn(*conn);
         pqxx::result res = txn.exec_params(
             "SELECT delete_houses_by_area($1, $2)",
-            minArea, maxArea
+            minArea.toString(), maxArea.toString()
         );
         
         txn.commit();
@@ -197,76 +745,200 @@ bool DatabaseManager::deleteHousesByAddress(const string& addressPattern) {
     }
 }
 
-vector<House> DatabaseManager::getHousesOlderThan(int years) {
-    vector<House> houses;
+HouseTable DatabaseManager::getHousesOlderThan(int years, unsigned fields) {
+    HouseTable houses;
     if (!isConnected()) return houses;
     
     try {
         pqxx::nontransaction ntx(*conn);
         pqxx::result res = ntx.exec_params(
-            "SELECT * FROM get_houses_older_than($1)",
+            "SELECT " + houseProjection(fields) + " FROM get_houses_older_than($1)",
             years
         );
         
-        for (const auto& row : res) {
-            House house;
-            house.id = row["house_id"].as<int>();
-            house.address = row["house_address"].as<string>();
-            house.apartments = row["house_apartments"].as<int>();
-            house.totalArea = row["house_total_area"].as<double>();
-            house.buildYear = row["house_build_year"].as<int>();
-            house.floors = row["house_floors"].as<int>();
-            houses.push_back(house);
-        }
+        appendHouses(res, fields, houses);
     } catch (const exception& e) {
         cerr << "Ошибка получения старых домов: " << e.what() << endl;
     }
     return houses;
 }
 
-vector<House> DatabaseManager::getHousesByYear(int year) {
-    vector<House> houses;
+HouseTable DatabaseManager::getHousesByYear(int year, unsigned fields) {
+    HouseTable houses;
     if (!isConnected()) return houses;
     
     try {
         pqxx::nontransaction ntx(*conn);
         pqxx::result res = ntx.exec_params(
-            "SELECT * FROM get_houses_by_year($1)",
+            "SELECT " + houseProjection(fields) + " FROM get_houses_by_year($1)",
             year
         );
         
-        for (const auto& row : res) {
-            houses.push_back(rowToHouseFromProcedure(row));
-        }
+        appendHouses(res, fields, houses);
     } catch (const exception& e) {
         cerr << "Ошибка получения домов по году: " << e.what() << endl;
     }
     return houses;
 }
 
-vector<House> DatabaseManager::searchHouses(const string& query) {
-    vector<House> houses;
+HouseTable DatabaseManager::searchHouses(const string& query, unsigned fields) {
+    HouseTable houses;
     if (!isConnected() || query.empty()) return houses;
     
     try {
         pqxx::nontransaction ntx(*conn);
         pqxx::result res = ntx.exec_params(
-            "SELECT * FROM search_houses($1)",
+            "SELECT " + houseProjection(fields) + " FROM search_houses($1)",
             query
         );
         
-        for (const auto& row : res) {
-            houses.push_back(rowToHouseFromProcedure(row));
-        }
+        appendHouses(res, fields, houses);
     } catch (const exception& e) {
         cerr << "Ошибка поиска домов: " << e.what() << endl;
     }
     return houses;
 }
 
+bool DatabaseManager::fetchHousePage(const HouseQuery& query, const House* after, size_t limit,
+                                     vector<House>& houses, QueryCanceler* canceler) {
+    houses.clear();
+    
+    PooledConnection pg(copyPool);
+    if (!pg) return false;
+    PGresult* res = execHousePage(pg.get(), query, after, limit, canceler);
+    if (!res) return false;
+    
+    int rows = PQntuples(res);
+    houses.resize(rows);
+    for (int row = 0; row < rows; ++row) {
+        decodeHouseRow(res, row, houses[row]);
+    }
+    PQclear(res);
+    return true;
+}
+
+bool DatabaseManager::fetchHousePage(const HouseQuery& query, const House* after, size_t limit,
+                                     HouseTable& houses, QueryCanceler* canceler) {
+    houses.clear();
+    
+    PooledConnection pg(copyPool);
+    if (!pg) return false;
+    PGresult* res = execHousePage(pg.get(), query, after, limit, canceler);
+    if (!res) return false;
+    
+    appendHouseRows(res, houses);
+    PQclear(res);
+    return true;
+}
+
+long long DatabaseManager::estimateHouseCount() {
+    PooledConnection pg(copyPool);
+    if (!pg) return -1;
+    
+    string value;
+    if (!queryValue(pg.get(), "SELECT GREATEST(reltuples, 0)::bigint FROM pg_class "
+                              "WHERE oid = 'houses'::regclass", value)) {
+        return -1;
+    }
+    return atoll(value.c_str());
+}
+
+bool DatabaseManager::currentHouseWatermark(string& watermark) {
+    PooledConnection pg(copyPool);
+    // Без видимости чужих транзакций следующая синхронизация перечитает все дома
+    return pg && nextWatermark(pg.get(), "-infinity", watermark);
+}
+
+bool DatabaseManager::fetchHouseChanges(const string& since, HouseChanges& changes, QueryCanceler* canceler) {
+    changes = HouseChanges();
+    
+    PooledConnection connection(copyPool);
+    if (!connection) return false;
+    PGconn* pg = connection.get();
+    
+    // Изменения, удаления и новая метка берутся по одному снимку базы
+    if (!execCommand(pg, "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY")) return false;
+    
+    // Экспорт удаляет записи об удалениях старше самой ранней своей метки;
+    // если метка снимка раньше, часть удалений могла пропасть. Метка из
+    // будущего (подмененный или чужой снимок) тоже требует полной загрузки
+    string sinceSql = escapeLiteral(pg, since) + "::timestamptz";
+    string complete;
+    bool ok = queryValue(pg,
+        "SELECT (COALESCE((SELECT MIN(exported_until) FROM export_watermarks) <= " + sinceSql + ", true) "
+        "AND " + sinceSql + " <= now())::text", complete) &&
+        nextWatermark(pg, since, changes.watermark);
+    changes.complete = ok && complete == "true";
+    
+    if (changes.complete) {
+        vector<string> params = {since};
+        PGresult* res = runHousePage(pg, nullptr,
+            "SELECT " + houseColumns() + " FROM houses WHERE updated_at >= $1::timestamptz ORDER BY id",
+            params, canceler);
+        ok = res != nullptr;
+        if (res) {
+            appendHouseRows(res, changes.changed);
+            PQclear(res);
+        }
+        
+        // Удаленные после метки и не добавленные снова
+        res = ok ? runHousePage(pg, nullptr,
+            "SELECT DISTINCT house_id FROM house_tombstones t WHERE deleted_at >= $1::timestamptz "
+            "AND NOT EXISTS (SELECT 1 FROM houses h WHERE h.id = t.house_id) ORDER BY house_id",
+            params, canceler) : nullptr;
+        ok = res != nullptr;
+        if (res) {
+            int rows = PQntuples(res);
+            changes.removedIds.reserve(rows);
+            for (int row = 0; row < rows; ++row) {
+                changes.removedIds.push_back(readInt32(PQgetvalue(res, row, 0)));
+            }
+            PQclear(res);
+        }
+    }
+    
+    execCommand(pg, ok ? "COMMIT" : "ROLLBACK");
+    return ok;
+}
+
+string DatabaseManager::databaseIdentity() {
+    PooledConnection pg(copyPool);
+    if (!pg) return string();
+    
+    // Пересозданные база или таблица получают новый oid: прежний снимок к ним не относится
+    string identity;
+    if (!queryValue(pg.get(),
+        "SELECT current_database() || '/' || (SELECT oid FROM pg_database WHERE datname = current_database()) || "
+        "'/' || 'houses'::regclass::oid || '@' || COALESCE(host(inet_server_addr()), 'local') || ':' || "
+        "current_setting('port')", identity)) {
+        return string();
+    }
+    return identity;
+}
+
+bool DatabaseManager::holdTombstones(const string& consumer, const string& watermark) {
+    PooledConnection connection(copyPool);
+    if (!connection) return false;
+    PGconn* pg = connection.get();
+    
+    return execCommand(pg,
+        "INSERT INTO export_watermarks (name, exported_until) VALUES (" + escapeLiteral(pg, consumer) + ", " +
+        escapeLiteral(pg, watermark) + "::timestamptz) "
+        "ON CONFLICT (name) DO UPDATE SET exported_until = EXCLUDED.exported_until");
+}
+
+bool DatabaseManager::releaseTombstones(const string& consumer) {
+    PooledConnection connection(copyPool);
+    if (!connection) return false;
+    PGconn* pg = connection.get();
+    
+    return execCommand(pg, "DELETE FROM export_watermarks WHERE name = " + escapeLiteral(pg, consumer));
+}
+
 // ПРОВЕРКА ДУБЛИКАТОВ 
 bool DatabaseManager::houseExists(const House& house) {
     if (!isConnected() || house.address.empty()) return false;
+    if (!addressMightExist(house.address)) return false;
     
     try {
         pqxx::nontransaction ntx(*conn);
@@ -275,7 +947,11 @@ bool DatabaseManager::houseExists(const House& house) {
             house.address
         );
         
-        return !res.empty() && res[0][0].as<bool>();
+        bool exists = !res.empty() && res[0][0].as<bool>();
+        if (!exists) {
+            countAddressFalsePositive();
+        }
+        return exists;
     } catch (const exception& e) {
         cerr << "Ошибка проверки существования дома: " << e.what() << endl;
         return false;
@@ -284,16 +960,23 @@ bool DatabaseManager::houseExists(const House& house) {
 
 bool DatabaseManager::houseExistsWithDifferentId(const House& house) {
     if (!isConnected() || house.address.empty() || house.id <= 0) return false;
+    if (!addressMightExist(house.address)) return false;
     
     try {
         pqxx::nontransaction ntx(*conn);
+        // Адрес самого дома фильтр тоже помнит, поэтому ложным срабатыванием
+        // считается только адрес, которого на сервере нет вовсе
         pqxx::result res = ntx.exec_params(
-            "SELECT house_exists_except_id($1, $2)",
+            "SELECT house_exists_except_id($1, $2), house_exists($1)",
             house.address,
             house.id
         );
         
-        return !res.empty() && res[0][0].as<bool>();
+        if (res.empty()) return false;
+        if (!res[0][1].as<bool>()) {
+            countAddressFalsePositive();
+        }
+        return res[0][0].as<bool>();
     } catch (const exception& e) {
         cerr << "Ошибка проверки дома с другим ID: " << e.what() << endl;
         return false;
@@ -317,7 +1000,7 @@ bool DatabaseManager::findSimilarHouses(const House& house, vector<House>& simil
             similarHouse.id = row["house_id"].as<int>();
             similarHouse.address = row["house_address"].as<string>();
             similarHouse.apartments = row["house_apartments"].as<int>();
-            similarHouse.totalArea = row["house_total_area"].as<double>();
+            Area::parse(row["house_total_area"].view(), similarHouse.totalArea);
             similarHouse.buildYear = row["house_build_year"].as<int>();
             similarHouse.floors = row["house_floors"].as<int>();
             similarHouses.push_back(similarHouse);
@@ -330,6 +1013,101 @@ bool DatabaseManager::findSimilarHouses(const House& house, vector<House>& simil
     }
 }
 
+// ФИЛЬТР АДРЕСОВ
+bool DatabaseManager::loadAddressFilter(QueryCanceler* canceler) {
+    {
+        lock_guard<mutex> lock(addressFilterMutex);
+        addressFilterReady = false;
+        addressFilterStats = AddressFilterStats();
+    }
+    
+    // Соединение пула, а не основное: загрузка может идти из рабочего потока,
+    // пока окно пользуется основным соединением
+    PooledConnection connection(copyPool);
+    if (!connection) return false;
+    PGconn* pg = connection.get();
+    
+    // Строки приходят по одной, весь результат в памяти не собирается.
+    // Сначала собираем только 64-битные хеши, чтобы размер фильтра
+    // определялся без отдельного запроса COUNT(*)
+    if (canceler && !canceler->attach(pg)) return false;
+    if (!PQsendQuery(pg, "SELECT house_address FROM get_house_addresses()") || !PQsetSingleRowMode(pg)) {
+        if (canceler) canceler->detach();
+        cerr << "Ошибка загрузки фильтра адресов: " << PQerrorMessage(pg) << endl;
+        while (PGresult* res = PQgetResult(pg)) PQclear(res);
+        return false;
+    }
+    
+    vector<uint64_t> hashes;
+    bool ok = true;
+    while (PGresult* res = PQgetResult(pg)) {
+        ExecStatusType status = PQresultStatus(res);
+        if (status == PGRES_SINGLE_TUPLE) {
+            hashes.push_back(BloomFilter::hashKey(normalizeAddress(string(PQgetvalue(res, 0, 0),
+                                                                          PQgetlength(res, 0, 0)))));
+        } else if (status != PGRES_TUPLES_OK) {
+            ok = false;
+        }
+        PQclear(res);
+    }
+    if (canceler) canceler->detach();
+    if (!ok) {
+        // Отмененная загрузка - не ошибка
+        if (!canceler || !canceler->isCanceled()) {
+            cerr << "Ошибка загрузки фильтра адресов: " << PQerrorMessage(pg) << endl;
+        }
+        return false;
+    }
+    
+    BloomFilter filter;
+    filter.reset(hashes.size() * 2);
+    for (uint64_t hash : hashes) {
+        filter.addHash(hash);
+    }
+    
+    lock_guard<mutex> lock(addressFilterMutex);
+    addressFilter = move(filter);
+    addressFilterReady = true;
+    return true;
+}
+
+AddressFilterStats DatabaseManager::getAddressFilterStats() const {
+    lock_guard<mutex> lock(addressFilterMutex);
+    AddressFilterStats stats = addressFilterStats;
+    stats.items = addressFilter.itemCount();
+    stats.memoryBytes = addressFilter.memoryBytes();
+    stats.estimatedFalsePositiveRate = addressFilter.estimatedFalsePositiveRate();
+    return stats;
+}
+
+bool DatabaseManager::addressMightExist(const string& address) {
+    string key = normalizeAddress(address);
+    lock_guard<mutex> lock(addressFilterMutex);
+    if (!addressFilterReady) return true;
+    
+    addressFilterStats.lookups++;
+    if (!addressFilter.mightContain(key)) {
+        addressFilterStats.skippedQueries++;
+        return false;
+    }
+    return true;
+}
+
+void DatabaseManager::rememberAddress(const string& address) {
+    string key = normalizeAddress(address);
+    lock_guard<mutex> lock(addressFilterMutex);
+    if (addressFilterReady) {
+        addressFilter.add(key);
+    }
+}
+
+void DatabaseManager::countAddressFalsePositive() {
+    lock_guard<mutex> lock(addressFilterMutex);
+    if (addressFilterReady) {
+        addressFilterStats.falsePositives++;
+    }
+}
+
 // ПОЛЬЗОВАТЕЛИ 
 bool DatabaseManager::addUser(const User& user) {
     if (!isConnected() || !user.isValid()) return false;
@@ -438,43 +1216,551 @@ bool DatabaseManager::authenticateUser(const string& login, const string& passwo
 bool DatabaseManager::exportToFile(const string& filename, 
                                   const vector<string>& fields,
                                   const string& delimiter,
-                                  bool includeHeader) {
+                                  bool includeHeader,
+                                  int compressionLevel,
+                                  bool* resumed) {
+    if (resumed) *resumed = false;
     if (!isConnected() || fields.empty()) return false;
+    if (delimiter != "\t" && delimiter != ";" && delimiter != ",") return false;
     
-    auto houses = getAllHouses();
-    if (houses.empty()) return false;
+    // Возраст и проекция полей вычисляются на сервере, строки идут
+    // из COPY прямо в буфер записи, память не зависит от размера фонда
+    string select = buildExportSelect(fields);
+    if (select.empty()) return false;
     
-    ofstream file(filename);
-    if (!file.is_open()) return false;
+    PooledConnection pg(copyPool);
+    if (!pg) return false;
     
-    // Заголовок
-    if (includeHeader) {
-        for (size_t i = 0; i < fields.size(); ++i) {
-            file << fields[i];
-            if (i < fields.size() - 1) file << delimiter;
+    // До завершения данные лежат в <файл>.part, по целевому пути
+    // появляется только полностью записанный файл
+    string partFile = ExportCheckpoint::partPath(filename);
+    BufferedFileWriter writer;
+    auto sink = [&writer](const char* data, size_t size) { return writer.write(data, size); };
+    
+    // Сжатый поток нельзя продолжить с произвольного смещения,
+    // поэтому такой экспорт идет без контрольных точек
+    if (compressionLevel > 0) {
+        string copySql = "COPY (" + select + " ORDER BY id) TO STDOUT" + copyOptions(delimiter, includeHeader);
+        uint64_t rowCount = 0;
+        bool ok = writer.open(partFile, compressionLevel) && copyOut(pg.get(), copySql, sink, &rowCount);
+        ok = writer.close() && ok;
+        if (!ok || rowCount == 0) {
+            remove(partFile.c_str());
+            return false;
         }
-        file << "\n";
+        return ExportCheckpoint::commit(filename);
+    }
+    
+    ExportCheckpoint checkpoint;
+    string signature = exportSignature(fields, delimiter, includeHeader);
+    bool resume = ExportCheckpoint::load(filename, checkpoint) &&
+                  checkpoint.signature == signature &&
+                  writer.openAt(partFile, checkpoint.byteOffset);
+    if (!resume) {
+        ExportCheckpoint::remove(filename);
+        checkpoint = ExportCheckpoint();
+        checkpoint.signature = signature;
+        if (!writer.open(partFile)) return false;
+    }
+    if (resumed) *resumed = resume;
+    
+    // Без сбоев все порции читаются по одному снимку; после возобновления
+    // продолжается тот же порядок по id со строки, следующей за lastId
+    bool ok = execCommand(pg.get(), "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY");
+    bool first = !resume;
+    while (ok) {
+        string after = first ? "" : "id > " + to_string(checkpoint.lastId);
+        string upperBound;
+        ok = queryValue(pg.get(),
+            "SELECT COALESCE(MAX(id)::text, '') FROM (SELECT id FROM houses" +
+            (after.empty() ? "" : " WHERE " + after) +
+            " ORDER BY id LIMIT " + to_string(EXPORT_CHECKPOINT_ROWS) + ") AS part", upperBound);
+        if (!ok || upperBound.empty()) break;
+        
+        string copySql = "COPY (" + select + " WHERE " + (after.empty() ? "" : after + " AND ") +
+                         "id <= " + upperBound + " ORDER BY id) TO STDOUT" +
+                         copyOptions(delimiter, first && includeHeader);
+        uint64_t rows = 0;
+        ok = copyOut(pg.get(), copySql, sink, &rows);
+        if (!ok) break;
+        
+        // Точка сохраняется только после того, как данные до нее на диске
+        ok = writer.sync();
+        checkpoint.lastId = atoll(upperBound.c_str());
+        checkpoint.byteOffset = writer.bytesWritten();
+        checkpoint.rowCount += rows;
+        ok = ok && checkpoint.save(filename);
+        first = false;
     }
+    execCommand(pg.get(), ok ? "COMMIT" : "ROLLBACK");
+    ok = writer.close() && ok;
     
-    // Данные
-    for (const auto& house : houses) {
-        for (size_t i = 0; i < fields.size(); ++i) {
-            const auto& field = fields[i];
+    // При ошибке .part и точка остаются для следующей попытки
+    if (!ok) return false;
+    if (checkpoint.rowCount == 0) {
+        remove(partFile.c_str());
+        ExportCheckpoint::remove(filename);
+        return false;
+    }
+    return ExportCheckpoint::commit(filename);
+}
+
+bool DatabaseManager::exportToFileParallel(const string& filename,
+                                           const vector<string>& fields,
+                                           const string& delimiter,
+                                           bool includeHeader,
+                                           int compressionLevel,
+                                           size_t threadCount) {
+    if (!isConnected() || fields.empty()) return false;
+    if (delimiter != "\t" && delimiter != ";" && delimiter != ",") return false;
+    
+    string select = buildExportSelect(fields);
+    if (select.empty()) return false;
+    
+    if (threadCount == 0) threadCount = max<unsigned>(2, thread::hardware_concurrency());
+    threadCount = min(threadCount, copyPool.maxSize() - 1);
+    if (threadCount == 0) {
+        return exportToFile(filename, fields, delimiter, includeHeader, compressionLevel);
+    }
+    
+    // Координатор экспортирует снимок и держит свою транзакцию открытой,
+    // пока все рабочие соединения не закончат читать по этому снимку
+    PooledConnection coordinator(copyPool);
+    if (!coordinator) return false;
+    PGconn* pg = coordinator.get();
+    
+    if (!execCommand(pg, "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY")) return false;
+    
+    PGresult* res = PQexec(pg, "SELECT pg_export_snapshot(), MIN(id), MAX(id) FROM houses");
+    if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1 || PQgetisnull(res, 0, 1)) {
+        PQclear(res);
+        execCommand(pg, "ROLLBACK");
+        return false;
+    }
+    string snapshotId = PQgetvalue(res, 0, 0);
+    long long minId = atoll(PQgetvalue(res, 0, 1));
+    long long maxId = atoll(PQgetvalue(res, 0, 2));
+    PQclear(res);
+    
+    // Диапазоны id по порядку; их склейка совпадает с последовательным экспортом
+    const size_t chunkCount = threadCount * 4;
+    long long span = maxId - minId + 1;
+    long long chunkSpan = max<long long>(1, (span + chunkCount - 1) / chunkCount);
+    
+    vector<string> chunkSql;
+    for (long long from = minId; from <= maxId; from += chunkSpan) {
+        long long to = min(maxId, from + chunkSpan - 1);
+        bool header = includeHeader && chunkSql.empty();
+        chunkSql.push_back("COPY (" + select + " WHERE id BETWEEN " + to_string(from) +
+                           " AND " + to_string(to) + " ORDER BY id) TO STDOUT" +
+                           copyOptions(delimiter, header));
+    }
+    
+    // Готовые части ждут записи не дальше, чем на окно вперед
+    const size_t window = threadCount * 2;
+    mutex stateMutex;
+    condition_variable stateChanged;
+    vector<string> results(chunkSql.size());
+    vector<bool> done(chunkSql.size(), false);
+    size_t nextChunk = 0;
+    size_t nextToWrite = 0;
+    atomic<bool> failed(false);
+    atomic<uint64_t> totalRows(0);
+    
+    auto worker = [&]() {
+        PooledConnection workerConn(copyPool);
+        PGconn* wpg = workerConn.get();
+        bool ready = wpg &&
+            execCommand(wpg, "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY") &&
+            execCommand(wpg, "SET TRANSACTION SNAPSHOT '" + snapshotId + "'");
+        if (!ready) {
+            {
+                lock_guard<mutex> lock(stateMutex);
+                failed = true;
+            }
+            stateChanged.notify_all();
+            if (wpg) execCommand(wpg, "ROLLBACK");
+            return;
+        }
+        
+        while (true) {
+            size_t chunk;
+            {
+                unique_lock<mutex> lock(stateMutex);
+                stateChanged.wait(lock, [&]() {
+                    return failed || nextChunk >= chunkSql.size() || nextChunk < nextToWrite + window;
+                });
+                if (failed || nextChunk >= chunkSql.size()) break;
+                chunk = nextChunk++;
+            }
             
-            if (field == "id") file << house.id;
-            else if (field == "address") file << house.address;
-            else if (field == "apartments") file << house.apartments;
-            else if (field == "total_area") file << house.totalArea;
-            else if (field == "build_year") file << house.buildYear;
-            else if (field == "floors") file << house.floors;
-            else if (field == "age") file << house.getAge();
+            string buffer;
+            uint64_t rows = 0;
+            bool ok = copyOut(wpg, chunkSql[chunk],
+                [&buffer](const char* data, size_t size) { buffer.append(data, size); return true; }, &rows);
+            totalRows += rows;
             
-            if (i < fields.size() - 1) file << delimiter;
+            {
+                lock_guard<mutex> lock(stateMutex);
+                if (!ok) failed = true;
+                results[chunk] = move(buffer);
+                done[chunk] = true;
+            }
+            stateChanged.notify_all();
+        }
+        
+        execCommand(wpg, "COMMIT");
+    };
+    
+    vector<thread> workers;
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    
+    // Части пишутся в файл строго по порядку id
+    string partFile = ExportCheckpoint::partPath(filename);
+    BufferedFileWriter writer;
+    if (!writer.open(partFile, compressionLevel)) {
+        {
+            lock_guard<mutex> lock(stateMutex);
+            failed = true;
+        }
+        stateChanged.notify_all();
+    }
+    
+    while (!failed && nextToWrite < chunkSql.size()) {
+        string chunk;
+        {
+            unique_lock<mutex> lock(stateMutex);
+            stateChanged.wait(lock, [&]() { return failed || done[nextToWrite]; });
+            if (failed) break;
+            chunk = move(results[nextToWrite]);
+        }
+        
+        if (!writer.write(chunk)) failed = true;
+        
+        {
+            lock_guard<mutex> lock(stateMutex);
+            nextToWrite++;
         }
-        file << "\n";
+        stateChanged.notify_all();
+    }
+    
+    for (auto& t : workers) {
+        t.join();
     }
+    execCommand(pg, "COMMIT");
+    
+    bool ok = writer.close() && !failed;
+    if (!ok || totalRows == 0) {
+        remove(partFile.c_str());
+        return false;
+    }
+    return ExportCheckpoint::commit(filename);
+}
+
+bool DatabaseManager::exportIncremental(const string& filename,
+                                        const vector<string>& requestedFields,
+                                        const string& delimiter,
+                                        bool includeHeader,
+                                        const string& watermarkName,
+                                        int compressionLevel,
+                                        IncrementalExportResult* result) {
+    if (!isConnected() || requestedFields.empty() || watermarkName.empty()) return false;
+    if (delimiter != "\t" && delimiter != ";" && delimiter != ",") return false;
     
-    file.close();
+    // Без id удаленные строки нечем обозначить
+    vector<string> fields = requestedFields;
+    if (find(fields.begin(), fields.end(), "id") == fields.end()) {
+        fields.insert(fields.begin(), "id");
+    }
+    
+    string columns = buildExportColumns(fields);
+    if (columns.empty()) return false;
+    
+    PooledConnection connection(copyPool);
+    if (!connection) return false;
+    PGconn* pg = connection.get();
+    
+    // Оба COPY и перенос метки выполняются по одному снимку
+    if (!execCommand(pg, "BEGIN ISOLATION LEVEL REPEATABLE READ")) return false;
+    
+    string name = escapeLiteral(pg, watermarkName);
+    string previousWatermark;
+    string nextMark;
+    
+    bool ok = queryValue(pg,
+        "SELECT COALESCE((SELECT exported_until FROM export_watermarks WHERE name = " + name + "), "
+        "'-infinity'::timestamptz)::text", previousWatermark) &&
+        nextWatermark(pg, previousWatermark, nextMark);
+    if (!ok) {
+        execCommand(pg, "ROLLBACK");
+        return false;
+    }
+    
+    string since = escapeLiteral(pg, previousWatermark) + "::timestamptz";
+    
+    // Измененные строки: op = 'U' и выбранные поля
+    string changedSql = "COPY (SELECT 'U' AS op, " + columns +
+                        " FROM houses WHERE updated_at >= " + since + " ORDER BY id) TO STDOUT" +
+                        copyOptions(delimiter, includeHeader);
+    
+    // Удаленные строки: op = 'D' и только id
+    string deletedSelect = "SELECT 'D' AS op";
+    for (const auto& field : fields) {
+        deletedSelect += string(", ") + (field == "id" ? "house_id" : "NULL") + " AS \"" + field + "\"";
+    }
+    string deletedSql = "COPY (" + deletedSelect + " FROM house_tombstones WHERE deleted_at >= " +
+                        since + " ORDER BY house_id) TO STDOUT" + copyOptions(delimiter, false);
+    
+    // Файл переименовывается до фиксации метки: если фиксация не пройдет,
+    // следующий экспорт повторит те же изменения, но ни одно не потеряется
+    string partFile = ExportCheckpoint::partPath(filename);
+    BufferedFileWriter writer;
+    auto sink = [&writer](const char* data, size_t size) { return writer.write(data, size); };
+    IncrementalExportResult stats;
+    
+    ok = writer.open(partFile, compressionLevel) &&
+         copyOut(pg, changedSql, sink, &stats.changedRows) &&
+         copyOut(pg, deletedSql, sink, &stats.deletedRows);
+    ok = writer.close() && ok;
+    
+    // Метка переносится только после того, как файл полностью записан
+    ok = ok &&
+        execCommand(pg, "INSERT INTO export_watermarks (name, exported_until) VALUES (" + name + ", " +
+                        escapeLiteral(pg, nextMark) + "::timestamptz) "
+                        "ON CONFLICT (name) DO UPDATE SET exported_until = EXCLUDED.exported_until") &&
+        execCommand(pg, "DELETE FROM house_tombstones WHERE deleted_at < "
+                        "(SELECT MIN(exported_until) FROM export_watermarks)") &&
+        ExportCheckpoint::commit(filename);
+    
+    if (!ok || !execCommand(pg, "COMMIT")) {
+        execCommand(pg, "ROLLBACK");
+        remove(partFile.c_str());
+        return false;
+    }
+    
+    if (result) *result = stats;
+    return true;
+}
+
+bool DatabaseManager::exportToColumnar(const string& filename, const vector<string>& fields) {
+    if (!isConnected() || fields.empty()) return false;
+    
+    ColumnarWriter writer(fields);
+    if (!writer.isValid() || !writer.open(filename)) return false;
+    
+    string select = "SELECT " + houseColumns(houseFieldsFor(fields)) + " FROM houses ORDER BY id";
+    
+    // Строки читаются потоком и собираются в небольшую таблицу, которая
+    // переиспользуется; в памяти только она и текущая группа строк файла
+    const size_t batchSize = 4096;
+    HouseTable batch;
+    batch.reserve(batchSize, batchSize * 48);
+    auto flush = [&writer, &batch]() {
+        for (size_t row = 0; row < batch.size(); ++row) {
+            if (!writer.addRow(batch, row)) return false;
+        }
+        batch.clear();
+        return true;
+    };
+    
+    bool ok = true;
+    try {
+        pqxx::nontransaction ntx(*conn);
+        for (auto [id, address, apartments, totalAreaText, buildYear, floors] :
+             ntx.stream<int, string_view, int, string_view, int, int>(select)) {
+            Area totalArea;
+            Area::parse(totalAreaText, totalArea);
+            batch.append(id, address, apartments, totalArea, buildYear, floors);
+            if (batch.size() >= batchSize && !flush()) {
+                ok = false;
+                break;
+            }
+        }
+        ok = ok && flush();
+    } catch (const exception& e) {
+        cerr << "Ошибка колоночного экспорта: " << e.what() << endl;
+        ok = false;
+    }
+    
+    // Пустой фонд - ошибка, как у текстового экспорта: файл назначения не заменяется
+    if (!ok || writer.rowCount() == 0) {
+        writer.discard();
+        return false;
+    }
+    return writer.close();
+}
+
+// ИМПОРТ
+bool DatabaseManager::importFromFile(const string& filename,
+                                     const string& delimiter,
+                                     bool hasHeader,
+                                     const string& errorFilename,
+                                     ImportResult* result,
+                                     QueryCanceler* canceler,
+                                     const ImportProgress& progress) {
+    if (!isConnected() || delimiter.size() != 1) return false;
+    
+    MappedFile file;
+    if (!file.open(filename)) {
+        cerr << "Не удалось открыть файл импорта: " << filename << endl;
+        return false;
+    }
+    
+    DelimitedParser parser(delimiter[0]);
+    const char* p = file.data();
+    const char* end = p + file.size();
+    size_t lineNumber = 1;
+    
+    ImportLayout layout = DelimitedParser::defaultLayout();
+    if (hasHeader && p < end) {
+        const char* headerEnd = parser.findRecordEnd(p, p, end);
+        layout = parser.layoutFromHeader(string_view(p, headerEnd - p));
+        p = headerEnd < end ? headerEnd + 1 : end;
+        lineNumber++;
+    }
+    if (!layout.isComplete()) {
+        cerr << "В файле импорта нет обязательных столбцов" << endl;
+        return false;
+    }
+    
+    PooledConnection connection(copyPool);
+    if (!connection) return false;
+    PGconn* pg = connection.get();
+    // Отмена прерывает любой шаг импорта; транзакция тогда откатывается
+    if (canceler && !canceler->attach(pg)) return false;
+    auto canceled = [canceler]() { return canceler && canceler->isCanceled(); };
+    auto fail = [&](const char* what) {
+        if (!canceled()) cerr << "Ошибка импорта (" << what << "): " << PQerrorMessage(pg) << endl;
+        execCommand(pg, "ROLLBACK");
+        if (canceler) canceler->detach();
+        return false;
+    };
+    
+    // Строки сначала попадают во временную таблицу: единственность адреса
+    // проверяется одним запросом для всего файла
+    if (!execCommand(pg, "BEGIN") ||
+        !execCommand(pg, "CREATE TEMP TABLE import_staging (line BIGINT, address TEXT, apartments INTEGER, "
+                         "total_area DECIMAL(10,2), build_year INTEGER, floors INTEGER) ON COMMIT DROP")) {
+        return fail("временная таблица");
+    }
+    PGresult* res = PQexec(pg, "COPY import_staging (line, address, apartments, total_area, build_year, floors) "
+                               "FROM STDIN");
+    bool copying = PQresultStatus(res) == PGRES_COPY_IN;
+    PQclear(res);
+    if (!copying) return fail("COPY");
+    
+    ImportResult stats;
+    ofstream errorFile;
+    auto reject = [&](size_t line, const string& reason, string_view text) {
+        if (errorFilename.empty()) return;
+        if (!errorFile.is_open()) {
+            errorFile.open(errorFilename);
+        }
+        errorFile << "строка " << line << ": " << reason << ": " << text << "\n";
+    };
+    
+    // Конвейер: потоки разбирают и проверяют части файла,
+    // а текущий поток по порядку передает готовые части в COPY
+    size_t maxInFlight = max<size_t>(2, thread::hardware_concurrency());
+    deque<future<ImportChunk>> inFlight;
+    
+    auto launchNext = [&]() {
+        if (p >= end || canceled()) return false;
+        // Граница части - конец записи: перевод строки внутри кавычек ее не завершает
+        const char* chunkEnd = p + min<size_t>(IMPORT_CHUNK_SIZE, end - p);
+        if (chunkEnd < end) {
+            chunkEnd = parser.findRecordEnd(p, chunkEnd, end);
+            if (chunkEnd < end) ++chunkEnd;
+        }
+        inFlight.push_back(async(launch::async, parseImportChunk,
+                                 p, chunkEnd, cref(parser), cref(layout)));
+        p = chunkEnd;
+        return true;
+    };
+    
+    while (inFlight.size() < maxInFlight && launchNext()) {}
+    
+    bool sent = true;
+    string buffer;
+    while (!inFlight.empty()) {
+        ImportChunk chunk = inFlight.front().get();
+        inFlight.pop_front();
+        if (!sent || canceled()) continue;
+        launchNext();
+        
+        buffer.clear();
+        for (size_t i = 0; i < chunk.houses.size(); ++i) {
+            appendStagingRow(lineNumber + chunk.houseLines[i], chunk.houses[i], buffer);
+        }
+        sent = buffer.empty() || PQputCopyData(pg, buffer.data(), static_cast<int>(buffer.size())) == 1;
+        
+        for (const auto& rejected : chunk.rejected) {
+            reject(lineNumber + rejected.line, rejected.reason, rejected.text);
+        }
+        
+        stats.totalRows += chunk.houses.size() + chunk.rejected.size();
+        stats.rejectedRows += chunk.rejected.size();
+        lineNumber += chunk.lineCount;
+        if (progress) progress(static_cast<size_t>(p - file.data()), file.size());
+    }
+    
+    // Прерванный COPY отменяется с сообщением; таблица фонда не затронута
+    sent = PQputCopyEnd(pg, sent && !canceled() ? nullptr : "импорт прерван") == 1 && sent;
+    bool copied = true;
+    while ((res = PQgetResult(pg)) != nullptr) {
+        if (PQresultStatus(res) != PGRES_COMMAND_OK) copied = false;
+        PQclear(res);
+    }
+    if (!sent || !copied || canceled()) return fail("COPY");
+    
+    // Адреса проверяются под монопольной блокировкой общего ключа адресов:
+    // address_taken берет его совместно, поэтому add_house и update_house
+    // ждут конца импорта. Блокировка каждого адреса переполнила бы таблицу
+    // блокировок сервера на больших файлах
+    if (!execCommand(pg, "SELECT pg_advisory_xact_lock(hashtext('houses.address'), 0)")) {
+        return fail("блокировка адресов");
+    }
+    res = PQexec(pg,
+        "SELECT line, address, EXISTS (SELECT 1 FROM houses h WHERE h.address = s.address) "
+        "FROM (SELECT line, address, row_number() OVER (PARTITION BY address ORDER BY line) AS n "
+        "      FROM import_staging) s "
+        "WHERE n > 1 OR EXISTS (SELECT 1 FROM houses h WHERE h.address = s.address) "
+        "ORDER BY line");
+    bool checked = PQresultStatus(res) == PGRES_TUPLES_OK;
+    if (checked) {
+        int duplicates = PQntuples(res);
+        for (int row = 0; row < duplicates; ++row) {
+            bool inFund = PQgetvalue(res, row, 2)[0] == 't';
+            reject(strtoull(PQgetvalue(res, row, 0), nullptr, 10),
+                   inFund ? "адрес уже есть в фонде" : "адрес повторяется в файле",
+                   string_view(PQgetvalue(res, row, 1), PQgetlength(res, row, 1)));
+        }
+        stats.rejectedRows += static_cast<size_t>(duplicates);
+    }
+    PQclear(res);
+    if (!checked) return fail("проверка адресов");
+    
+    // Первый по файлу дом каждого нового адреса
+    res = PQexec(pg,
+        "INSERT INTO houses (address, apartments, total_area, build_year, floors) "
+        "SELECT address, apartments, total_area, build_year, floors FROM ("
+        "    SELECT DISTINCT ON (address) * FROM import_staging ORDER BY address, line) s "
+        "WHERE NOT EXISTS (SELECT 1 FROM houses h WHERE h.address = s.address) "
+        "ORDER BY line");
+    bool inserted = PQresultStatus(res) == PGRES_COMMAND_OK;
+    if (inserted) stats.importedRows = strtoull(PQcmdTuples(res), nullptr, 10);
+    PQclear(res);
+    if (!inserted || canceled()) return fail("запись домов");
+    
+    if (!execCommand(pg, "COMMIT")) return fail("COMMIT");
+    if (canceler) canceler->detach();
+    
+    if (result) *result = stats;
+    
+    // Новые адреса должны попасть в фильтр house_exists
+    loadAddressFilter();
     return true;
 }
 
@@ -509,7 +1795,7 @@ House DatabaseManager::rowToHouse(const pqxx::row& row) {
     house.id = row[0].as<int>();
     house.address = row[1].as<string>();
     house.apartments = row[2].as<int>();
-    house.totalArea = row[3].as<double>();
+    Area::parse(row[3].view(), house.totalArea);
     house.buildYear = row[4].as<int>();
     house.floors = row[5].as<int>();
     if (row.size() > 6) {
@@ -518,15 +1804,58 @@ House DatabaseManager::rowToHouse(const pqxx::row& row) {
     return house;
 }
 
-House DatabaseManager::rowToHouseFromProcedure(const pqxx::row& row) {
+void DatabaseManager::appendHouses(const pqxx::result& res, unsigned fields, HouseTable& houses) {
+    // Столбцы идут в порядке HouseFields::Stored, поэтому читаем по номеру без поиска имени
+    fields = normalizedHouseFields(fields);
+    
+    // Адреса копируются из результата сразу в общий буфер таблицы
+    size_t addressBytes = 0;
+    if (fields & HOUSE_FIELD_ADDRESS) {
+        pqxx::row::size_type addressColumn = (fields & HOUSE_FIELD_ID) ? 1 : 0;
+        for (const auto& row : res) addressBytes += row[addressColumn].size();
+    }
+    houses.reserve(houses.size() + res.size(), houses.addressBytes() + addressBytes);
+    
     House house;
-    house.id = row["house_id"].as<int>();
-    house.address = row["house_address"].as<string>();
-    house.apartments = row["house_apartments"].as<int>();
-    house.totalArea = row["house_total_area"].as<double>();
-    house.buildYear = row["house_build_year"].as<int>();
-    house.floors = row["house_floors"].as<int>();
-    return house;
+    for (const auto& row : res) {
+        pqxx::row::size_type column = 0;
+        HouseFields::Stored::forEach([&](auto field) {
+            typedef decltype(field) Field;
+            if (fields & Field::MASK) decodeText(row[column++], house.*Field::MEMBER);
+        });
+        houses.append(house);
+    }
+}
+
+unsigned DatabaseManager::houseFieldsFor(const vector<string>& exportFields) {
+    unsigned fields = 0;
+    for (const auto& field : exportFields) {
+        HouseFields::Exported::find(field, [&fields](auto descriptor) {
+            fields |= decltype(descriptor)::MASK;
+        });
+    }
+    return fields;
+}
+
+string DatabaseManager::normalizeAddress(const string& address) {
+    // Нормализация только сливает варианты написания, поэтому из
+    // совпадения адресов на сервере всегда следует совпадение ключей
+    string result;
+    result.reserve(address.size());
+    bool pendingSpace = false;
+    
+    for (unsigned char c : address) {
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            pendingSpace = !result.empty();
+            continue;
+        }
+        if (pendingSpace) {
+            result += ' ';
+            pendingSpace = false;
+        }
+        result += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : static_cast<char>(c);
+    }
+    return result;
 }
 
 User DatabaseManager::rowToUser(const pqxx::row& row) {
@@ -4,8 +4,75 @@
 #include <pqxx/pqxx>
 #include <vector>
 #include <string>
+#include <mutex>
+#include <functional>
 #include "../models/House.h"
 #include "../models/User.h"
+#include "../utils/BloomFilter.h"
+#include "../utils/HouseTable.h"
+#include "ConnectionPool.h"
+#include "QueryCanceler.h"
+
+// Метрики клиентского фильтра адресов
+struct AddressFilterStats {
+    size_t items = 0;
+    size_t memoryBytes = 0;
+    double estimatedFalsePositiveRate = 1.0;
+    uint64_t lookups = 0;         // всего проверок адреса
+    uint64_t skippedQueries = 0;  // ответ "точно нет" без запроса к серверу
+    uint64_t falsePositives = 0;  // "возможно есть", но сервер ответил "нет"
+    
+    double observedFalsePositiveRate() const {
+        uint64_t maybe = lookups - skippedQueries;
+        return maybe > 0 ? static_cast<double>(falsePositives) / maybe : 0.0;
+    }
+};
+
+// Итог инкрементального экспорта
+struct IncrementalExportResult {
+    uint64_t changedRows = 0;
+    uint64_t deletedRows = 0;
+};
+
+// Изменения домов с метки локального снимка
+struct HouseChanges {
+    HouseTable changed;         // новые и измененные строки, по возрастанию id
+    vector<int> removedIds;     // по возрастанию
+    string watermark;           // метка для следующей синхронизации
+    // false: записи об удалениях после метки уже очищены экспортом, нужна полная загрузка
+    bool complete = false;
+};
+
+// Ключ сортировки: номер столбца таблицы (1 - адрес ... 5 - этажность) и направление
+struct HouseSortKey {
+    int column;
+    bool ascending;
+};
+
+// Фильтры и порядок постраничной выборки домов
+struct HouseQuery {
+    bool filtered = false;
+    int minYear = 0;
+    int maxYear = 0;
+    int minApartments = 0;
+    int maxApartments = 0;
+    Area minArea;
+    Area maxArea;
+    int minFloors = 0;
+    int maxFloors = 0;
+    string addressPattern;          // подстрока адреса без учета регистра
+    vector<HouseSortKey> sortKeys;  // id всегда добавляется последним ключом
+};
+
+// Итог импорта из файла
+struct ImportResult {
+    size_t totalRows = 0;
+    size_t importedRows = 0;
+    size_t rejectedRows = 0;     // ошибки разбора и адреса, которые уже есть в фонде или повторяются в файле
+};
+
+// Ход импорта: обработано done байт файла из total; вызывается из потока импорта
+typedef function<void(size_t done, size_t total)> ImportProgress;
 
 class DatabaseManager {
 public:
@@ -15,22 +82,59 @@ public:
     bool connect();
     void disconnect();
     bool isConnected() const;
+    // Открывает соединения пула с подготовленными операторами заранее,
+    // например пока пользователь вводит пароль; безопасно из рабочего потока
+    size_t warmUp(size_t connections);
   
-    bool addHouse(const House& house);
+    // При успехе house.id - номер, выданный базой
+    bool addHouse(House& house);
     bool updateHouse(const House& house);
     bool deleteHouse(int id);
     bool deleteHousesByYear(int year);
     bool deleteHousesByApartments(int minApartments, int maxApartments);
-    bool deleteHousesByArea(double minArea, double maxArea);
+    bool deleteHousesByArea(Area minArea, Area maxArea);
     bool deleteHousesByAddress(const string& addressPattern);
-    vector<House> getAllHouses();
-    vector<House> getHousesOlderThan(int years);
-    vector<House> getHousesByYear(int year);
-    vector<House> searchHouses(const string& address);
+    // fields - маска HouseField: сервер возвращает только эти столбцы
+    HouseTable getAllHouses(unsigned fields = HOUSE_FIELDS_ALL);
+    HouseTable getHousesOlderThan(int years, unsigned fields = HOUSE_FIELDS_ALL);
+    HouseTable getHousesByYear(int year, unsigned fields = HOUSE_FIELDS_ALL);
+    HouseTable searchHouses(const string& address, unsigned fields = HOUSE_FIELDS_ALL);
+    
+    // Страница домов после строки after (keyset по ключам сортировки и id);
+    // limit = 0 - без ограничения. Безопасно вызывать из рабочих потоков;
+    // canceler позволяет прервать запрос на сервере из другого потока
+    bool fetchHousePage(const HouseQuery& query, const House* after, size_t limit, vector<House>& houses,
+                        QueryCanceler* canceler = nullptr);
+    bool fetchHousePage(const HouseQuery& query, const House* after, size_t limit, HouseTable& houses,
+                        QueryCanceler* canceler = nullptr);
+    // Оценка числа домов по статистике планировщика, без полного подсчета
+    long long estimateHouseCount();
+    
+    // Локальный снимок: метка, взятая до полной загрузки, гарантирует, что
+    // изменения во время загрузки придут со следующей синхронизацией
+    bool currentHouseWatermark(string& watermark);
+    bool fetchHouseChanges(const string& since, HouseChanges& changes, QueryCanceler* canceler = nullptr);
+    // База и таблица домов, к которым относится снимок; пустая строка при ошибке
+    string databaseIdentity();
+    // Метка потребителя записей об удалениях (как у инкрементального экспорта):
+    // записи после нее не очищаются, пока потребитель ее не сдвинет или не снимет
+    bool holdTombstones(const string& consumer, const string& watermark);
+    bool releaseTombstones(const string& consumer);
+    
+    // Поля дома, нужные для полей экспорта (age требует build_year)
+    static unsigned houseFieldsFor(const vector<string>& exportFields);
     
     bool houseExists(const House& house);
     bool houseExistsWithDifferentId(const House& house);
     bool findSimilarHouses(const House& house, vector<House>& similarHouses, double similarityThreshold = 0.8);
+    
+    // Фильтр только сокращает запросы проверки дубликатов: он строится после
+    // подключения и не видит адресов, добавленных с других рабочих мест.
+    // Единственность адреса проверяют на сервере add_house и update_house.
+    // Безопасно из рабочего потока; пока фильтр не готов, проверки идут на сервер.
+    // canceler прерывает чтение адресов на сервере, фильтр тогда не заменяется
+    bool loadAddressFilter(QueryCanceler* canceler = nullptr);
+    AddressFilterStats getAddressFilterStats() const;
 
     bool addUser(const User& user);
     bool updateUserPassword(const string& login, const string& newHash, const string& newSalt);
@@ -41,7 +145,33 @@ public:
     bool exportToFile(const string& filename, 
                      const vector<string>& fields,
                      const string& delimiter = "\t",
-                     bool includeHeader = true);
+                     bool includeHeader = true,
+                     int compressionLevel = 0,
+                     bool* resumed = nullptr);
+    bool exportToFileParallel(const string& filename,
+                              const vector<string>& fields,
+                              const string& delimiter = "\t",
+                              bool includeHeader = true,
+                              int compressionLevel = 0,
+                              size_t threadCount = 0);
+    bool exportToColumnar(const string& filename, const vector<string>& fields);
+    bool exportIncremental(const string& filename,
+                           const vector<string>& fields,
+                           const string& delimiter = "\t",
+                           bool includeHeader = true,
+                           const string& watermarkName = "default",
+                           int compressionLevel = 0,
+                           IncrementalExportResult* result = nullptr);
+    // Импорт на соединении пула: безопасно из рабочего потока. Строки проходят
+    // через временную таблицу; в фонд попадают только новые адреса, по одному
+    // дому на адрес. canceler прерывает импорт, в фонде тогда ничего не меняется
+    bool importFromFile(const string& filename,
+                        const string& delimiter = "\t",
+                        bool hasHeader = true,
+                        const string& errorFilename = "",
+                        ImportResult* result = nullptr,
+                        QueryCanceler* canceler = nullptr,
+                        const ImportProgress& progress = nullptr);
     
     int getHouseCount();
     int getUserCount();
@@ -49,11 +179,21 @@ public:
 private:
     pqxx::connection* conn;
     string connectionString;
+    ConnectionPool copyPool;
+    
+    // Фильтр загружается в рабочем потоке, а проверяется в потоке окна
+    mutable mutex addressFilterMutex;
+    BloomFilter addressFilter;
+    bool addressFilterReady;
+    AddressFilterStats addressFilterStats;
 
     House rowToHouse(const pqxx::row& row);
-    House rowToHouseFromProcedure(const pqxx::row& row);
+    void appendHouses(const pqxx::result& res, unsigned fields, HouseTable& houses);
     User rowToUser(const pqxx::row& row);
     string normalizeAddress(const string& address);
+    bool addressMightExist(const string& address);
+    void rememberAddress(const string& address);
+    void countAddressFalsePositive();
 };
 
 #endif
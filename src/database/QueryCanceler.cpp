@@ -0,0 +1,43 @@
+#include "QueryCanceler.h"
+#include <libpq-fe.h>
+#include <iostream>
+
+using namespace std;
+
+QueryCanceler::QueryCanceler()
+    : handle(nullptr), canceled(false) {}
+
+QueryCanceler::~QueryCanceler() {
+    detach();
+}
+
+void QueryCanceler::cancel() {
+    lock_guard<mutex> lock(cancelMutex);
+    canceled = true;
+    if (handle) {
+        char error[256];
+        if (!PQcancel(handle, error, sizeof(error))) {
+            cerr << "Ошибка отмены запроса: " << error << endl;
+        }
+    }
+}
+
+bool QueryCanceler::isCanceled() const {
+    lock_guard<mutex> lock(cancelMutex);
+    return canceled;
+}
+
+bool QueryCanceler::attach(PGconn* conn) {
+    lock_guard<mutex> lock(cancelMutex);
+    if (canceled) return false;
+    handle = PQgetCancel(conn);
+    return true;
+}
+
+void QueryCanceler::detach() {
+    lock_guard<mutex> lock(cancelMutex);
+    if (handle) {
+        PQfreeCancel(handle);
+        handle = nullptr;
+    }
+}
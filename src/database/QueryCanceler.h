@@ -0,0 +1,35 @@
+#ifndef QUERYCANCELER_H
+#define QUERYCANCELER_H
+
+#include <mutex>
+
+using namespace std;
+
+typedef struct pg_conn PGconn;
+typedef struct pg_cancel PGcancel;
+
+// Отмена запроса из другого потока: cancel() прерывает выполнение на сервере
+class QueryCanceler {
+public:
+    QueryCanceler();
+    ~QueryCanceler();
+
+    QueryCanceler(const QueryCanceler&) = delete;
+    QueryCanceler& operator=(const QueryCanceler&) = delete;
+
+    // Отменяет текущий запрос; запрос, начатый позже, не выполнится
+    void cancel();
+    bool isCanceled() const;
+
+    // Вызываются потоком, выполняющим запрос на соединении conn;
+    // attach возвращает false, если отмена уже запрошена
+    bool attach(PGconn* conn);
+    void detach();
+
+private:
+    mutable mutex cancelMutex;
+    PGcancel* handle;
+    bool canceled;
+};
+
+#endif
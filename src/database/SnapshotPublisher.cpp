@@ -0,0 +1,88 @@
+#include "SnapshotPublisher.h"
+#include "config/Config.h"
+#include <csignal>
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+volatile sig_atomic_t stopRequested = 0;
+
+void onStopSignal(int) {
+    stopRequested = 1;
+}
+
+}
+
+SnapshotPublisher::SnapshotPublisher(DatabaseManager* dbManager, const string& name)
+    : dbManager(dbManager), publisher(name, Config::getSharedSnapshotGroup()), consumer("snapshot:" + name) {}
+
+int SnapshotPublisher::run() {
+    if (!publisher.open()) return 1;
+    signal(SIGINT, onStopSignal);
+    signal(SIGTERM, onStopSignal);
+
+    snapshot.source = dbManager->databaseIdentity();
+    if (snapshot.source.empty() || !reload()) {
+        cerr << "Ошибка загрузки домов для общего снимка" << endl;
+        dbManager->releaseTombstones(consumer);
+        return 1;
+    }
+
+    while (!stopRequested) {
+        for (int i = 0; i < SYNC_INTERVAL_SECONDS && !stopRequested; ++i) {
+            sleep(1);
+        }
+        // Ошибка не прерывает работу: повтор через интервал
+        if (!stopRequested && !sync()) {
+            cerr << "Ошибка синхронизации общего снимка" << endl;
+        }
+    }
+
+    dbManager->releaseTombstones(consumer);
+    return 0;
+}
+
+bool SnapshotPublisher::reload() {
+    // Метка берется и закрепляется до загрузки: изменения и удаления во время
+    // загрузки придут со следующей синхронизацией
+    SnapshotCache next;
+    next.source = snapshot.source;
+    return dbManager->currentHouseWatermark(next.watermark) &&
+           dbManager->holdTombstones(consumer, next.watermark) &&
+           dbManager->fetchHousePage(HouseQuery(), nullptr, 0, next.houses) &&
+           publish(next);
+}
+
+bool SnapshotPublisher::sync() {
+    HouseChanges changes;
+    if (!dbManager->fetchHouseChanges(snapshot.watermark, changes)) return false;
+    // Метку сняли, и удаления после нее очищены: только загрузка заново
+    if (!changes.complete) return reload();
+    // Без изменений эпоха не меняется: программы сами получат пустую разницу
+    if (changes.changed.empty() && changes.removedIds.empty()) return true;
+
+    SnapshotCache next;
+    next.source = snapshot.source;
+    next.watermark = changes.watermark;
+    SnapshotCache::merge(snapshot.houses, changes.changed, changes.removedIds, next.houses);
+    return publish(next);
+}
+
+bool SnapshotPublisher::publish(SnapshotCache& next) {
+    // Индексы строятся один раз здесь: программы берут их из сегмента готовыми
+    HouseSnapshot built;
+    built.build(next.houses);
+    if (!publisher.publish(next.source, next.watermark, built)) return false;
+
+    // Метка сдвигается после переключения эпохи: до него удаления после
+    // прежней метки нужны программам, читающим прежний сегмент
+    if (!dbManager->holdTombstones(consumer, next.watermark)) {
+        cerr << "Ошибка сохранения метки общего снимка" << endl;
+    }
+    snapshot = move(next);
+    cout << "Общий снимок, эпоха " << publisher.epoch() << ": " << snapshot.houses.size() << " домов" << endl;
+    return true;
+}
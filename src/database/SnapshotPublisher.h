@@ -0,0 +1,38 @@
+#ifndef SNAPSHOTPUBLISHER_H
+#define SNAPSHOTPUBLISHER_H
+
+#include <string>
+#include "DatabaseManager.h"
+#include "../utils/SnapshotCache.h"
+#include "../utils/SharedSnapshot.h"
+
+using namespace std;
+
+// Издатель общего снимка (запуск с --publish-snapshot): один процесс на
+// терминальном сервере загружает дома, публикует их с индексами в общей
+// памяти и периодически догружает изменения. Программы на том же сервере
+// показывают снимок прямо из сегмента и запрашивают у базы только изменения
+// после его метки
+class SnapshotPublisher {
+public:
+    static constexpr int SYNC_INTERVAL_SECONDS = 15;
+
+    SnapshotPublisher(DatabaseManager* dbManager, const string& name);
+
+    // Работает до SIGINT или SIGTERM; возвращает код завершения процесса
+    int run();
+
+private:
+    DatabaseManager* dbManager;
+    SharedSnapshotPublisher publisher;
+    // Имя метки в export_watermarks: записи об удалениях после метки
+    // опубликованного снимка нужны программам и не очищаются экспортом
+    string consumer;
+    SnapshotCache snapshot;
+
+    bool reload();
+    bool sync();
+    bool publish(SnapshotCache& next);
+};
+
+#endif
@@ -1,11 +1,40 @@
 #include <QApplication>
 #include <QMessageBox>
+#include <future>
+#include <iostream>
 #include "database/DatabaseManager.h"
+#include "database/SnapshotPublisher.h"
 #include "ui/MainWindow.h"
 #include "ui/AuthDialog.h"
+#include "ui/HouseLoader.h"
 #include "config/Config.h"
 
+using namespace std;
+
+// Соединения пула, открываемые во время входа: загрузка домов и поиск
+const size_t PREFETCH_CONNECTIONS = 2;
+
+// Издатель общего снимка работает без окна и входа пользователя
+int publishSharedSnapshot() {
+    string name = Config::getSharedSnapshotName();
+    if (name.empty()) {
+        cerr << "Не задано имя общего снимка (HOUSING_SHARED_SNAPSHOT)" << endl;
+        return 1;
+    }
+    
+    DatabaseManager dbManager(Config::getConnectionString());
+    if (!dbManager.connect()) {
+        cerr << "Не удалось подключиться к базе данных" << endl;
+        return 1;
+    }
+    return SnapshotPublisher(&dbManager, name).run();
+}
+
 int main(int argc, char *argv[]) {
+    if (argc > 1 && string(argv[1]) == "--publish-snapshot") {
+        return publishSharedSnapshot();
+    }
+    
     QApplication app(argc, argv);
     
     // Подключение к базе данных
@@ -16,14 +45,41 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
+    // Пока пользователь вводит пароль, в фоне открываются соединения пула,
+    // оценивается размер фонда, строится фильтр адресов и загружаются дома;
+    // после входа окно сразу получает готовые данные. Окно входа не ждет базы
+    HouseLoader* preloader = nullptr;
+    bool loggedIn = false;
+    QueryCanceler warmUpCanceler;
+    future<void> warmUp = async(launch::async, [&app, &dbManager, &preloader, &loggedIn, &warmUpCanceler]() {
+        dbManager.warmUp(PREFETCH_CONNECTIONS);
+        long long estimate = dbManager.estimateHouseCount();
+        // Предзагрузка только для фонда, который помещается в память; окно,
+        // открытое раньше оценки, выбирает режим само
+        if (estimate < Config::getPagedTableThreshold()) {
+            QMetaObject::invokeMethod(&app, [&dbManager, &preloader, &loggedIn]() {
+                if (loggedIn || preloader) return;
+                preloader = new HouseLoader(&dbManager);
+                preloader->setRetainResults(true);
+                preloader->start();
+            }, Qt::QueuedConnection);
+        }
+        dbManager.loadAddressFilter(&warmUpCanceler);
+    });
+    
     // Окно авторизации
     AuthDialog authDialog(&dbManager);
     if (authDialog.exec() != QDialog::Accepted) {
+        // Загрузка и построение фильтра прерываются на сервере, полученные данные
+        // отбрасываются; warmUp при выходе дожидается только прерванного запроса
+        warmUpCanceler.cancel();
+        delete preloader;
         return 0; 
     }
+    loggedIn = true;
     
     // Главное окно
-    MainWindow mainWindow(&dbManager);
+    MainWindow mainWindow(&dbManager, preloader);
     mainWindow.show();
     
     return app.exec();
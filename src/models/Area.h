@@ -0,0 +1,103 @@
+#ifndef AREA_H
+#define AREA_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cmath>
+
+using namespace std;
+
+// Площадь в сотых долях м² - точное представление DECIMAL(10,2).
+// Сравнение, сумма и разность - целочисленные, без ошибок округления double
+struct Area {
+    int64_t hundredths;
+
+    Area() : hundredths(0) {}
+    explicit Area(int64_t hundredths) : hundredths(hundredths) {}
+
+    // Значение из полей ввода (QDoubleSpinBox) - ближайшая сотая
+    static Area fromDouble(double squareMeters) {
+        return Area(llround(squareMeters * 100.0));
+    }
+
+    double toDouble() const {
+        return hundredths / 100.0;
+    }
+
+    // Десятичная запись "123.45" без перехода через double; знаки после
+    // второго округляются, как при записи в NUMERIC(10,2)
+    static bool parse(string_view text, Area& area) {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+
+        bool negative = false;
+        if (!text.empty() && (text.front() == '+' || text.front() == '-')) {
+            negative = text.front() == '-';
+            text.remove_prefix(1);
+        }
+
+        int64_t value = 0;
+        size_t pos = 0;
+        size_t integerDigits = 0;
+        for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos, ++integerDigits) {
+            if (value > (INT64_MAX - 9) / 1000) return false;
+            value = value * 10 + (text[pos] - '0');
+        }
+
+        int fractionDigits = 0;
+        bool roundUp = false;
+        if (pos < text.size() && text[pos] == '.') {
+            for (++pos; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+                if (fractionDigits < 2) {
+                    value = value * 10 + (text[pos] - '0');
+                } else if (fractionDigits == 2) {
+                    roundUp = text[pos] >= '5';
+                }
+                ++fractionDigits;
+            }
+        }
+        if (pos != text.size() || (integerDigits == 0 && fractionDigits == 0)) return false;
+
+        for (int i = fractionDigits; i < 2; ++i) value *= 10;
+        if (roundUp) value++;
+        area.hundredths = negative ? -value : value;
+        return true;
+    }
+
+    void appendTo(string& out) const {
+        // Как DECIMAL(10,2) в выводе COPY: всегда два знака после точки
+        uint64_t magnitude = hundredths < 0 ? 0 - static_cast<uint64_t>(hundredths) : hundredths;
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* p = end;
+        for (int i = 0; i < 2; ++i, magnitude /= 10) *--p = static_cast<char>('0' + magnitude % 10);
+        *--p = '.';
+        do {
+            *--p = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (hundredths < 0) *--p = '-';
+        out.append(p, end - p);
+    }
+
+    string toString() const {
+        string out;
+        appendTo(out);
+        return out;
+    }
+
+    Area& operator+=(Area other) { hundredths += other.hundredths; return *this; }
+    Area& operator-=(Area other) { hundredths -= other.hundredths; return *this; }
+    friend Area operator+(Area a, Area b) { return a += b; }
+    friend Area operator-(Area a, Area b) { return a -= b; }
+
+    friend bool operator==(Area a, Area b) { return a.hundredths == b.hundredths; }
+    friend bool operator!=(Area a, Area b) { return a.hundredths != b.hundredths; }
+    friend bool operator<(Area a, Area b) { return a.hundredths < b.hundredths; }
+    friend bool operator<=(Area a, Area b) { return a.hundredths <= b.hundredths; }
+    friend bool operator>(Area a, Area b) { return a.hundredths > b.hundredths; }
+    friend bool operator>=(Area a, Area b) { return a.hundredths >= b.hundredths; }
+};
+
+#endif
@@ -4,25 +4,39 @@
 #include <string>
 #include <ctime>
 #include <cmath>   
+#include <cstdlib>
+#include "Area.h"
 
 using namespace std;
 
+// Поля дома для чтения с проекцией (битовая маска)
+enum HouseField : unsigned {
+    HOUSE_FIELD_ID = 1u << 0,
+    HOUSE_FIELD_ADDRESS = 1u << 1,
+    HOUSE_FIELD_APARTMENTS = 1u << 2,
+    HOUSE_FIELD_TOTAL_AREA = 1u << 3,
+    HOUSE_FIELD_BUILD_YEAR = 1u << 4,
+    HOUSE_FIELD_FLOORS = 1u << 5,
+    HOUSE_FIELDS_ALL = 0x3Fu
+};
+
+// Незапрошенные поля остаются со значениями по умолчанию
 struct House {
     int id;
     string address;
     int apartments;
-    double totalArea;
+    Area totalArea;
     int buildYear;
     int floors;
     time_t createdAt;
     
-    House() : id(0), apartments(0), totalArea(0.0), buildYear(0), floors(0), createdAt(0) {}
+    House() : id(0), apartments(0), totalArea(), buildYear(0), floors(0), createdAt(0) {}
     
     // Проверка корректности данных
     bool isValid() const {
         return !address.empty() && 
                apartments > 0 && 
-               totalArea > 0 && 
+               totalArea.hundredths > 0 && 
                buildYear >= 1500 && 
                buildYear <= (time(nullptr) / 31556952 + 1970) && // текущий год
                floors > 0 && floors <= 100;
@@ -59,9 +73,10 @@ struct House {
             similarity += 0.1;
         }
         
-        double areaDiff = fabs(totalArea - other.totalArea);
-        double areaRatio = areaDiff / max(totalArea, other.totalArea);
-        if (areaRatio <= 0.15) {
+        // |a - b| / max(a, b) <= 0.15 в целых сотых
+        int64_t areaDiff = llabs(totalArea.hundredths - other.totalArea.hundredths);
+        int64_t areaMax = max(totalArea.hundredths, other.totalArea.hundredths);
+        if (areaMax > 0 && areaDiff * 100 <= areaMax * 15) {
             similarity += 0.1;
         }
         
@@ -104,7 +104,7 @@ void AddEditDialog::onSaveClicked() {
     // Заполняем структуру House
     currentHouse.address = addressEdit->text().trimmed().toStdString();
     currentHouse.apartments = apartmentsSpin->value();
-    currentHouse.totalArea = areaSpin->value();
+    currentHouse.totalArea = Area::fromDouble(areaSpin->value());
     currentHouse.buildYear = yearSpin->value();
     currentHouse.floors = floorsSpin->value();
     currentHouse.id = currentHouseId;
@@ -184,7 +184,7 @@ bool AddEditDialog::checkForDuplicates() const {
     tempHouse.address = address.toStdString();
     tempHouse.id = currentHouseId;
     tempHouse.apartments = apartmentsSpin->value();
-    tempHouse.totalArea = areaSpin->value();
+    tempHouse.totalArea = Area::fromDouble(areaSpin->value());
     tempHouse.buildYear = yearSpin->value();
     tempHouse.floors = floorsSpin->value();
     
@@ -215,7 +215,7 @@ bool AddEditDialog::checkForDuplicates() const {
                 message += QString("Адрес: %1\nКвартир: %2, Площадь: %3 м², Год: %4, Этажей: %5\n\n")
                     .arg(QString::fromStdString(similar.address))
                     .arg(similar.apartments)
-                    .arg(similar.totalArea, 0, 'f', 2)
+                    .arg(QString::fromStdString(similar.totalArea.toString()))
                     .arg(similar.buildYear)
                     .arg(similar.floors);
             }
@@ -247,7 +247,7 @@ void AddEditDialog::setHouse(const House& house) {
     
     if (addressEdit) addressEdit->setText(QString::fromStdString(house.address));
     if (apartmentsSpin) apartmentsSpin->setValue(house.apartments);
-    if (areaSpin) areaSpin->setValue(house.totalArea);
+    if (areaSpin) areaSpin->setValue(house.totalArea.toDouble());
     if (yearSpin) yearSpin->setValue(house.buildYear);
     if (floorsSpin) floorsSpin->setValue(house.floors);
     
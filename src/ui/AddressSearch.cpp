@@ -0,0 +1,96 @@
+#include "AddressSearch.h"
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+AddressSearch::AddressSearch(DatabaseManager* dbManager, QObject* parent)
+    : QObject(parent), dbManager(dbManager), pendingLimit(0), generation(0) {
+    debounceTimer = new QTimer(this);
+    debounceTimer->setSingleShot(true);
+    debounceTimer->setInterval(DEBOUNCE_MS);
+    connect(debounceTimer, &QTimer::timeout, this, &AddressSearch::dispatch);
+}
+
+AddressSearch::~AddressSearch() {
+    cancel();
+    for (auto& worker : workers) {
+        worker.wait();
+    }
+}
+
+void AddressSearch::search(const HouseQuery& query, size_t limit) {
+    pendingQuery = query;
+    pendingLimit = limit;
+    debounceTimer->start();
+}
+
+void AddressSearch::searchNow(const HouseQuery& query, size_t limit) {
+    debounceTimer->stop();
+    pendingQuery = query;
+    pendingLimit = limit;
+    dispatch();
+}
+
+void AddressSearch::cancel() {
+    debounceTimer->stop();
+    generation++;
+    cancelRunning();
+}
+
+bool AddressSearch::isBusy() const {
+    return debounceTimer->isActive() || running != nullptr;
+}
+
+void AddressSearch::dispatch() {
+    pruneWorkers();
+
+    // Предыдущий запрос больше не нужен: прерываем его на сервере
+    cancelRunning();
+
+    uint64_t searchGeneration = ++generation;
+    shared_ptr<QueryCanceler> canceler = make_shared<QueryCanceler>();
+    running = canceler;
+
+    HouseQuery query = pendingQuery;
+    size_t limit = pendingLimit;
+    workers.push_back(async(launch::async, [this, searchGeneration, query, limit, canceler]() {
+        vector<House> houses;
+        bool ok = dbManager->fetchHousePage(query, nullptr, limit, houses, canceler.get());
+
+        QMetaObject::invokeMethod(this, [this, searchGeneration, query, ok, houses]() {
+            onCompleted(searchGeneration, query, ok, houses);
+        }, Qt::QueuedConnection);
+    }));
+}
+
+void AddressSearch::cancelRunning() {
+    if (!running) return;
+
+    // PQcancel открывает отдельное соединение с сервером, поэтому
+    // выполняется в фоне и не задерживает поток интерфейса
+    shared_ptr<QueryCanceler> canceler = move(running);
+    running.reset();
+    workers.push_back(async(launch::async, [canceler]() {
+        canceler->cancel();
+    }));
+}
+
+void AddressSearch::onCompleted(uint64_t searchGeneration, const HouseQuery& query, bool ok,
+                                vector<House> houses) {
+    // Пока шел запрос, пользователь ввел что-то еще
+    if (searchGeneration != generation) return;
+
+    running.reset();
+    if (ok) {
+        emit finished(query, houses);
+    } else {
+        emit failed(query);
+    }
+}
+
+void AddressSearch::pruneWorkers() {
+    workers.erase(remove_if(workers.begin(), workers.end(), [](const future<void>& worker) {
+        return worker.wait_for(chrono::seconds(0)) == future_status::ready;
+    }), workers.end());
+}
@@ -0,0 +1,55 @@
+#ifndef ADDRESSSEARCH_H
+#define ADDRESSSEARCH_H
+
+#include <QObject>
+#include <QTimer>
+#include <vector>
+#include <memory>
+#include <future>
+#include <cstdint>
+#include "../database/DatabaseManager.h"
+
+using namespace std;
+
+// Поиск по мере ввода: запросы откладываются до паузы в наборе, выполняются
+// в рабочем потоке, устаревший запрос отменяется на сервере, а его результат
+// отбрасывается
+class AddressSearch : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int DEBOUNCE_MS = 250;
+
+    explicit AddressSearch(DatabaseManager* dbManager, QObject* parent = nullptr);
+    ~AddressSearch();
+
+    // limit = 0 - все найденные строки
+    void search(const HouseQuery& query, size_t limit = 0);
+    // Без ожидания паузы (кнопка "Найти", Enter)
+    void searchNow(const HouseQuery& query, size_t limit = 0);
+    // Отменяет отложенный и выполняющийся запросы
+    void cancel();
+    bool isBusy() const;
+
+signals:
+    void finished(const HouseQuery& query, const vector<House>& houses);
+    void failed(const HouseQuery& query);
+
+private slots:
+    void dispatch();
+
+private:
+    DatabaseManager* dbManager;
+    QTimer* debounceTimer;
+    HouseQuery pendingQuery;
+    size_t pendingLimit;
+    uint64_t generation;
+    shared_ptr<QueryCanceler> running;
+    vector<future<void>> workers;
+
+    void cancelRunning();
+    void onCompleted(uint64_t searchGeneration, const HouseQuery& query, bool ok, vector<House> houses);
+    void pruneWorkers();
+};
+
+#endif
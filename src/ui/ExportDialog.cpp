@@ -1,4 +1,5 @@
 #include "ExportDialog.h"
+#include "../utils/HouseFields.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGroupBox>
@@ -12,7 +13,7 @@ ExportDialog::ExportDialog(QWidget* parent)
     : QDialog(parent) {
     setupUI();
     setWindowTitle("Экспорт данных");
-    setFixedSize(450, 400); 
+    setFixedSize(450, 590); 
 }
 
 ExportDialog::~ExportDialog() {}
@@ -36,34 +37,33 @@ void ExportDialog::setupUI() {
     QGroupBox* fieldsGroup = new QGroupBox("Выберите поля для экспорта", this);
     QGridLayout* fieldsLayout = new QGridLayout(fieldsGroup);
     
-    idCheck = new QCheckBox("ID", this);
-    addressCheck = new QCheckBox("Адрес", this);
-    apartmentsCheck = new QCheckBox("Количество квартир", this);
-    areaCheck = new QCheckBox("Общая площадь", this);
-    yearCheck = new QCheckBox("Год постройки", this);
-    floorsCheck = new QCheckBox("Этажность", this);
-    ageCheck = new QCheckBox("Возраст дома", this);
-    
-    // По умолчанию выбираем все поля
-    idCheck->setChecked(true);
-    addressCheck->setChecked(true);
-    apartmentsCheck->setChecked(true);
-    areaCheck->setChecked(true);
-    yearCheck->setChecked(true);
-    floorsCheck->setChecked(true);
-    ageCheck->setChecked(true);
-    
-    fieldsLayout->addWidget(idCheck, 0, 0);
-    fieldsLayout->addWidget(addressCheck, 0, 1);
-    fieldsLayout->addWidget(apartmentsCheck, 1, 0);
-    fieldsLayout->addWidget(areaCheck, 1, 1);
-    fieldsLayout->addWidget(yearCheck, 2, 0);
-    fieldsLayout->addWidget(floorsCheck, 2, 1);
-    fieldsLayout->addWidget(ageCheck, 3, 0);
+    // По умолчанию выбираем все поля; по два флажка в строке
+    HouseFields::Exported::forEach([this, fieldsLayout](auto field) {
+        int index = fieldChecks.size();
+        QCheckBox* check = new QCheckBox(decltype(field)::LABEL, this);
+        check->setChecked(true);
+        fieldsLayout->addWidget(check, index / 2, index % 2);
+        fieldChecks.append(check);
+    });
     
     fieldsGroup->setLayout(fieldsLayout);
     
-    QGroupBox* delimiterGroupBox = new QGroupBox("Разделитель для TXT файла", this);
+    QGroupBox* formatGroupBox = new QGroupBox("Формат файла", this);
+    QHBoxLayout* formatLayout = new QHBoxLayout(formatGroupBox);
+    
+    formatGroup = new QButtonGroup(this);
+    QRadioButton* txtRadio = new QRadioButton("Текстовый (TXT)", this);
+    QRadioButton* columnarRadio = new QRadioButton("Колоночный бинарный (HFC)", this);
+    
+    formatGroup->addButton(txtRadio, 0);
+    formatGroup->addButton(columnarRadio, 1);
+    txtRadio->setChecked(true);
+    
+    formatLayout->addWidget(txtRadio);
+    formatLayout->addWidget(columnarRadio);
+    formatGroupBox->setLayout(formatLayout);
+    
+    delimiterGroupBox = new QGroupBox("Разделитель для TXT файла", this);
     QHBoxLayout* delimiterLayout = new QHBoxLayout(delimiterGroupBox);
     
     delimiterGroup = new QButtonGroup(this);
@@ -81,6 +81,17 @@ void ExportDialog::setupUI() {
     delimiterLayout->addWidget(commaRadio);
     delimiterGroupBox->setLayout(delimiterLayout);
 
+    // Сжатие выполняется в фоновом потоке одновременно с выгрузкой
+    QHBoxLayout* compressionLayout = new QHBoxLayout();
+    compressionCombo = new QComboBox(this);
+    compressionCombo->addItem("Без сжатия", 0);
+    compressionCombo->addItem("gzip, быстрое (уровень 1)", 1);
+    compressionCombo->addItem("gzip, стандартное (уровень 6)", 6);
+    compressionCombo->addItem("gzip, максимальное (уровень 9)", 9);
+    compressionLayout->addWidget(new QLabel("Сжатие:", this));
+    compressionLayout->addWidget(compressionCombo);
+    compressionLayout->addStretch();
+    
     QLabel* formatInfo = new QLabel(
         "Формат экспорта: Текстовый файл (.txt)\n"
         "Все данные экспортируются в формате TXT с выбранным разделителем",
@@ -93,6 +104,15 @@ void ExportDialog::setupUI() {
     headerCheck = new QCheckBox("Включать заголовок", this);
     headerCheck->setChecked(true);
     
+    visibleOnlyCheck = new QCheckBox("Только дома, отображаемые в таблице (с фильтрами и сортировкой)", this);
+    visibleOnlyCheck->setChecked(false);
+    
+    parallelCheck = new QCheckBox("Параллельный экспорт (несколько соединений с БД)", this);
+    parallelCheck->setChecked(false);
+    
+    incrementalCheck = new QCheckBox("Только изменения с прошлого экспорта (инкрементально)", this);
+    incrementalCheck->setChecked(false);
+    
     // Кнопки
     QHBoxLayout* buttonLayout = new QHBoxLayout();
     exportButton = new QPushButton("Экспорт в TXT", this);
@@ -104,9 +124,14 @@ void ExportDialog::setupUI() {
   
     mainLayout->addWidget(fileGroup);
     mainLayout->addWidget(fieldsGroup);
+    mainLayout->addWidget(formatGroupBox);
     mainLayout->addWidget(delimiterGroupBox);
+    mainLayout->addLayout(compressionLayout);
     mainLayout->addWidget(formatInfo);
     mainLayout->addWidget(headerCheck);
+    mainLayout->addWidget(visibleOnlyCheck);
+    mainLayout->addWidget(parallelCheck);
+    mainLayout->addWidget(incrementalCheck);
     mainLayout->addLayout(buttonLayout);
     
     setLayout(mainLayout);
@@ -116,20 +141,33 @@ void ExportDialog::setupUI() {
     connect(exportButton, &QPushButton::clicked, this, &ExportDialog::onExportClicked);
     connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
     connect(filePathEdit, &QLineEdit::textChanged, this, &ExportDialog::updateExportButton);
+    connect(visibleOnlyCheck, &QCheckBox::toggled, this, &ExportDialog::updateFormatOptions);
+    connect(incrementalCheck, &QCheckBox::toggled, this, &ExportDialog::updateFormatOptions);
+    connect(formatGroup, &QButtonGroup::idClicked, this, &ExportDialog::updateFormatOptions);
     
     updateExportButton();
+    updateFormatOptions();
 }
 
 void ExportDialog::onBrowseClicked() {
-    QString fileName = QFileDialog::getSaveFileName(this, 
-        "Сохранить как текстовый файл (TXT)", 
-        "houses_export.txt", 
-        "Текстовые файлы (*.txt);;Все файлы (*)"
-    );
+    QString fileName;
+    if (isColumnarFormat()) {
+        fileName = QFileDialog::getSaveFileName(this, 
+            "Сохранить как колоночный файл (HFC)", 
+            "houses_export.hfc", 
+            "Колоночные файлы (*.hfc);;Все файлы (*)"
+        );
+    } else {
+        fileName = QFileDialog::getSaveFileName(this, 
+            "Сохранить как текстовый файл (TXT)", 
+            "houses_export.txt", 
+            "Текстовые файлы (*.txt);;Все файлы (*)"
+        );
+    }
     
     if (!fileName.isEmpty()) {
         if (!fileName.contains('.')) {
-            fileName += ".txt";
+            fileName += isColumnarFormat() ? ".hfc" : ".txt";
         }
         filePathEdit->setText(fileName);
     }
@@ -143,7 +181,8 @@ void ExportDialog::onExportClicked() {
     
     // Проверяем расширение файла - должно быть .txt
     QString filePath = filePathEdit->text();
-    if (!filePath.endsWith(".txt", Qt::CaseInsensitive)) {
+    if (!isColumnarFormat() && !filePath.endsWith(".txt", Qt::CaseInsensitive) &&
+        !filePath.endsWith(".txt.gz", Qt::CaseInsensitive)) {
         int answer = QMessageBox::question(this, 
             "Подтверждение", 
             "Рекомендуется использовать расширение .txt для текстовых файлов.\n"
@@ -163,6 +202,18 @@ void ExportDialog::updateExportButton() {
     exportButton->setEnabled(!filePathEdit->text().isEmpty());
 }
 
+void ExportDialog::updateFormatOptions() {
+    bool columnar = isColumnarFormat();
+    delimiterGroupBox->setEnabled(!columnar);
+    headerCheck->setEnabled(!columnar);
+    compressionCombo->setEnabled(!columnar);
+    bool incremental = !columnar && incrementalCheck->isChecked();
+    incrementalCheck->setEnabled(!columnar && !visibleOnlyCheck->isChecked());
+    visibleOnlyCheck->setEnabled(!incremental);
+    parallelCheck->setEnabled(!columnar && !incremental && !visibleOnlyCheck->isChecked());
+    exportButton->setText(columnar ? "Экспорт в HFC" : "Экспорт в TXT");
+}
+
 QString ExportDialog::getFilePath() const {
     return filePathEdit->text();
 }
@@ -170,13 +221,10 @@ QString ExportDialog::getFilePath() const {
 QStringList ExportDialog::getSelectedFields() const {
     QStringList fields;
     
-    if (idCheck->isChecked()) fields << "id";
-    if (addressCheck->isChecked()) fields << "address";
-    if (apartmentsCheck->isChecked()) fields << "apartments";
-    if (areaCheck->isChecked()) fields << "total_area";
-    if (yearCheck->isChecked()) fields << "build_year";
-    if (floorsCheck->isChecked()) fields << "floors";
-    if (ageCheck->isChecked()) fields << "age";
+    int index = 0;
+    HouseFields::Exported::forEach([this, &fields, &index](auto field) {
+        if (fieldChecks[index++]->isChecked()) fields << decltype(field)::NAME;
+    });
     
     return fields;
 }
@@ -193,3 +241,25 @@ QString ExportDialog::getDelimiter() const {
 bool ExportDialog::includeHeader() const {
     return headerCheck->isChecked();
 }
+
+bool ExportDialog::exportVisibleOnly() const {
+    return visibleOnlyCheck->isEnabled() && visibleOnlyCheck->isChecked();
+}
+
+bool ExportDialog::useParallelExport() const {
+    return parallelCheck->isEnabled() && parallelCheck->isChecked();
+}
+
+bool ExportDialog::isColumnarFormat() const {
+    return formatGroup->checkedId() == 1;
+}
+
+int ExportDialog::compressionLevel() const {
+    // Колоночный файл читается через mmap, поэтому не сжимается
+    if (isColumnarFormat()) return 0;
+    return compressionCombo->currentData().toInt();
+}
+
+bool ExportDialog::isIncremental() const {
+    return incrementalCheck->isEnabled() && incrementalCheck->isChecked();
+}
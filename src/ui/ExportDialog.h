@@ -10,6 +10,8 @@
 #include <QRadioButton>   
 #include <QLabel>         
 #include <QGridLayout>    
+#include <QComboBox>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE
 QT_END_NAMESPACE
@@ -25,11 +27,17 @@ public:
     QStringList getSelectedFields() const;
     QString getDelimiter() const;
     bool includeHeader() const;
+    bool exportVisibleOnly() const;
+    bool useParallelExport() const;
+    bool isColumnarFormat() const;
+    int compressionLevel() const;
+    bool isIncremental() const;
 
 private slots:
     void onBrowseClicked();
     void onExportClicked();
     void updateExportButton();
+    void updateFormatOptions();
 
 private:
     QLineEdit* filePathEdit;
@@ -37,16 +45,17 @@ private:
     QPushButton* exportButton;
     QPushButton* cancelButton;
     
-    QCheckBox* idCheck;
-    QCheckBox* addressCheck;
-    QCheckBox* apartmentsCheck;
-    QCheckBox* areaCheck;
-    QCheckBox* yearCheck;
-    QCheckBox* floorsCheck;
-    QCheckBox* ageCheck;
+    // Флажки полей в порядке HouseFields::Exported
+    QVector<QCheckBox*> fieldChecks;
     QCheckBox* headerCheck;
+    QCheckBox* visibleOnlyCheck;
+    QCheckBox* parallelCheck;
+    QCheckBox* incrementalCheck;
     
     QButtonGroup* delimiterGroup;
+    QButtonGroup* formatGroup;
+    QGroupBox* delimiterGroupBox;
+    QComboBox* compressionCombo;
     
     void setupUI();
 };
@@ -0,0 +1,258 @@
+#include "HouseLoader.h"
+#include "../config/Config.h"
+#include <QTimer>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+HouseLoader::HouseLoader(DatabaseManager* dbManager, QObject* parent)
+    : QObject(parent), dbManager(dbManager), cachePath(Config::getSnapshotCachePath()),
+      sharedName(Config::getSharedSnapshotName()), sharedOwner(0), sharedEpoch(0), generation(0),
+      loading(false), outdatedPages(false), received(0), expected(-1), retainResults(false) {
+    if (sharedName.empty()) return;
+
+    if (!SharedSnapshot::resolveUser(Config::getSharedSnapshotOwner(), sharedOwner)) {
+        cerr << "Нет пользователя-издателя общего снимка " << Config::getSharedSnapshotOwner()
+             << ", общий снимок не используется" << endl;
+        sharedName.clear();
+        return;
+    }
+
+    // Номер эпохи читается из управляющего сегмента без отображения самого снимка
+    QTimer* poll = new QTimer(this);
+    connect(poll, &QTimer::timeout, this, &HouseLoader::checkSharedEpoch);
+    poll->start(SHARED_POLL_MS);
+}
+
+HouseLoader::~HouseLoader() {
+    cancel();
+    for (auto& worker : workers) {
+        worker.wait();
+    }
+}
+
+void HouseLoader::start() {
+    pruneWorkers();
+    cancelRunning();
+
+    uint64_t loadGeneration = ++generation;
+    shared_ptr<QueryCanceler> canceler = make_shared<QueryCanceler>();
+    running = canceler;
+    loading = true;
+    outdatedPages = false;
+    received = 0;
+    expected = -1;
+    retainedRows.clear();
+    retainedSnapshot.reset();
+
+    workers.push_back(async(launch::async, [this, loadGeneration, canceler]() {
+        load(loadGeneration, canceler);
+    }));
+}
+
+void HouseLoader::cancel() {
+    generation++;
+    loading = false;
+    cancelRunning();
+}
+
+bool HouseLoader::isLoading() const {
+    return loading;
+}
+
+void HouseLoader::setRetainResults(bool retain) {
+    retainResults = retain;
+    if (!retain) {
+        retainedRows.clear();
+        retainedSnapshot.reset();
+    }
+}
+
+HouseTable HouseLoader::takeRetainedRows() {
+    HouseTable rows = move(retainedRows);
+    retainedRows.clear();
+    return rows;
+}
+
+shared_ptr<HouseSnapshot> HouseLoader::takeSnapshot() {
+    return move(retainedSnapshot);
+}
+
+bool HouseLoader::pagesOutdated() const {
+    return outdatedPages;
+}
+
+size_t HouseLoader::receivedRows() const {
+    return received;
+}
+
+long long HouseLoader::expectedRows() const {
+    return expected;
+}
+
+void HouseLoader::load(uint64_t loadGeneration, shared_ptr<QueryCanceler> canceler) {
+    // Выполняется в рабочем потоке: только соединения пула и локальные данные
+    bool useSaved = !cachePath.empty() || !sharedName.empty();
+    string source = useSaved ? dbManager->databaseIdentity() : string();
+    shared_ptr<SnapshotCache> saved = make_shared<SnapshotCache>();
+    SnapshotCache fresh;
+    SnapshotCache* result = &fresh;
+    shared_ptr<HouseSnapshot> snapshot;
+    bool ok = false;
+    bool outdated = false;
+
+    // Общий снимок издателя на этом сервере: столбцы и индексы читаются прямо
+    // из сегмента, в снимок вносятся только изменения после его метки
+    SharedSnapshot::Attached attached;
+    bool shared = !source.empty() && !sharedName.empty() &&
+                  SharedSnapshot::attach(sharedName, sharedOwner, attached) && attached.source == source;
+    if (shared) {
+        HouseChanges changes;
+        ok = dbManager->fetchHouseChanges(attached.watermark, changes, canceler.get());
+        if (ok && changes.complete) {
+            for (size_t i = 0; i < changes.changed.size(); ++i) {
+                attached.snapshot->update(changes.changed.house(i));
+            }
+            for (int id : changes.removedIds) {
+                attached.snapshot->remove(id);
+            }
+            snapshot = attached.snapshot;
+        } else if (ok) {
+            ok = loadAll(loadGeneration, canceler.get(), true, fresh);
+        }
+        // Страниц снимка не было: вид строится по снимку
+        outdated = true;
+    } else if (!source.empty() && !cachePath.empty() &&
+               SnapshotCache::load(cachePath, *saved) && saved->source == source) {
+        // Сохраненный снимок показывается сразу, с сервера приходят только изменения
+        postPage(loadGeneration, static_cast<long long>(saved->houses.size()),
+                 shared_ptr<const HouseTable>(saved, &saved->houses));
+
+        HouseChanges changes;
+        ok = dbManager->fetchHouseChanges(saved->watermark, changes, canceler.get());
+        if (ok && !changes.complete) {
+            // Удаления после метки не восстановить: все заново, вид обновится по снимку
+            ok = loadAll(loadGeneration, canceler.get(), false, fresh);
+            outdated = true;
+        } else if (ok && (!changes.changed.empty() || !changes.removedIds.empty())) {
+            SnapshotCache::merge(saved->houses, changes.changed, changes.removedIds, fresh.houses);
+            fresh.watermark = changes.watermark;
+            outdated = true;
+        } else if (ok) {
+            // Строки saved в это время читает окно; метка - отдельное поле
+            saved->watermark = changes.watermark;
+            result = saved.get();
+        }
+    } else {
+        ok = loadAll(loadGeneration, canceler.get(), true, fresh);
+    }
+
+    if (ok && !snapshot && !canceler->isCanceled()) {
+        snapshot = make_shared<HouseSnapshot>();
+        snapshot->build(result->houses);
+    }
+    uint64_t epoch = shared ? attached.epoch : 0;
+    QMetaObject::invokeMethod(this, [this, loadGeneration, ok, outdated, epoch, snapshot]() {
+        onCompleted(loadGeneration, ok, outdated, epoch, snapshot);
+    }, Qt::QueuedConnection);
+
+    // Файл записывается после передачи снимка окну, чтобы не задерживать его.
+    // Общий снимок поддерживает издатель, своя копия на диске не нужна
+    if (snapshot && !shared && !cachePath.empty() && !source.empty() && !result->watermark.empty()) {
+        result->source = source;
+        if (!result->save(cachePath)) {
+            cerr << "Ошибка записи локального снимка: " << cachePath << endl;
+        }
+    }
+}
+
+bool HouseLoader::loadAll(uint64_t loadGeneration, QueryCanceler* canceler, bool publish, SnapshotCache& loaded) {
+    // Метка до первой страницы: изменения во время загрузки придут со следующей синхронизацией
+    if (!cachePath.empty() && !dbManager->currentHouseWatermark(loaded.watermark)) {
+        loaded.watermark.clear();
+    }
+    long long estimate = dbManager->estimateHouseCount();
+
+    HouseQuery query;
+    HouseTable& all = loaded.houses;
+    if (estimate > 0) all.reserve(static_cast<size_t>(estimate));
+
+    House last;
+    size_t limit = FIRST_PAGE_SIZE;
+    while (!canceler->isCanceled()) {
+        HouseTable page;
+        if (!dbManager->fetchHousePage(query, all.empty() ? nullptr : &last, limit, page, canceler)) {
+            return false;
+        }
+        bool lastPage = page.size() < limit;
+        if (!page.empty()) last = page.house(page.size() - 1);
+        all.append(page);
+
+        if (publish) postPage(loadGeneration, estimate, make_shared<const HouseTable>(move(page)));
+
+        if (lastPage) break;
+        limit = PAGE_SIZE;
+    }
+    return true;
+}
+
+void HouseLoader::postPage(uint64_t loadGeneration, long long estimate, shared_ptr<const HouseTable> page) {
+    QMetaObject::invokeMethod(this, [this, loadGeneration, estimate, page]() {
+        onPageLoaded(loadGeneration, estimate, *page);
+    }, Qt::QueuedConnection);
+}
+
+void HouseLoader::onPageLoaded(uint64_t loadGeneration, long long estimate, const HouseTable& page) {
+    // Страница прерванной загрузки
+    if (loadGeneration != generation) return;
+
+    received += page.size();
+    expected = estimate;
+    if (retainResults) retainedRows.append(page);
+    emit pageLoaded(page);
+}
+
+void HouseLoader::onCompleted(uint64_t loadGeneration, bool ok, bool outdated, uint64_t epoch, shared_ptr<HouseSnapshot> snapshot) {
+    if (loadGeneration != generation) return;
+
+    loading = false;
+    outdatedPages = outdated;
+    sharedEpoch = epoch;
+    running.reset();
+    if (retainResults) retainedSnapshot = snapshot;
+    if (ok && snapshot) {
+        emit finished(snapshot);
+    } else {
+        emit failed();
+    }
+}
+
+void HouseLoader::checkSharedEpoch() {
+    if (loading) return;
+
+    // 0 - издатель завершился: окно продолжает работать с прежним снимком
+    uint64_t current = SharedSnapshot::currentEpoch(sharedName, sharedOwner);
+    if (current != 0 && current != sharedEpoch) {
+        sharedEpoch = current;
+        emit sharedSnapshotChanged();
+    }
+}
+
+void HouseLoader::cancelRunning() {
+    if (!running) return;
+
+    // PQcancel открывает отдельное соединение, поэтому выполняется в фоне
+    shared_ptr<QueryCanceler> canceler = move(running);
+    running.reset();
+    workers.push_back(async(launch::async, [canceler]() {
+        canceler->cancel();
+    }));
+}
+
+void HouseLoader::pruneWorkers() {
+    workers.erase(remove_if(workers.begin(), workers.end(), [](const future<void>& worker) {
+        return worker.wait_for(chrono::seconds(0)) == future_status::ready;
+    }), workers.end());
+}
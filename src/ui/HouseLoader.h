@@ -0,0 +1,93 @@
+#ifndef HOUSELOADER_H
+#define HOUSELOADER_H
+
+#include <QObject>
+#include <vector>
+#include <memory>
+#include <future>
+#include <cstdint>
+#include "../database/DatabaseManager.h"
+#include "../utils/HouseTable.h"
+#include "../utils/HouseSnapshot.h"
+#include "../utils/SnapshotCache.h"
+#include "../utils/SharedSnapshot.h"
+
+using namespace std;
+
+// Загрузка всех домов в фоне: страницы по id передаются окну по мере
+// получения, после последней в том же потоке строится снимок с индексами.
+// Окно показывается сразу и заполняется, не дожидаясь всего фонда.
+// Общий снимок издателя на этом сервере окно получает сразу готовым: он
+// читается из общей памяти без копии. Локальный снимок той же базы окно
+// получает одной страницей. В обоих случаях с сервера запрашиваются только
+// изменения после метки снимка. Новую эпоху общего снимка загрузчик замечает
+// опросом и сообщает окну
+class HouseLoader : public QObject {
+    Q_OBJECT
+
+public:
+    // Первая страница небольшая, чтобы таблица заполнилась сразу
+    static constexpr size_t FIRST_PAGE_SIZE = 1000;
+    static constexpr size_t PAGE_SIZE = 20000;
+    // Период опроса эпохи общего снимка
+    static constexpr int SHARED_POLL_MS = 2000;
+
+    explicit HouseLoader(DatabaseManager* dbManager, QObject* parent = nullptr);
+    ~HouseLoader();
+
+    // Загрузка заново; идущая загрузка прерывается, ее страницы отбрасываются
+    void start();
+    void cancel();
+    bool isLoading() const;
+
+    // Загрузка до появления окна (во время входа): полученные строки и готовый
+    // снимок сохраняются, пока их не заберет окно
+    void setRetainResults(bool retain);
+    HouseTable takeRetainedRows();
+    shared_ptr<HouseSnapshot> takeSnapshot();
+
+    // Строки, переданные страницами, расходятся со снимком (локальный снимок
+    // обновлен изменениями с сервера): вид нужно построить по снимку
+    bool pagesOutdated() const;
+
+    size_t receivedRows() const;
+    // Оценка числа домов по статистике таблицы; -1, если неизвестно
+    long long expectedRows() const;
+
+signals:
+    void pageLoaded(const HouseTable& page);
+    void finished(shared_ptr<HouseSnapshot> snapshot);
+    void failed();
+    // Издатель опубликовал новую эпоху общего снимка; загрузка не идет
+    void sharedSnapshotChanged();
+
+private:
+    DatabaseManager* dbManager;
+    string cachePath;
+    string sharedName;
+    uid_t sharedOwner;
+    // Эпоха общего снимка, из которой получен последний снимок; 0 - не общий
+    uint64_t sharedEpoch;
+    uint64_t generation;
+    bool loading;
+    bool outdatedPages;
+    size_t received;
+    long long expected;
+    bool retainResults;
+    HouseTable retainedRows;
+    shared_ptr<HouseSnapshot> retainedSnapshot;
+    shared_ptr<QueryCanceler> running;
+    vector<future<void>> workers;
+
+    void load(uint64_t loadGeneration, shared_ptr<QueryCanceler> canceler);
+    // Все дома страницами по id; publish - передавать страницы окну
+    bool loadAll(uint64_t loadGeneration, QueryCanceler* canceler, bool publish, SnapshotCache& loaded);
+    void postPage(uint64_t loadGeneration, long long estimate, shared_ptr<const HouseTable> page);
+    void onPageLoaded(uint64_t loadGeneration, long long estimate, const HouseTable& page);
+    void onCompleted(uint64_t loadGeneration, bool ok, bool outdated, uint64_t epoch, shared_ptr<HouseSnapshot> snapshot);
+    void checkSharedEpoch();
+    void cancelRunning();
+    void pruneWorkers();
+};
+
+#endif
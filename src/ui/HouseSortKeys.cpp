@@ -0,0 +1,327 @@
+#include "HouseSortKeys.h"
+#include "HouseTableModel.h"
+#include <QLocale>
+#include <algorithm>
+#include <numeric>
+#include <array>
+#include <future>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// Адрес (место), квартиры, площадь, год и этажность: 4 + 4 + 8 + 4 + 4
+const size_t MAX_KEY_BYTES = 24;
+const size_t KEY_WORDS = MAX_KEY_BYTES / 8;
+
+// Байтовый ключ хранится словами старшим байтом вперед: сравнение слов
+// дает тот же порядок, что memcmp байтов, но без вызова на каждое сравнение
+struct SortEntry {
+    uint64_t key[KEY_WORDS];
+    uint32_t slot;
+};
+
+// Меньше строк на поток - запуск потоков дороже самой работы
+const size_t PARALLEL_MIN_ROWS = 65536;
+// Небольшие выборки быстрее сортируются сравнениями, чем проходами по 256 корзинам
+const size_t RADIX_MIN_ROWS = 4096;
+
+// maxWorkers == 0 - по числу ядер
+size_t workerCount(size_t rows, size_t maxWorkers) {
+    if (rows < 2 * PARALLEL_MIN_ROWS) return 1;
+    size_t cores = maxWorkers > 0 ? maxWorkers : max<unsigned>(1, thread::hardware_concurrency());
+    return min(cores, rows / PARALLEL_MIN_ROWS);
+}
+
+// task(часть, начало, конец) для равных частей [0, count); часть 0 - в текущем потоке
+template <typename Task>
+void forEachChunk(size_t count, size_t workers, const Task& task) {
+    vector<future<void>> running;
+    for (size_t w = 1; w < workers; ++w) {
+        running.push_back(async(launch::async, [&task, w, count, workers]() {
+            task(w, count * w / workers, count * (w + 1) / workers);
+        }));
+    }
+    task(0, 0, count / workers);
+    for (auto& worker : running) worker.get();
+}
+
+unsigned keyByte(const SortEntry& entry, size_t byte) {
+    return (entry.key[byte / 8] >> (56 - 8 * (byte % 8))) & 0xFF;
+}
+
+// Поразрядная сортировка LSD по байтам ключа, от младшего к старшему.
+// Каждый проход устойчив, поэтому равные ключи сохраняют входной порядок
+void radixSort(vector<SortEntry>& entries, size_t keyBytes, size_t maxWorkers) {
+    const size_t count = entries.size();
+    const size_t workers = workerCount(count, maxWorkers);
+
+    // Гистограммы всех байтов за один проход: байты, одинаковые у всех строк
+    // (например, старшие байты небольших чисел), пропускаются без чтения данных
+    vector<vector<array<size_t, 256>>> partial(workers, vector<array<size_t, 256>>(keyBytes));
+    forEachChunk(count, workers, [&](size_t w, size_t begin, size_t end) {
+        for (auto& histogram : partial[w]) histogram.fill(0);
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t byte = 0; byte < keyBytes; ++byte) partial[w][byte][keyByte(entries[i], byte)]++;
+        }
+    });
+    vector<array<size_t, 256>> totals = partial[0];
+    for (size_t w = 1; w < workers; ++w) {
+        for (size_t byte = 0; byte < keyBytes; ++byte) {
+            for (unsigned digit = 0; digit < 256; ++digit) totals[byte][digit] += partial[w][byte][digit];
+        }
+    }
+
+    vector<SortEntry> buffer(count);
+    vector<array<size_t, 256>> counts(workers);
+    for (size_t byte = keyBytes; byte-- > 0;) {
+        if (count_if(totals[byte].begin(), totals[byte].end(), [](size_t n) { return n != 0; }) == 1) continue;
+
+        // В одном потоке гистограмма от порядка строк не зависит; частям
+        // нужны свои счетчики по текущему порядку
+        if (workers == 1) {
+            counts[0] = totals[byte];
+        } else {
+            forEachChunk(count, workers, [&](size_t w, size_t begin, size_t end) {
+                counts[w].fill(0);
+                for (size_t i = begin; i < end; ++i) counts[w][keyByte(entries[i], byte)]++;
+            });
+        }
+
+        // Смещения по цифре, внутри цифры - по порядку частей
+        size_t offset = 0;
+        for (unsigned digit = 0; digit < 256; ++digit) {
+            for (size_t w = 0; w < workers; ++w) {
+                size_t size = counts[w][digit];
+                counts[w][digit] = offset;
+                offset += size;
+            }
+        }
+
+        forEachChunk(count, workers, [&](size_t w, size_t begin, size_t end) {
+            array<size_t, 256>& next = counts[w];
+            for (size_t i = begin; i < end; ++i) {
+                buffer[next[keyByte(entries[i], byte)]++] = entries[i];
+            }
+        });
+        entries.swap(buffer);
+    }
+}
+
+// Сортировка частей в потоках и попарное слияние частей, тоже параллельное
+template <typename Less>
+void parallelMergeSort(vector<uint32_t>& items, const Less& less, size_t maxWorkers) {
+    const size_t count = items.size();
+    const size_t workers = workerCount(count, maxWorkers);
+    forEachChunk(count, workers, [&](size_t, size_t begin, size_t end) {
+        std::sort(items.begin() + begin, items.begin() + end, less);
+    });
+    if (workers == 1) return;
+
+    vector<size_t> bounds;
+    for (size_t w = 0; w <= workers; ++w) bounds.push_back(count * w / workers);
+
+    vector<uint32_t> buffer(count);
+    while (bounds.size() > 2) {
+        vector<size_t> merged{0};
+        vector<future<void>> running;
+        for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+            size_t begin = bounds[i];
+            size_t middle = bounds[i + 1];
+            size_t end = i + 2 < bounds.size() ? bounds[i + 2] : middle;
+            running.push_back(async(launch::async, [&items, &buffer, &less, begin, middle, end]() {
+                merge(items.begin() + begin, items.begin() + middle,
+                      items.begin() + middle, items.begin() + end,
+                      buffer.begin() + begin, less);
+            }));
+            merged.push_back(end);
+        }
+        for (auto& worker : running) worker.get();
+        items.swap(buffer);
+        bounds = move(merged);
+    }
+}
+
+uint64_t loadBigEndian(const unsigned char* bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+// Числа записываются старшим байтом вперед, чтобы memcmp давал числовой порядок
+void putUint32(unsigned char* out, uint32_t value) {
+    for (int i = 3; i >= 0; --i) {
+        out[i] = static_cast<unsigned char>(value);
+        value >>= 8;
+    }
+}
+
+void putUint64(unsigned char* out, uint64_t value) {
+    for (int i = 7; i >= 0; --i) {
+        out[i] = static_cast<unsigned char>(value);
+        value >>= 8;
+    }
+}
+
+uint32_t orderedInt(int value) {
+    return static_cast<uint32_t>(value) ^ 0x80000000u;
+}
+
+uint64_t orderedInt64(int64_t value) {
+    return static_cast<uint64_t>(value) ^ 0x8000000000000000ull;
+}
+
+// Запись ключа одного столбца строки; возвращает позицию после него
+typedef unsigned char* (*KeyWriter)(const HouseColumnStore& store, const vector<uint32_t>& addressRanks,
+                                    uint32_t row, unsigned char* out);
+
+unsigned char* writeAddressKey(const HouseColumnStore& store, const vector<uint32_t>& addressRanks,
+                               uint32_t row, unsigned char* out) {
+    putUint32(out, addressRanks[store.addressCode(row)]);
+    return out + 4;
+}
+
+template <HouseColumnStore::Column COLUMN>
+unsigned char* writeInt32Key(const HouseColumnStore& store, const vector<uint32_t>&, uint32_t row, unsigned char* out) {
+    putUint32(out, orderedInt(static_cast<int>(store.value(row, COLUMN))));
+    return out + 4;
+}
+
+template <HouseColumnStore::Column COLUMN>
+unsigned char* writeInt64Key(const HouseColumnStore& store, const vector<uint32_t>&, uint32_t row, unsigned char* out) {
+    putUint64(out, orderedInt64(store.value(row, COLUMN)));
+    return out + 8;
+}
+
+// Функция и длина ключа по столбцу модели; id в ключ не входит
+struct KeyColumn {
+    KeyWriter write;
+    size_t bytes;
+};
+
+const KeyColumn KEY_COLUMNS[HouseTableModel::COLUMN_COUNT] = {
+    {nullptr, 0},
+    {writeAddressKey, 4},
+    {writeInt32Key<HouseColumnStore::APARTMENTS>, 4},
+    {writeInt64Key<HouseColumnStore::TOTAL_AREA>, 8},
+    {writeInt32Key<HouseColumnStore::BUILD_YEAR>, 4},
+    {writeInt32Key<HouseColumnStore::FLOORS>, 4}
+};
+
+}
+
+HouseSortKeys::HouseSortKeys()
+    : collator(QLocale(QLocale::Russian, QLocale::Russia)), ranksValid(false), maxWorkers(0) {
+    // "д. 9" раньше "д. 10"
+    collator.setNumericMode(true);
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+}
+
+void HouseSortKeys::clear() {
+    addressKeys.clear();
+    addressRanks.clear();
+    ranksValid = false;
+}
+
+void HouseSortKeys::setMaxWorkers(size_t workers) {
+    maxWorkers = workers;
+}
+
+void HouseSortKeys::prepareAddresses(const HouseColumnStore& store) {
+    if (addressKeys.size() > store.dictionarySize()) clear();
+    if (addressKeys.size() < store.dictionarySize()) {
+        // Преобразование в UTF-16 и построение ключа - по одному разу на адрес;
+        // правки только дописывают адреса в словарь
+        addressKeys.reserve(store.dictionarySize());
+        for (uint32_t code = static_cast<uint32_t>(addressKeys.size()); code < store.dictionarySize(); ++code) {
+            string_view address = store.dictionaryEntry(code);
+            addressKeys.push_back(collator.sortKey(QString::fromUtf8(address.data(), static_cast<qsizetype>(address.size()))));
+        }
+        ranksValid = false;
+    }
+    if (ranksValid) return;
+
+    // Ключи сопоставления сравниваются только между собой, поэтому здесь
+    // сортировка слиянием, а строки целиком дальше сортируются поразрядно
+    vector<uint32_t> order(addressKeys.size());
+    iota(order.begin(), order.end(), 0);
+    parallelMergeSort(order, [this](uint32_t a, uint32_t b) {
+        return addressKeys[a].compare(addressKeys[b]) < 0;
+    }, maxWorkers);
+
+    addressRanks.assign(addressKeys.size(), 0);
+    uint32_t rank = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i > 0 && addressKeys[order[i - 1]].compare(addressKeys[order[i]]) != 0) rank++;
+        addressRanks[order[i]] = rank;
+    }
+    ranksValid = true;
+}
+
+void HouseSortKeys::sort(vector<uint32_t>& positions, const HouseColumnStore& store,
+                         const vector<HouseSortKey>& keys) {
+    // Повтор столбца ничего не меняет в порядке, поэтому ключ не длиннее MAX_KEY_BYTES
+    vector<HouseSortKey> columns;
+    for (const HouseSortKey& key : keys) {
+        bool known = key.column >= HouseTableModel::COLUMN_ADDRESS && key.column <= HouseTableModel::COLUMN_FLOORS;
+        bool repeated = any_of(columns.begin(), columns.end(),
+                               [&key](const HouseSortKey& c) { return c.column == key.column; });
+        if (known && !repeated) columns.push_back(key);
+    }
+    if (columns.empty() || positions.size() < 2) return;
+
+    bool byAddress = any_of(columns.begin(), columns.end(),
+                            [](const HouseSortKey& c) { return c.column == HouseTableModel::COLUMN_ADDRESS; });
+    if (byAddress) prepareAddresses(store);
+
+    // Функции записи выбираются один раз, в цикле по строкам нет ветвления по столбцу
+    vector<KeyWriter> writers;
+    vector<bool> descending;
+    size_t keyBytes = 0;
+    for (const HouseSortKey& column : columns) {
+        writers.push_back(KEY_COLUMNS[column.column].write);
+        descending.push_back(!column.ascending);
+        keyBytes += KEY_COLUMNS[column.column].bytes;
+    }
+
+    vector<SortEntry> entries(positions.size());
+    forEachChunk(entries.size(), workerCount(entries.size(), maxWorkers), [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t row = positions[i];
+            SortEntry& entry = entries[i];
+            entry.slot = row;
+
+            unsigned char bytes[MAX_KEY_BYTES] = {};
+            unsigned char* out = bytes;
+            for (size_t k = 0; k < writers.size(); ++k) {
+                unsigned char* start = out;
+                out = writers[k](store, addressRanks, row, out);
+                // Убывание - инверсия байтов столбца
+                if (descending[k]) {
+                    for (unsigned char* p = start; p < out; ++p) *p = ~*p;
+                }
+            }
+            for (size_t w = 0; w < KEY_WORDS; ++w) {
+                entry.key[w] = loadBigEndian(bytes + w * 8);
+            }
+        }
+    });
+
+    if (entries.size() >= RADIX_MIN_ROWS) {
+        radixSort(entries, keyBytes, maxWorkers);
+    } else {
+        stable_sort(entries.begin(), entries.end(), [](const SortEntry& a, const SortEntry& b) {
+            for (size_t w = 0; w < KEY_WORDS; ++w) {
+                if (a.key[w] != b.key[w]) return a.key[w] < b.key[w];
+            }
+            return false;
+        });
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        positions[i] = entries[i].slot;
+    }
+}
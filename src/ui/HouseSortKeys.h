@@ -0,0 +1,42 @@
+#ifndef HOUSESORTKEYS_H
+#define HOUSESORTKEYS_H
+
+#include <QCollator>
+#include <vector>
+#include <cstdint>
+#include "../database/DatabaseManager.h"
+#include "../utils/HouseColumnStore.h"
+
+using namespace std;
+
+// Сортировка домов снимка по нескольким столбцам. Адреса сравниваются по
+// правилам русской локали: ключ сопоставления строится один раз на строку
+// словаря адресов снимка, а все ключи сортировки строки собираются в
+// байтовую строку фиксированной длины, которая сравнивается через memcmp
+class HouseSortKeys {
+public:
+    HouseSortKeys();
+
+    // Снимок заменен: ключи будут построены заново при сортировке по адресу
+    void clear();
+
+    // Упорядочивает строки снимка; равные строки сохраняют исходный порядок.
+    // Новые адреса словаря (после правок) получают ключи при следующем вызове
+    void sort(vector<uint32_t>& positions, const HouseColumnStore& store, const vector<HouseSortKey>& keys);
+
+    // Не больше workers потоков на сортировку; 0 - по числу ядер
+    void setMaxWorkers(size_t workers);
+
+private:
+    QCollator collator;
+    // По коду словаря адресов
+    vector<QCollatorSortKey> addressKeys;
+    // Место адреса в порядке сопоставления; одинаковые адреса - одно место
+    vector<uint32_t> addressRanks;
+    bool ranksValid;
+    size_t maxWorkers;
+
+    void prepareAddresses(const HouseColumnStore& store);
+};
+
+#endif
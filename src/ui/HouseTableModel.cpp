@@ -0,0 +1,177 @@
+#include "HouseTableModel.h"
+#include "../utils/HouseFields.h"
+
+using namespace std;
+
+namespace {
+
+// Текст ячейки по типу значения
+QString displayText(int value) {
+    return QString::number(value);
+}
+
+QString displayText(Area value) {
+    // Точное значение без перевода в double; буфер потока переиспользуется
+    thread_local string text;
+    text.clear();
+    value.appendTo(text);
+    return QString::fromLatin1(text.data(), static_cast<qsizetype>(text.size()));
+}
+
+QString displayText(string_view value) {
+    return QString::fromUtf8(value.data(), static_cast<qsizetype>(value.size()));
+}
+
+typedef QString (*CellText)(const HouseTable& houses, size_t row);
+typedef QString (*StoreText)(const HouseColumnStore& store, size_t row);
+typedef QString (*HouseText)(const House& house);
+
+template <typename Field, typename Source>
+QString cellText(const Source& source, size_t row) {
+    return displayText(Field::value(source, row, 0));
+}
+
+template <typename Field>
+QString houseText(const House& house) {
+    return displayText(house.*Field::MEMBER);
+}
+
+template <typename Field> struct CellTextOf { static constexpr CellText VALUE = cellText<Field, HouseTable>; };
+template <typename Field> struct StoreTextOf { static constexpr StoreText VALUE = cellText<Field, HouseColumnStore>; };
+template <typename Field> struct HouseTextOf { static constexpr HouseText VALUE = houseText<Field>; };
+template <typename Field> struct TitleOf { static constexpr const char* VALUE = Field::TITLE; };
+
+// Столбцы модели - хранимые поля дома в порядке HouseFields::Stored
+static_assert(HouseFields::Stored::COUNT == HouseTableModel::COLUMN_COUNT,
+              "столбцы модели должны совпадать с HouseFields::Stored");
+
+constexpr auto CELL_TEXT = HouseFields::Stored::table<CellText, CellTextOf>();
+constexpr auto STORE_TEXT = HouseFields::Stored::table<StoreText, StoreTextOf>();
+constexpr auto HOUSE_TEXT = HouseFields::Stored::table<HouseText, HouseTextOf>();
+constexpr auto TITLES = HouseFields::Stored::table<const char*, TitleOf>();
+
+bool isColumn(int column) {
+    return column >= 0 && column < HouseTableModel::COLUMN_COUNT;
+}
+
+}
+
+HouseTableModel::HouseTableModel(QObject* parent)
+    : QAbstractTableModel(parent) {}
+
+int HouseTableModel::rowCount(const QModelIndex& parent) const {
+    if (parent.isValid()) return 0;
+    return static_cast<int>(snapshot ? positions.size() : table.size());
+}
+
+int HouseTableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant HouseTableModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= rowCount()) return QVariant();
+    int row = index.row();
+
+    if (role == Qt::UserRole) {
+        return houseId(row);
+    }
+    if (role != Qt::DisplayRole) return QVariant();
+
+    if (!isColumn(index.column())) return QVariant();
+    if (snapshot) return STORE_TEXT[index.column()](snapshot->houses, positions[row]);
+    return CELL_TEXT[index.column()](table, row);
+}
+
+QVariant HouseTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole) return QVariant();
+    if (orientation == Qt::Vertical) return section + 1;
+    return columnTitle(section);
+}
+
+QVariant HouseTableModel::columnTitle(int section) {
+    return isColumn(section) ? QVariant(TITLES[section]) : QVariant();
+}
+
+QVariant HouseTableModel::displayValue(const House& house, int column) {
+    return isColumn(column) ? QVariant(HOUSE_TEXT[column](house)) : QVariant();
+}
+
+bool HouseTableModel::removeRows(int row, int count, const QModelIndex& parent) {
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > rowCount()) return false;
+
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+    if (snapshot) positions.erase(positions.begin() + row, positions.begin() + row + count);
+    else table.erase(row, count);
+    endRemoveRows();
+    return true;
+}
+
+void HouseTableModel::setHouses(HouseTable houses) {
+    beginResetModel();
+    table = move(houses);
+    snapshot.reset();
+    positions = vector<uint32_t>();
+    endResetModel();
+}
+
+void HouseTableModel::setRows(shared_ptr<const HouseSnapshot> rows, vector<uint32_t> order) {
+    beginResetModel();
+    table = HouseTable();
+    snapshot = move(rows);
+    positions = move(order);
+    endResetModel();
+}
+
+void HouseTableModel::clear() {
+    setHouses(HouseTable());
+}
+
+void HouseTableModel::updateHouse(int row, const House& house) {
+    if (row < 0 || row >= rowCount()) return;
+
+    if (!snapshot) table.set(row, house);
+    emit dataChanged(index(row, 0), index(row, COLUMN_COUNT - 1));
+}
+
+void HouseTableModel::appendHouse(const House& house) {
+    // Строки снимка добавляет его владелец, затем модель получает новый список
+    if (snapshot) return;
+
+    int row = rowCount();
+    beginInsertRows(QModelIndex(), row, row);
+    table.append(house);
+    endInsertRows();
+}
+
+void HouseTableModel::appendHouses(const HouseTable& houses) {
+    if (houses.empty() || snapshot) return;
+
+    int row = rowCount();
+    beginInsertRows(QModelIndex(), row, row + static_cast<int>(houses.size()) - 1);
+    table.append(houses);
+    endInsertRows();
+}
+
+int HouseTableModel::houseId(int row) const {
+    if (row < 0 || row >= rowCount()) return 0;
+    return snapshot ? static_cast<int>(snapshot->houses.value(positions[row], HouseColumnStore::ID)) : table.id(row);
+}
+
+int HouseTableModel::rowOfHouse(int id) const {
+    for (int row = 0; row < rowCount(); ++row) {
+        if (houseId(row) == id) return row;
+    }
+    return -1;
+}
+
+House HouseTableModel::houseAt(int row) const {
+    if (row < 0 || row >= rowCount()) return House();
+    return snapshot ? snapshot->houses.house(positions[row]) : table.house(row);
+}
+
+const HouseTable& HouseTableModel::houses(HouseTable& extracted) const {
+    if (!snapshot) return table;
+    extracted.clear();
+    snapshot->houses.extract(positions, extracted);
+    return extracted;
+}
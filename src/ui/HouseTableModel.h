@@ -0,0 +1,72 @@
+#ifndef HOUSETABLEMODEL_H
+#define HOUSETABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "../models/House.h"
+#include "../utils/HouseTable.h"
+#include "../utils/HouseSnapshot.h"
+
+using namespace std;
+
+// Модель таблицы домов. Данные хранятся массивами по столбцам,
+// текст ячеек формируется в data() только для видимых строк.
+// Строки берутся либо из своей таблицы (страницы загрузки), либо прямо из
+// столбцов снимка по списку его строк - в том числе из общей памяти, без копии
+class HouseTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum Column {
+        COLUMN_ID = 0,
+        COLUMN_ADDRESS,
+        COLUMN_APARTMENTS,
+        COLUMN_TOTAL_AREA,
+        COLUMN_BUILD_YEAR,
+        COLUMN_FLOORS,
+        COLUMN_COUNT
+    };
+
+    explicit HouseTableModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
+
+    static QVariant columnTitle(int section);
+    // Текст ячейки столбца для дома вне модели (страницы PagedHouseModel)
+    static QVariant displayValue(const House& house, int column);
+
+    // Полная замена данных одним сбросом модели; таблица переходит в модель
+    void setHouses(HouseTable houses);
+    // Строки снимка в порядке positions; снимок меняет владелец, модель только читает
+    void setRows(shared_ptr<const HouseSnapshot> snapshot, vector<uint32_t> positions);
+    void clear();
+    // Изменение одной строки с уведомлением только о ней. Снимок к этому
+    // времени уже изменен владельцем, поэтому в его режиме - только уведомление
+    void updateHouse(int row, const House& house);
+    void appendHouse(const House& house);
+    // Строки очередной страницы загрузки в конец таблицы
+    void appendHouses(const HouseTable& houses);
+
+    int houseId(int row) const;
+    int rowOfHouse(int id) const;
+    House houseAt(int row) const;
+    // Строки модели таблицей: своя таблица или копия строк снимка в extracted
+    const HouseTable& houses(HouseTable& extracted) const;
+
+private:
+    // При изменении строки новый адрес дописывается в конец буфера таблицы,
+    // буфер уплотняется при setHouses
+    HouseTable table;
+    // Режим снимка: строки снимка в порядке модели
+    shared_ptr<const HouseSnapshot> snapshot;
+    vector<uint32_t> positions;
+};
+
+#endif
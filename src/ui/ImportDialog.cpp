@@ -0,0 +1,134 @@
+#include "ImportDialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+
+ImportDialog::ImportDialog(QWidget* parent)
+    : QDialog(parent) {
+    setupUI();
+    setWindowTitle("Импорт данных");
+    setFixedSize(450, 300);
+}
+
+ImportDialog::~ImportDialog() {}
+
+void ImportDialog::setupUI() {
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+    
+    // Выбор файла
+    QGroupBox* fileGroup = new QGroupBox("Файл для импорта", this);
+    QHBoxLayout* fileLayout = new QHBoxLayout(fileGroup);
+    
+    filePathEdit = new QLineEdit(this);
+    filePathEdit->setPlaceholderText("Выберите файл с данными...");
+    
+    browseButton = new QPushButton("Обзор...", this);
+    
+    fileLayout->addWidget(filePathEdit);
+    fileLayout->addWidget(browseButton);
+    fileGroup->setLayout(fileLayout);
+    
+    // Те же разделители, что и при экспорте
+    QGroupBox* delimiterGroupBox = new QGroupBox("Разделитель в TXT файле", this);
+    QHBoxLayout* delimiterLayout = new QHBoxLayout(delimiterGroupBox);
+    
+    delimiterGroup = new QButtonGroup(this);
+    QRadioButton* tabRadio = new QRadioButton("Табуляция", this);
+    QRadioButton* semicolonRadio = new QRadioButton("Точка с запятой", this);
+    QRadioButton* commaRadio = new QRadioButton("Запятая", this);
+    
+    delimiterGroup->addButton(tabRadio, 0);
+    delimiterGroup->addButton(semicolonRadio, 1);
+    delimiterGroup->addButton(commaRadio, 2);
+    tabRadio->setChecked(true);
+    
+    delimiterLayout->addWidget(tabRadio);
+    delimiterLayout->addWidget(semicolonRadio);
+    delimiterLayout->addWidget(commaRadio);
+    delimiterGroupBox->setLayout(delimiterLayout);
+    
+    QLabel* formatInfo = new QLabel(
+        "Столбцы определяются по заголовку (имена полей как при экспорте).\n"
+        "Без заголовка ожидаются все поля экспорта в исходном порядке.\n"
+        "Отклоненные строки записываются в файл <имя файла>.errors",
+        this
+    );
+    formatInfo->setWordWrap(true);
+    formatInfo->setStyleSheet("QLabel { color: #666666; font-size: 10px; background-color: #f0f0f0; padding: 5px; }");
+    
+    headerCheck = new QCheckBox("Первая строка - заголовок", this);
+    headerCheck->setChecked(true);
+    
+    // Кнопки
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    importButton = new QPushButton("Импорт", this);
+    cancelButton = new QPushButton("Отмена", this);
+    
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(importButton);
+    buttonLayout->addWidget(cancelButton);
+    
+    mainLayout->addWidget(fileGroup);
+    mainLayout->addWidget(delimiterGroupBox);
+    mainLayout->addWidget(formatInfo);
+    mainLayout->addWidget(headerCheck);
+    mainLayout->addLayout(buttonLayout);
+    
+    setLayout(mainLayout);
+    
+    // Подключаем сигналы
+    connect(browseButton, &QPushButton::clicked, this, &ImportDialog::onBrowseClicked);
+    connect(importButton, &QPushButton::clicked, this, &ImportDialog::onImportClicked);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+    connect(filePathEdit, &QLineEdit::textChanged, this, &ImportDialog::updateImportButton);
+    
+    updateImportButton();
+}
+
+void ImportDialog::onBrowseClicked() {
+    QString fileName = QFileDialog::getOpenFileName(this, 
+        "Открыть текстовый файл (TXT)", 
+        QString(), 
+        "Текстовые файлы (*.txt *.csv);;Все файлы (*)"
+    );
+    
+    if (!fileName.isEmpty()) {
+        filePathEdit->setText(fileName);
+    }
+}
+
+void ImportDialog::onImportClicked() {
+    if (!QFileInfo::exists(filePathEdit->text())) {
+        QMessageBox::warning(this, "Ошибка", "Файл не найден");
+        return;
+    }
+    
+    accept();
+}
+
+void ImportDialog::updateImportButton() {
+    importButton->setEnabled(!filePathEdit->text().isEmpty());
+}
+
+QString ImportDialog::getFilePath() const {
+    return filePathEdit->text();
+}
+
+QString ImportDialog::getErrorFilePath() const {
+    return filePathEdit->text() + ".errors";
+}
+
+QString ImportDialog::getDelimiter() const {
+    switch (delimiterGroup->checkedId()) {
+        case 0: return "\t";           
+        case 1: return ";";           
+        case 2: return ",";           
+        default: return "\t";        
+    }
+}
+
+bool ImportDialog::hasHeader() const {
+    return headerCheck->isChecked();
+}
@@ -0,0 +1,42 @@
+#ifndef IMPORTDIALOG_H
+#define IMPORTDIALOG_H
+
+#include <QDialog>
+#include <QCheckBox>
+#include <QButtonGroup>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QGroupBox>
+#include <QRadioButton>
+#include <QLabel>
+
+class ImportDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit ImportDialog(QWidget* parent = nullptr);
+    ~ImportDialog();
+    
+    QString getFilePath() const;
+    QString getErrorFilePath() const;
+    QString getDelimiter() const;
+    bool hasHeader() const;
+
+private slots:
+    void onBrowseClicked();
+    void onImportClicked();
+    void updateImportButton();
+
+private:
+    QLineEdit* filePathEdit;
+    QPushButton* browseButton;
+    QPushButton* importButton;
+    QPushButton* cancelButton;
+    QCheckBox* headerCheck;
+    
+    QButtonGroup* delimiterGroup;
+    
+    void setupUI();
+};
+
+#endif 
@@ -3,6 +3,10 @@
 #include "../models/House.h"
 #include "AddEditDialog.h"
 #include "ExportDialog.h"
+#include "ImportDialog.h"
+#include "../utils/ExportFormatter.h"
+#include "../utils/ColumnarFormat.h"
+#include "../config/Config.h"
 
 #include <QAction>
 #include <QComboBox>
@@ -13,36 +17,57 @@
 #include <QTabWidget>
 #include <QStatusBar>
 #include <QHeaderView>
+#include <QScrollBar>
+#include <QApplication>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QDateTime>
 #include <algorithm>
-#include <QSet>
+#include <functional>
+#include <chrono>
 
 using namespace std;
 
 using namespace std;
 
-MainWindow::MainWindow(DatabaseManager* dbManager, QWidget* parent)
+MainWindow::MainWindow(DatabaseManager* dbManager, HouseLoader* preloader, QWidget* parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , dbManager(dbManager)
+    , houseView(nullptr)
+    , houseModel(nullptr)
+    , pagedModel(nullptr)
+    , addressSearch(nullptr)
+    , houseLoader(nullptr)
+    , loadProgress(nullptr)
+    , streamPages(false)
+    , importProgress(nullptr)
     , sortColumns()
 {
     ui->setupUi(this);
     setWindowTitle("Управление жилым фондом");
     setWindowIcon(QIcon::fromTheme("building"));
     
-    setupUI();
+    setupUI(preloader);
     setupTable();
-    loadHouses();
+    if (preloader) {
+        resumePreload();
+    } else {
+        loadHouses();
+    }
     updateStatusBar();
 }
 
 MainWindow::~MainWindow() {
+    // Незавершенный импорт откатывается на сервере
+    if (importCanceler) importCanceler->cancel();
+    for (auto& worker : importWorkers) {
+        worker.wait();
+    }
     delete ui;
 }
 
-void MainWindow::setupUI() {
+void MainWindow::setupUI(HouseLoader* preloader) {
     QWidget* centralWidget = new QWidget(this);
     QVBoxLayout* mainLayout = new QVBoxLayout(centralWidget);
     
@@ -55,6 +80,7 @@ void MainWindow::setupUI() {
     toolbar->addAction(QIcon::fromTheme("view-filter"), "Фильтры", this, &MainWindow::onFilter);
     toolbar->addAction(QIcon::fromTheme("edit-clear"), "Очистить фильтры", this, &MainWindow::onClearFilters);
     toolbar->addAction(QIcon::fromTheme("document-export"), "Экспорт", this, &MainWindow::onExport);
+    toolbar->addAction(QIcon::fromTheme("document-import"), "Импорт", this, &MainWindow::onImport);
     toolbar->addAction(QIcon::fromTheme("view-refresh"), "Обновить", this, &MainWindow::onRefresh);
     toolbar->addSeparator();
     toolbar->addAction(QIcon::fromTheme("system-log-out"), "Выход", this, &MainWindow::onExit);
@@ -66,38 +92,32 @@ void MainWindow::setupUI() {
     QHBoxLayout* sortLayout = new QHBoxLayout(sortPanel);
     
     QLabel* sortLabel = new QLabel("Сортировка:", sortPanel);
-    QComboBox* sortCombo1 = new QComboBox(sortPanel);
-    sortCombo1->addItem("Без сортировки", -1);
-    sortCombo1->addItem("Адрес", 1);
-    sortCombo1->addItem("Квартиры", 2);
-    sortCombo1->addItem("Площадь", 3);
-    sortCombo1->addItem("Год постройки", 4);
-    sortCombo1->addItem("Этажность", 5);
-    
-    QComboBox* orderCombo1 = new QComboBox(sortPanel);
-    orderCombo1->addItem("По возрастанию", true);
-    orderCombo1->addItem("По убыванию", false);
-    
-    QComboBox* sortCombo2 = new QComboBox(sortPanel);
-    sortCombo2->addItem("Без сортировки", -1);
-    sortCombo2->addItem("Адрес", 1);
-    sortCombo2->addItem("Квартиры", 2);
-    sortCombo2->addItem("Площадь", 3);
-    sortCombo2->addItem("Год постройки", 4);
-    sortCombo2->addItem("Этажность", 5);
-    
-    QComboBox* orderCombo2 = new QComboBox(sortPanel);
-    orderCombo2->addItem("По возрастанию", true);
-    orderCombo2->addItem("По убыванию", false);
+    sortLayout->addWidget(sortLabel);
     
-    QPushButton* applySortBtn = new QPushButton("Применить", sortPanel);
+    // Уровни сортировки: каждый следующий упорядочивает строки, равные по предыдущим
+    QList<QPair<QComboBox*, QComboBox*>> sortLevels;
+    for (int level = 0; level < SORT_LEVELS; ++level) {
+        QComboBox* sortCombo = new QComboBox(sortPanel);
+        sortCombo->addItem("Без сортировки", -1);
+        sortCombo->addItem("Адрес", 1);
+        sortCombo->addItem("Квартиры", 2);
+        sortCombo->addItem("Площадь", 3);
+        sortCombo->addItem("Год постройки", 4);
+        sortCombo->addItem("Этажность", 5);
+        
+        QComboBox* orderCombo = new QComboBox(sortPanel);
+        orderCombo->addItem("По возрастанию", true);
+        orderCombo->addItem("По убыванию", false);
+        
+        if (level > 0) {
+            sortLayout->addWidget(new QLabel("затем", sortPanel));
+        }
+        sortLayout->addWidget(sortCombo);
+        sortLayout->addWidget(orderCombo);
+        sortLevels.append(qMakePair(sortCombo, orderCombo));
+    }
     
-    sortLayout->addWidget(sortLabel);
-    sortLayout->addWidget(sortCombo1);
-    sortLayout->addWidget(orderCombo1);
-    sortLayout->addWidget(new QLabel("затем", sortPanel));
-    sortLayout->addWidget(sortCombo2);
-    sortLayout->addWidget(orderCombo2);
+    QPushButton* applySortBtn = new QPushButton("Применить", sortPanel);
     sortLayout->addWidget(applySortBtn);
     sortLayout->addStretch();
     
@@ -117,201 +137,276 @@ void MainWindow::setupUI() {
     searchLayout->addWidget(clearSearchBtn);
     searchLayout->addStretch();
     
-    // Таблица
-    QTableWidget* table = new QTableWidget();
-    table->setColumnCount(6);
-    table->setHorizontalHeaderLabels({"ID", "Адрес", "Квартир", "Площадь", "Год постройки", "Этажей"});
-    table->setSelectionBehavior(QAbstractItemView::SelectRows);
-    table->setSelectionMode(QAbstractItemView::ExtendedSelection);
-    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    // Таблица: представление над моделью, ячейки создаются только для видимых строк
+    // Большой фонд подгружается страницами, чтобы первый экран не ждал всей таблицы
+    // Предзагрузка запускается только для фонда, который помещается в память
+    houseView = new QTableView();
+    if (!preloader && dbManager->estimateHouseCount() >= Config::getPagedTableThreshold()) {
+        pagedModel = new PagedHouseModel(dbManager, this);
+        houseView->setModel(pagedModel);
+        connect(pagedModel, &QAbstractItemModel::rowsInserted, this, &MainWindow::updateStatusBar);
+        connect(pagedModel, &QAbstractItemModel::modelReset, this, &MainWindow::updateStatusBar);
+    } else {
+        houseModel = new HouseTableModel(this);
+        houseView->setModel(houseModel);
+    }
+    houseView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    houseView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    houseView->setEditTriggers(QAbstractItemView::NoEditTriggers);
     
     mainLayout->addWidget(sortPanel);
     mainLayout->addWidget(searchPanel);
-    mainLayout->addWidget(table);
+    mainLayout->addWidget(houseView);
     
     centralWidget->setLayout(mainLayout);
     setCentralWidget(centralWidget);
     
     statusBar()->showMessage("Готово");
     
+    // Ход загрузки снимка: окно уже показано, таблица заполняется по страницам
+    loadProgress = new QProgressBar(this);
+    loadProgress->setMaximumWidth(260);
+    loadProgress->setTextVisible(true);
+    loadProgress->hide();
+    statusBar()->addPermanentWidget(loadProgress);
+    
+    houseLoader = preloader ? preloader : new HouseLoader(dbManager);
+    houseLoader->setParent(this);
+    connect(houseLoader, &HouseLoader::pageLoaded, this, &MainWindow::onLoadPage);
+    connect(houseLoader, &HouseLoader::finished, this, &MainWindow::onLoadFinished);
+    connect(houseLoader, &HouseLoader::failed, this, &MainWindow::onLoadFailed);
+    connect(houseLoader, &HouseLoader::sharedSnapshotChanged, this, &MainWindow::onSharedSnapshotChanged);
+    
+    // Поиск по мере ввода выполняется в фоне, таблица обновляется по готовности
+    addressSearch = new AddressSearch(dbManager, this);
+    connect(addressSearch, &AddressSearch::finished, this, &MainWindow::onSearchFinished);
+    connect(addressSearch, &AddressSearch::failed, this, [this](const HouseQuery&) {
+        statusBar()->showMessage("Ошибка поиска по адресу");
+    });
+    
+    connect(searchEdit, &QLineEdit::textChanged, this, [this](const QString& text) {
+        currentFilters.addressFilter = text;
+        startSearch(false);
+    });
+    
+    connect(searchEdit, &QLineEdit::returnPressed, this, [this]() {
+        startSearch(true);
+    });
+    
     connect(searchBtn, &QPushButton::clicked, this, [this, searchEdit]() {
         currentFilters.addressFilter = searchEdit->text();
-        loadHouses();
-        statusBar()->showMessage(QString("Применен фильтр по адресу: %1").arg(searchEdit->text()));
+        startSearch(true);
     });
     
     connect(clearSearchBtn, &QPushButton::clicked, this, [this, searchEdit]() {
         searchEdit->clear();
         currentFilters.addressFilter.clear();
-        loadHouses();
+        applyView();
         statusBar()->showMessage("Поиск очищен");
     });
     
-    connect(applySortBtn, &QPushButton::clicked, this, [this, sortCombo1, orderCombo1, sortCombo2, orderCombo2]() {
+    connect(applySortBtn, &QPushButton::clicked, this, [this, sortLevels]() {
         sortColumns.clear();
         
-        // Первый уровень сортировки
-        int col1 = sortCombo1->currentData().toInt();
-        if (col1 != -1) {
-            SortColumn sc;
-            sc.column = col1;
-            sc.ascending = orderCombo1->currentData().toBool();
-            sortColumns.append(sc);
-        }
-        
-        // Второй уровень сортировки
-        int col2 = sortCombo2->currentData().toInt();
-        if (col2 != -1) {
-            SortColumn sc;
-            sc.column = col2;
-            sc.ascending = orderCombo2->currentData().toBool();
-            sortColumns.append(sc);
+        for (const auto& level : sortLevels) {
+            int column = level.first->currentData().toInt();
+            if (column != -1) {
+                SortColumn sc;
+                sc.column = column;
+                sc.ascending = level.second->currentData().toBool();
+                sortColumns.append(sc);
+            }
         }
         
-        loadHouses();
+        applyView();
         statusBar()->showMessage("Сортировка применена");
     });
     
-    connect(table, &QTableWidget::cellDoubleClicked, this, [this](int row, int) {
+    connect(houseView, &QTableView::doubleClicked, this, [this](const QModelIndex&) {
         onEditHouse();
     });
+    
+    connect(houseView->selectionModel(), &QItemSelectionModel::currentRowChanged, this,
+        [this](const QModelIndex& current, const QModelIndex&) {
+            onHouseSelected(current.row(), current.column());
+        });
 }
 
 void MainWindow::setupTable() {
-    QTableWidget* table = findChild<QTableWidget*>();
-    if (!table) return;
+    if (!houseView) return;
+    
+    houseView->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
     
-    table->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    // Одинаковая высота строк: представлению не нужно измерять каждую строку
+    QHeaderView* rows = houseView->verticalHeader();
+    rows->setSectionResizeMode(QHeaderView::Fixed);
+    rows->setDefaultSectionSize(houseView->fontMetrics().height() + 8);
 }
 
 void MainWindow::loadHouses() {
-    auto houses = dbManager->getAllHouses();
+    // Новая загрузка заменяет результат поиска, который еще не пришел
+    if (addressSearch) {
+        addressSearch->cancel();
+    }
     
-    // Применяем фильтры
-    if (currentFilters.isActive()) {
-        applyFilters(houses);
+    if (pagedModel) {
+        // Фильтры и сортировка выполняются на сервере
+        pagedModel->setQuery(currentQuery());
+        updateStatusBar();
+        return;
     }
     
-    // Применяем сортировку
-    if (!sortColumns.isEmpty()) {
-        applySorting(houses);
+    // Без фильтров и сортировки таблица заполняется страницами по мере
+    // загрузки; иначе прежний вид остается до готовности снимка
+    streamPages = !currentFilters.isActive() && sortColumns.isEmpty();
+    pendingChanges.clear();
+    if (streamPages) {
+        houseModel->clear();
     }
+    houseLoader->start();
     
-    loadHouses(houses);
+    loadProgress->setRange(0, 0);
+    loadProgress->setFormat("Загрузка...");
+    loadProgress->show();
 }
 
-void MainWindow::loadHouses(const vector<House>& houses) {
-    QTableWidget* table = findChild<QTableWidget*>();
-    if (!table) return;
-    
-    table->setRowCount(0);
-    table->setRowCount(houses.size());
-    
-    for (size_t i = 0; i < houses.size(); ++i) {
-        const House& house = houses[i];
-        
-        // ID
-        QTableWidgetItem* idItem = new QTableWidgetItem(QString::number(house.id));
-        idItem->setData(Qt::UserRole, house.id);
-        table->setItem(i, 0, idItem);
-        
-        // Адрес
-        table->setItem(i, 1, new QTableWidgetItem(QString::fromStdString(house.address)));
-        
-        // Квартиры
-        table->setItem(i, 2, new QTableWidgetItem(QString::number(house.apartments)));
-        
-        // Площадь
-        table->setItem(i, 3, new QTableWidgetItem(QString::number(house.totalArea, 'f', 2)));
-        
-        // Год постройки
-        QTableWidgetItem* yearItem = new QTableWidgetItem(QString::number(house.buildYear));
-        table->setItem(i, 4, yearItem);
-        
-        // Этажи
-        table->setItem(i, 5, new QTableWidgetItem(QString::number(house.floors)));
+void MainWindow::resumePreload() {
+    // Строки, полученные во время входа, переходят в таблицу без копирования
+    streamPages = true;
+    houseModel->setHouses(houseLoader->takeRetainedRows());
+    shared_ptr<HouseSnapshot> loaded = houseLoader->takeSnapshot();
+    houseLoader->setRetainResults(false);
+    
+    if (loaded) {
+        onLoadFinished(loaded);
+    } else if (houseLoader->isLoading()) {
+        loadProgress->setRange(0, 0);
+        loadProgress->setFormat(QString("Загружено %1").arg(houseLoader->receivedRows()));
+        loadProgress->show();
+    } else {
+        // Предзагрузка не удалась: обычная загрузка
+        loadHouses();
+    }
+}
+
+void MainWindow::onLoadPage(const HouseTable& page) {
+    if (streamPages) {
+        houseModel->appendHouses(page);
     }
     
+    long long expected = houseLoader->expectedRows();
+    int received = static_cast<int>(houseLoader->receivedRows());
+    if (expected > 0) {
+        // Оценка по статистике может быть меньше фактического числа строк
+        loadProgress->setRange(0, static_cast<int>(max<long long>(expected, received)));
+        loadProgress->setValue(received);
+    }
+    loadProgress->setFormat(QString("Загружено %1").arg(received));
+    updateStatusBar();
+}
+
+void MainWindow::onLoadFinished(shared_ptr<HouseSnapshot> loaded) {
+    loadProgress->hide();
+    
+    snapshot = loaded;
+    houseSortKeys.clear();
+    for (const PendingChange& change : pendingChanges) {
+        if (change.removed) snapshot->remove(change.house.id);
+        else snapshot->update(change.house);
+    }
+    pendingChanges.clear();
+    
+    // Таблица уже содержит все строки в порядке id, если вид не менялся
+    // и снимок не обновлялся после показа локальной копии
+    if (!streamPages || houseLoader->pagesOutdated()) {
+        // Новый снимок не сбивает пользователю выбранную строку и прокрутку
+        int selectedId = houseModel->houseId(houseView->currentIndex().row());
+        int scrolled = houseView->verticalScrollBar()->value();
+        applyView();
+        int row = selectedId > 0 ? houseModel->rowOfHouse(selectedId) : -1;
+        if (row >= 0) houseView->setCurrentIndex(houseModel->index(row, 0));
+        houseView->verticalScrollBar()->setValue(scrolled);
+    }
     updateStatusBar();
 }
 
-void MainWindow::applyFilters(vector<House>& houses) {
-    houses.erase(remove_if(houses.begin(), houses.end(),
-        [this](const House& house) {
-            return !matchesFilters(house);
-        }),
-        houses.end());
+void MainWindow::onSharedSnapshotChanged() {
+    // Открытый диалог работает со строкой прежнего снимка: обновление подождет следующего опроса
+    if (pagedModel || houseLoader->isLoading() || QApplication::activeModalWidget()) return;
+    
+    // Новая эпоха издателя заменяет снимок без страниц; правки уже в базе
+    streamPages = false;
+    pendingChanges.clear();
+    houseLoader->start();
 }
 
-bool MainWindow::matchesFilters(const House& house) const {
-    // Проверка года постройки
-    if (house.buildYear < currentFilters.minYear || house.buildYear > currentFilters.maxYear) {
-        return false;
-    }
-    
-    // Проверка количества квартир
-    if (house.apartments < currentFilters.minApartments || house.apartments > currentFilters.maxApartments) {
-        return false;
+void MainWindow::onLoadFailed() {
+    loadProgress->hide();
+    statusBar()->showMessage("Ошибка загрузки домов");
+}
+
+void MainWindow::applyView() {
+    if (pagedModel) {
+        loadHouses();
+        return;
     }
     
-    // Проверка площади
-    if (house.totalArea < currentFilters.minArea || house.totalArea > currentFilters.maxArea) {
-        return false;
+    // Снимок еще загружается: вид будет построен по нему после загрузки
+    if (houseLoader->isLoading()) {
+        streamPages = false;
+        statusBar()->showMessage("Фильтры и сортировка будут применены после загрузки");
+        return;
     }
-    
-    // Проверка адреса
+    if (!snapshot) return;
+    
+    // Числовые условия - пересечение битмапов индекса, подстрока адреса - по индексу триграмм
+    vector<HouseColumnStore::Range> ranges = {
+        {HouseColumnStore::BUILD_YEAR, currentFilters.minYear, currentFilters.maxYear},
+        {HouseColumnStore::APARTMENTS, currentFilters.minApartments, currentFilters.maxApartments},
+        {HouseColumnStore::TOTAL_AREA, currentFilters.minArea.hundredths, currentFilters.maxArea.hundredths},
+        {HouseColumnStore::FLOORS, currentFilters.minFloors, currentFilters.maxFloors}
+    };
+    RowBitmap matched = snapshot->filterIndex.match(ranges);
+    
+    vector<uint32_t> positions;
     if (!currentFilters.addressFilter.isEmpty()) {
-        QString address = QString::fromStdString(house.address);
-        if (!address.contains(currentFilters.addressFilter, Qt::CaseInsensitive)) {
-            return false;
+        const vector<uint32_t>& found = snapshot->addressIndex.find(currentFilters.addressFilter.toStdString());
+        positions.reserve(found.size());
+        for (uint32_t slot : found) {
+            if (matched.contains(slot)) positions.push_back(slot);
         }
+    } else {
+        matched.toRows(positions);
     }
     
-    // Проверка этажности
-    if (house.floors < currentFilters.minFloors || house.floors > currentFilters.maxFloors) {
-        return false;
+    if (!sortColumns.isEmpty()) {
+        houseSortKeys.sort(positions, snapshot->houses, currentQuery().sortKeys);
     }
     
-    return true;
+    // Модель читает строки прямо из столбцов снимка, без копии
+    houseModel->setRows(snapshot, move(positions));
+    updateStatusBar();
 }
 
-void MainWindow::applySorting(vector<House>& houses) {
-    sort(houses.begin(), houses.end(),
-        [this](const House& a, const House& b) {
-            return compareHouses(a, b);
-        });
+void MainWindow::updateLoadedHouse(const House& house) {
+    // Показанный снимок меняется и во время загрузки: модель читает строки из него
+    if (houseLoader->isLoading()) {
+        pendingChanges.push_back({house, false});
+    }
+    if (snapshot) {
+        snapshot->update(house);
+    }
 }
 
-bool MainWindow::compareHouses(const House& a, const House& b) const {
-    for (const SortColumn& sc : sortColumns) {
-        int comparison = 0;
-        
-        switch (sc.column) {
-            case 1: // Адрес
-                comparison = QString::fromStdString(a.address).compare(QString::fromStdString(b.address));
-                break;
-            case 2: // Квартиры
-                comparison = a.apartments - b.apartments;
-                break;
-            case 3: // Площадь
-                comparison = (a.totalArea < b.totalArea) ? -1 : (a.totalArea > b.totalArea) ? 1 : 0;
-                break;
-            case 4: // Год постройки
-                comparison = a.buildYear - b.buildYear;
-                break;
-            case 5: // Этажность
-                comparison = a.floors - b.floors;
-                break;
-            default:
-                continue;
-        }
-        
-        if (comparison != 0) {
-            return sc.ascending ? (comparison < 0) : (comparison > 0);
-        }
+void MainWindow::removeLoadedHouse(int houseId) {
+    if (houseLoader->isLoading()) {
+        House removed;
+        removed.id = houseId;
+        pendingChanges.push_back({removed, true});
+    }
+    if (snapshot) {
+        snapshot->remove(houseId);
     }
-    
-    return false; 
 }
 
 void MainWindow::onAddHouse() {
@@ -324,7 +419,13 @@ void MainWindow::onAddHouse() {
         House house = dialog.getHouse();
         if (dbManager->addHouse(house)) {
             showInfo("Дом успешно добавлен");
-            loadHouses();
+            if (pagedModel) {
+                loadHouses();
+            } else {
+                // Дом дописывается в снимок и индексы, без повторной загрузки всех домов
+                updateLoadedHouse(house);
+                applyView();
+            }
         } else {
             showError("Ошибка при добавлении дома");
         }
@@ -332,26 +433,17 @@ void MainWindow::onAddHouse() {
 }
 
 void MainWindow::onEditHouse() {
-    QTableWidget* table = findChild<QTableWidget*>();
-    if (!table || table->currentRow() < 0) {
+    int row = houseView ? houseView->currentIndex().row() : -1;
+    if (row < 0) {
         showError("Выберите дом для редактирования");
         return;
     }
     
-    int houseId = table->item(table->currentRow(), 0)->data(Qt::UserRole).toInt();
-    
-    auto houses = dbManager->getAllHouses();
-    House* selectedHouse = nullptr;
-    
-    for (auto& house : houses) {
-        if (house.id == houseId) {
-            selectedHouse = &house;
-            break;
-        }
-    }
-    
-    if (!selectedHouse) {
-        showError("Дом не найден");
+    House selectedHouse = houseAtRow(row);
+    int houseId = selectedHouse.id;
+    if (houseId <= 0) {
+        // Постраничная модель догружает строку в фоне
+        showError("Строка еще загружается или данные изменились на сервере. Повторите выбор");
         return;
     }
     
@@ -359,7 +451,7 @@ void MainWindow::onEditHouse() {
     dialog.setWindowTitle("Редактировать дом");
     dialog.setDatabaseManager(dbManager);
     dialog.setEditingMode(true, houseId);
-    dialog.setHouse(*selectedHouse);
+    dialog.setHouse(selectedHouse);
     
     if (dialog.exec() == QDialog::Accepted) {
         House updatedHouse = dialog.getHouse();
@@ -367,7 +459,16 @@ void MainWindow::onEditHouse() {
         
         if (dbManager->updateHouse(updatedHouse)) {
             showInfo("Изменения сохранены");
-            loadHouses();
+            if (!pagedModel) {
+                updateLoadedHouse(updatedHouse);
+            }
+            // Без фильтров и сортировки строка остается на месте
+            if (!currentFilters.isActive() && sortColumns.isEmpty()) {
+                if (pagedModel) pagedModel->updateHouse(row, updatedHouse);
+                else houseModel->updateHouse(row, updatedHouse);
+            } else {
+                applyView();
+            }
         } else {
             showError("Ошибка при сохранении изменений");
         }
@@ -441,14 +542,11 @@ void MainWindow::onDeleteHouses() {
         
         switch (option) {
             case 0: { // Удалить выбранные дома
-                QTableWidget* table = findChild<QTableWidget*>();
-                if (!table) return;
-                
-                QList<QTableWidgetItem*> selectedItems = table->selectedItems();
-                QSet<int> selectedRows;
+                if (!houseView) return;
                 
-                for (const auto& item : selectedItems) {
-                    selectedRows.insert(item->row());
+                QList<int> selectedRows;
+                for (const QModelIndex& index : houseView->selectionModel()->selectedRows()) {
+                    selectedRows.append(index.row());
                 }
                 
                 if (selectedRows.isEmpty()) {
@@ -456,22 +554,39 @@ void MainWindow::onDeleteHouses() {
                     return;
                 }
                 
+                // С конца, чтобы номера оставшихся строк не сдвигались
+                sort(selectedRows.begin(), selectedRows.end(), greater<int>());
+                // id берутся до подтверждения: строки, которые постраничная
+                // модель еще загружает, нельзя удалить по номеру
+                vector<int> selectedIds;
+                for (int row : selectedRows) {
+                    selectedIds.push_back(houseAtRow(row).id);
+                }
+                if (find_if(selectedIds.begin(), selectedIds.end(), [](int id) { return id <= 0; }) != selectedIds.end()) {
+                    showError("Часть выбранных строк еще загружается. Повторите удаление");
+                    return;
+                }
+                
                 if (!confirmAction("Удаление", 
                     QString("Удалить выбранные %1 домов?\nЭто действие нельзя отменить.").arg(selectedRows.size()))) {
                     return;
                 }
                 
                 bool allDeleted = true;
-                for (int row : selectedRows) {
-                    int houseId = table->item(row, 0)->data(Qt::UserRole).toInt();
-                    if (!dbManager->deleteHouse(houseId)) {
+                for (int i = 0; i < selectedRows.size(); ++i) {
+                    int row = selectedRows[i];
+                    int houseId = selectedIds[i];
+                    if (dbManager->deleteHouse(houseId)) {
+                        if (!pagedModel) removeLoadedHouse(houseId);
+                        houseView->model()->removeRows(row, 1);
+                    } else {
                         allDeleted = false;
                     }
                 }
+                updateStatusBar();
                 
                 if (allDeleted) {
                     showInfo(QString("Удалено %1 домов").arg(selectedRows.size()));
-                    loadHouses();
                 } else {
                     showError("Ошибка при удалении некоторых домов");
                 }
@@ -493,10 +608,10 @@ void MainWindow::onDeleteHouses() {
                 }
                 
                 // Проверяем сколько домов будет удалено
-                auto allHouses = dbManager->getAllHouses();
+                auto allHouses = dbManager->getAllHouses(HOUSE_FIELD_BUILD_YEAR);
                 int countToDelete = 0;
-                for (const auto& house : allHouses) {
-                    if (house.buildYear == year) {
+                for (size_t row = 0; row < allHouses.size(); ++row) {
+                    if (allHouses.buildYear(row) == year) {
                         countToDelete++;
                     }
                 }
@@ -543,10 +658,10 @@ void MainWindow::onDeleteHouses() {
                     return;
                 }
                 
-                auto allHouses = dbManager->getAllHouses();
+                auto allHouses = dbManager->getAllHouses(HOUSE_FIELD_APARTMENTS);
                 int countToDelete = 0;
-                for (const auto& house : allHouses) {
-                    if (house.apartments >= minApt && house.apartments <= maxApt) {
+                for (size_t row = 0; row < allHouses.size(); ++row) {
+                    if (allHouses.apartments(row) >= minApt && allHouses.apartments(row) <= maxApt) {
                         countToDelete++;
                     }
                 }
@@ -577,37 +692,43 @@ void MainWindow::onDeleteHouses() {
                     return;
                 }
                 
-                double minArea = 0, maxArea = 0;
+                // Границы разбираются из текста точно, без округления double
+                Area minArea, maxArea;
                 if (areaText.contains("-")) {
                     QStringList parts = areaText.split("-");
                     if (parts.size() == 2) {
-                        minArea = parts[0].toDouble();
-                        maxArea = parts[1].toDouble();
+                        Area::parse(parts[0].toStdString(), minArea);
+                        Area::parse(parts[1].toStdString(), maxArea);
                     }
                 } else {
-                    minArea = maxArea = areaText.toDouble();
+                    Area::parse(areaText.toStdString(), minArea);
+                    maxArea = minArea;
                 }
                 
-                if (minArea <= 0 || maxArea <= 0 || minArea > maxArea) {
+                if (minArea <= Area(0) || maxArea <= Area(0) || minArea > maxArea) {
                     showError("Некорректный диапазон площади");
                     return;
                 }
                 
-                auto allHouses = dbManager->getAllHouses();
+                auto allHouses = dbManager->getAllHouses(HOUSE_FIELD_TOTAL_AREA);
                 int countToDelete = 0;
-                for (const auto& house : allHouses) {
-                    if (house.totalArea >= minArea && house.totalArea <= maxArea) {
+                for (size_t row = 0; row < allHouses.size(); ++row) {
+                    if (allHouses.totalArea(row) >= minArea && allHouses.totalArea(row) <= maxArea) {
                         countToDelete++;
                     }
                 }
                 
                 if (countToDelete == 0) {
-                    showInfo(QString("Домов с площадью %1-%2 м² не найдено").arg(minArea, 0, 'f', 2).arg(maxArea, 0, 'f', 2));
+                    showInfo(QString("Домов с площадью %1-%2 м² не найдено")
+                        .arg(QString::fromStdString(minArea.toString()))
+                        .arg(QString::fromStdString(maxArea.toString())));
                     return;
                 }
                 
                 if (!confirmAction("Удаление", 
-                    QString("Удалить %1 домов с площадью %2-%3 м²?\nЭто действие нельзя отменить.").arg(countToDelete).arg(minArea, 0, 'f', 2).arg(maxArea, 0, 'f', 2))) {
+                    QString("Удалить %1 домов с площадью %2-%3 м²?\nЭто действие нельзя отменить.").arg(countToDelete)
+                        .arg(QString::fromStdString(minArea.toString()))
+                        .arg(QString::fromStdString(maxArea.toString())))) {
                     return;
                 }
                 
@@ -627,10 +748,12 @@ void MainWindow::onDeleteHouses() {
                     return;
                 }
                 
-                auto allHouses = dbManager->getAllHouses();
+                auto allHouses = dbManager->getAllHouses(HOUSE_FIELD_ADDRESS);
                 int countToDelete = 0;
-                for (const auto& house : allHouses) {
-                    if (QString::fromStdString(house.address).contains(addressText, Qt::CaseInsensitive)) {
+                for (size_t row = 0; row < allHouses.size(); ++row) {
+                    string_view address = allHouses.address(row);
+                    if (QString::fromUtf8(address.data(), static_cast<qsizetype>(address.size()))
+                            .contains(addressText, Qt::CaseInsensitive)) {
                         countToDelete++;
                     }
                 }
@@ -706,12 +829,12 @@ void MainWindow::onFilter() {
     
     QDoubleSpinBox* minAreaSpin = new QDoubleSpinBox(areaTab);
     minAreaSpin->setRange(0.0, 100000.0);
-    minAreaSpin->setValue(currentFilters.minArea);
+    minAreaSpin->setValue(currentFilters.minArea.toDouble());
     minAreaSpin->setDecimals(2);
     
     QDoubleSpinBox* maxAreaSpin = new QDoubleSpinBox(areaTab);
     maxAreaSpin->setRange(0.0, 100000.0);
-    maxAreaSpin->setValue(currentFilters.maxArea);
+    maxAreaSpin->setValue(currentFilters.maxArea.toDouble());
     maxAreaSpin->setDecimals(2);
     
     areaLayout->addRow("Площадь от:", minAreaSpin);
@@ -763,25 +886,25 @@ void MainWindow::onFilter() {
         currentFilters.maxYear = maxYearSpin->value();
         currentFilters.minApartments = minAptSpin->value();
         currentFilters.maxApartments = maxAptSpin->value();
-        currentFilters.minArea = minAreaSpin->value();
-        currentFilters.maxArea = maxAreaSpin->value();
+        currentFilters.minArea = Area::fromDouble(minAreaSpin->value());
+        currentFilters.maxArea = Area::fromDouble(maxAreaSpin->value());
         currentFilters.minFloors = minFloorsSpin->value();
         currentFilters.maxFloors = maxFloorsSpin->value();
         
-        loadHouses();
+        applyView();
         statusBar()->showMessage("Фильтры применены");
     }
 }
 
 void MainWindow::onClearFilters() {
     currentFilters = FilterSettings();
-    loadHouses();
+    applyView();
     statusBar()->showMessage("Все фильтры очищены");
 }
 
 void MainWindow::onRefresh() {
     loadHouses();
-    statusBar()->showMessage("Данные обновлены");
+    statusBar()->showMessage("Обновление данных...");
 }
 
 void MainWindow::onExport() {
@@ -798,20 +921,186 @@ void MainWindow::onExport() {
             stdFields.push_back(field.toStdString());
         }
         
-        if (dbManager->exportToFile(fileName.toStdString(), stdFields, 
-                                   delimiter.toStdString(), includeHeader)) {
+        if (dialog.isColumnarFormat()) {
+            bool exported;
+            if (dialog.exportVisibleOnly()) {
+                ColumnarWriter writer(stdFields);
+                exported = writer.open(fileName.toStdString());
+                HouseTable fetched;
+                const HouseTable& houses = visibleHouses(fetched);
+                for (size_t row = 0; exported && row < houses.size(); ++row) {
+                    exported = writer.addRow(houses, row);
+                }
+                exported = writer.close() && exported;
+            } else {
+                exported = dbManager->exportToColumnar(fileName.toStdString(), stdFields);
+            }
+            
+            if (exported) {
+                showInfo(QString("Данные экспортированы в колоночный файл:\n%1\n"
+                               "Формат: HFC (бинарный, по группам строк)")
+                        .arg(fileName));
+            } else {
+                showError("Ошибка при экспорте данных в колоночный файл");
+            }
+            return;
+        }
+        
+        int compressionLevel = dialog.compressionLevel();
+        if (compressionLevel > 0 && !fileName.endsWith(".gz", Qt::CaseInsensitive)) {
+            fileName += ".gz";
+        }
+        
+        if (dialog.isIncremental()) {
+            IncrementalExportResult result;
+            if (dbManager->exportIncremental(fileName.toStdString(), stdFields, delimiter.toStdString(),
+                                             includeHeader, "default", compressionLevel, &result)) {
+                showInfo(QString("Изменения с прошлого экспорта записаны в файл:\n%1\n"
+                               "Изменено или добавлено: %2\n"
+                               "Удалено: %3")
+                        .arg(fileName)
+                        .arg(result.changedRows)
+                        .arg(result.deletedRows));
+            } else {
+                showError("Ошибка при инкрементальном экспорте");
+            }
+            return;
+        }
+        
+        bool exported;
+        bool resumed = false;
+        if (dialog.exportVisibleOnly()) {
+            // Отображаемые строки уже в памяти, форматируем их на клиенте
+            ExportFormatter formatter(stdFields, delimiter.toStdString()[0]);
+            HouseTable fetched;
+            exported = formatter.writeFile(visibleHouses(fetched), fileName.toStdString(), includeHeader,
+                                           compressionLevel);
+        } else if (dialog.useParallelExport()) {
+            exported = dbManager->exportToFileParallel(fileName.toStdString(), stdFields,
+                                                       delimiter.toStdString(), includeHeader,
+                                                       compressionLevel);
+        } else {
+            // Прерванный экспорт в тот же файл продолжается с контрольной точки
+            exported = dbManager->exportToFile(fileName.toStdString(), stdFields, 
+                                               delimiter.toStdString(), includeHeader,
+                                               compressionLevel, &resumed);
+        }
+        
+        if (exported) {
             showInfo(QString("Данные экспортированы в текстовый файл:\n%1\n"
-                           "Формат: TXT\n"
-                           "Разделитель: %2")
+                           "Формат: %3\n"
+                           "Разделитель: %2%4")
                     .arg(fileName)
                     .arg(delimiter == "\t" ? "Табуляция" : 
-                         delimiter == ";" ? "Точка с запятой" : "Запятая"));
+                         delimiter == ";" ? "Точка с запятой" : "Запятая")
+                    .arg(compressionLevel > 0 ? QString("TXT, сжатие gzip (уровень %1)").arg(compressionLevel)
+                                              : QString("TXT"))
+                    .arg(resumed ? QString("\nЭкспорт продолжен с контрольной точки") : QString()));
         } else {
-            showError("Ошибка при экспорте данных в TXT файл");
+            bool resumable = !dialog.exportVisibleOnly() && !dialog.useParallelExport() &&
+                             compressionLevel == 0;
+            showError(resumable ? QString("Ошибка при экспорте данных в TXT файл.\n"
+                                          "Повторный экспорт в тот же файл продолжится с места остановки")
+                                : QString("Ошибка при экспорте данных в TXT файл"));
         }
     }
 }
 
+void MainWindow::onImport() {
+    // Идущий импорт показан окном хода; второй не запускается
+    if (importCanceler) return;
+    
+    ImportDialog dialog(this);
+    if (dialog.exec() != QDialog::Accepted) return;
+    
+    string fileName = dialog.getFilePath().toStdString();
+    string delimiter = dialog.getDelimiter().toStdString();
+    bool hasHeader = dialog.hasHeader();
+    QString errorFileName = dialog.getErrorFilePath();
+    
+    pruneImportWorkers();
+    shared_ptr<QueryCanceler> canceler = make_shared<QueryCanceler>();
+    importCanceler = canceler;
+    
+    // Импорт идет в фоне на соединении пула; окно хода позволяет его отменить
+    importProgress = new QProgressDialog("Импорт домов...", "Отмена", 0, IMPORT_PROGRESS_STEPS, this);
+    importProgress->setWindowTitle("Импорт");
+    importProgress->setWindowModality(Qt::WindowModal);
+    importProgress->setMinimumDuration(0);
+    importProgress->setAutoClose(false);
+    importProgress->setAutoReset(false);
+    connect(importProgress, &QProgressDialog::canceled, this, &MainWindow::cancelImport);
+    importProgress->show();
+    
+    importWorkers.push_back(async(launch::async,
+        [this, canceler, fileName, delimiter, hasHeader, errorFileName]() {
+        ImportResult result;
+        bool ok = dbManager->importFromFile(fileName, delimiter, hasHeader, errorFileName.toStdString(),
+            &result, canceler.get(), [this](size_t done, size_t total) {
+                QMetaObject::invokeMethod(this, [this, done, total]() {
+                    onImportProgress(done, total);
+                }, Qt::QueuedConnection);
+            });
+        // Отмена после COMMIT уже ничего не меняет: импорт считается выполненным
+        bool canceled = !ok && canceler->isCanceled();
+        
+        QMetaObject::invokeMethod(this, [this, ok, canceled, result, errorFileName]() {
+            onImportFinished(ok, canceled, result, errorFileName);
+        }, Qt::QueuedConnection);
+    }));
+}
+
+void MainWindow::onImportProgress(size_t done, size_t total) {
+    if (!importProgress || total == 0) return;
+    
+    importProgress->setValue(static_cast<int>(done * IMPORT_PROGRESS_STEPS / total));
+    // Файл передан целиком: сервер проверяет адреса и записывает дома
+    if (done >= total) importProgress->setLabelText("Проверка адресов и запись домов...");
+}
+
+void MainWindow::cancelImport() {
+    if (!importCanceler) return;
+    
+    importProgress->setLabelText("Отмена импорта...");
+    importProgress->setCancelButton(nullptr);
+    // PQcancel открывает отдельное соединение, поэтому выполняется в фоне
+    shared_ptr<QueryCanceler> canceler = importCanceler;
+    importWorkers.push_back(async(launch::async, [canceler]() {
+        canceler->cancel();
+    }));
+}
+
+void MainWindow::onImportFinished(bool ok, bool canceled, const ImportResult& result, const QString& errorFileName) {
+    importCanceler.reset();
+    if (importProgress) {
+        importProgress->deleteLater();
+        importProgress = nullptr;
+    }
+    
+    if (canceled) {
+        statusBar()->showMessage("Импорт отменен, фонд не изменен");
+    } else if (ok) {
+        QString message = QString("Импортировано домов: %1 из %2")
+            .arg(result.importedRows)
+            .arg(result.totalRows);
+        if (result.rejectedRows > 0) {
+            message += QString("\nОтклонено строк: %1\nПодробности в файле:\n%2")
+                .arg(result.rejectedRows)
+                .arg(errorFileName);
+        }
+        showInfo(message);
+        loadHouses();
+    } else {
+        showError("Ошибка при импорте данных из файла");
+    }
+}
+
+void MainWindow::pruneImportWorkers() {
+    importWorkers.erase(remove_if(importWorkers.begin(), importWorkers.end(), [](const future<void>& worker) {
+        return worker.wait_for(chrono::seconds(0)) == future_status::ready;
+    }), importWorkers.end());
+}
+
 void MainWindow::onExit() {
     if (confirmAction("Выход", "Вы уверены, что хотите выйти из программы?")) {
         qApp->quit();
@@ -819,17 +1108,84 @@ void MainWindow::onExit() {
 }
 
 void MainWindow::updateStatusBar() {
-    QTableWidget* table = findChild<QTableWidget*>();
-    if (table) {
-        int count = table->rowCount();
+    if (houseView && houseView->model()) {
+        int count = houseView->model()->rowCount();
         QString filterInfo = currentFilters.isActive() ? " (с фильтрами)" : "";
-        statusBar()->showMessage(QString("Всего домов: %1%2 | %3")
-            .arg(count)
+        // Пока выборка подгружается, известно только число загруженных строк
+        bool loading = pagedModel ? !pagedModel->allRowsLoaded() : houseLoader->isLoading();
+        QString countInfo = loading
+            ? QString("Загружено домов: %1").arg(count)
+            : QString("Всего домов: %1").arg(count);
+        statusBar()->showMessage(QString("%1%2 | %3")
+            .arg(countInfo)
             .arg(filterInfo)
             .arg(QDateTime::currentDateTime().toString("dd.MM.yyyy HH:mm")));
     }
 }
 
+void MainWindow::startSearch(bool immediate) {
+    if (!pagedModel) {
+        // Все дома уже в памяти: индекс отвечает сразу, без запроса к базе
+        applyView();
+        if (!currentFilters.addressFilter.isEmpty() && !houseLoader->isLoading()) {
+            statusBar()->showMessage(QString("Применен фильтр по адресу: %1 (найдено: %2)")
+                .arg(currentFilters.addressFilter)
+                .arg(houseModel->rowCount()));
+        }
+        return;
+    }
+    
+    // Для постраничной модели достаточно первой страницы, остальное подгрузится
+    HouseQuery query = currentQuery();
+    if (immediate) {
+        addressSearch->searchNow(query, PagedHouseModel::PAGE_SIZE);
+    } else {
+        addressSearch->search(query, PagedHouseModel::PAGE_SIZE);
+    }
+    statusBar()->showMessage(QString("Поиск: %1...").arg(currentFilters.addressFilter));
+}
+
+void MainWindow::onSearchFinished(const HouseQuery& query, const vector<House>& houses) {
+    // Фильтры и сортировка уже применены сервером; поиск запускается только для постраничной модели
+    pagedModel->setQuery(query, houses);
+    updateStatusBar();
+    
+    if (!currentFilters.addressFilter.isEmpty()) {
+        statusBar()->showMessage(QString("Применен фильтр по адресу: %1 (найдено: %2%3)")
+            .arg(currentFilters.addressFilter)
+            .arg(static_cast<int>(houses.size()))
+            .arg(!pagedModel->allRowsLoaded() ? "+" : ""));
+    }
+}
+
+HouseQuery MainWindow::currentQuery() const {
+    HouseQuery query;
+    query.filtered = currentFilters.isActive();
+    query.minYear = currentFilters.minYear;
+    query.maxYear = currentFilters.maxYear;
+    query.minApartments = currentFilters.minApartments;
+    query.maxApartments = currentFilters.maxApartments;
+    query.minArea = currentFilters.minArea;
+    query.maxArea = currentFilters.maxArea;
+    query.minFloors = currentFilters.minFloors;
+    query.maxFloors = currentFilters.maxFloors;
+    query.addressPattern = currentFilters.addressFilter.toStdString();
+    for (const SortColumn& sc : sortColumns) {
+        query.sortKeys.push_back({sc.column, sc.ascending});
+    }
+    return query;
+}
+
+House MainWindow::houseAtRow(int row) const {
+    return pagedModel ? pagedModel->houseAt(row) : houseModel->houseAt(row);
+}
+
+const HouseTable& MainWindow::visibleHouses(HouseTable& fetched) const {
+    if (!pagedModel) return houseModel->houses(fetched);
+    fetched = pagedModel->houses();
+    return fetched;
+}
+
 bool MainWindow::confirmAction(const QString& title, const QString& message) {
     return QMessageBox::question(this, title, message, 
                                 QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
@@ -844,26 +1200,17 @@ void MainWindow::showInfo(const QString& message) {
 }
 
 void MainWindow::onHouseSelected(int row, int column) {
-    QTableWidget* table = findChild<QTableWidget*>();
-    if (!table || row < 0) return;
-    
-    QTableWidgetItem* item = table->item(row, 0);
-    if (!item) return;
-    
-    int houseId = item->data(Qt::UserRole).toInt();
-    
-    // Получаем информацию о доме
-    auto houses = dbManager->getAllHouses();
-    for (const auto& house : houses) {
-        if (house.id == houseId) {
-            QString info = QString("Выбран дом: %1 | Квартир: %2 | Площадь: %3 м² | Год: %4 | Этажей: %5")
-                .arg(QString::fromStdString(house.address))
-                .arg(house.apartments)
-                .arg(house.totalArea, 0, 'f', 2)
-                .arg(house.buildYear)
-                .arg(house.floors);
-            statusBar()->showMessage(info, 5000);
-            break;
-        }
-    }
+    if (!houseView || row < 0 || row >= houseView->model()->rowCount()) return;
+    
+    // Данные строки уже есть в модели, запрос к базе не нужен; строку,
+    // которую постраничная модель еще загружает, нечего показать
+    House house = houseAtRow(row);
+    if (house.id <= 0) return;
+    QString info = QString("Выбран дом: %1 | Квартир: %2 | Площадь: %3 м² | Год: %4 | Этажей: %5")
+        .arg(QString::fromStdString(house.address))
+        .arg(house.apartments)
+        .arg(QString::fromStdString(house.totalArea.toString()))
+        .arg(house.buildYear)
+        .arg(house.floors);
+    statusBar()->showMessage(info, 5000);
 }
@@ -10,9 +10,19 @@
 #include <QInputDialog>
 #include <QBoxLayout>
 #include <QHBoxLayout>
-#include <QTableWidget>
+#include <QTableView>
 #include <QSortFilterProxyModel>
+#include <QProgressBar>
+#include <QProgressDialog>
+#include <memory>
+#include <future>
 #include "../database/DatabaseManager.h"
+#include "../utils/HouseSnapshot.h"
+#include "HouseTableModel.h"
+#include "PagedHouseModel.h"
+#include "AddressSearch.h"
+#include "HouseSortKeys.h"
+#include "HouseLoader.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -26,8 +36,8 @@ struct FilterSettings {
     int maxYear = QDate::currentDate().year();
     int minApartments = 0;
     int maxApartments = 1000;
-    double minArea = 0.0;
-    double maxArea = 100000.0;
+    Area minArea = Area(0);
+    Area maxArea = Area(10000000);      // 100000.00 м²
     QString addressFilter;
     int minFloors = 0;
     int maxFloors = 100;
@@ -35,7 +45,7 @@ struct FilterSettings {
     bool isActive() const {
         return (minYear > 1500 || maxYear < QDate::currentDate().year() ||
                 minApartments > 0 || maxApartments < 1000 ||
-                minArea > 0.0 || maxArea < 100000.0 ||
+                minArea > Area(0) || maxArea < Area(10000000) ||
                 !addressFilter.isEmpty() ||
                 minFloors > 0 || maxFloors < 100);
     }
@@ -45,7 +55,8 @@ class MainWindow : public QMainWindow {
     Q_OBJECT
 
 public:
-    explicit MainWindow(DatabaseManager* dbManager, QWidget* parent = nullptr);
+    // preloader - загрузка домов, начатая до входа; окно становится ее владельцем
+    explicit MainWindow(DatabaseManager* dbManager, HouseLoader* preloader = nullptr, QWidget* parent = nullptr);
     ~MainWindow();
 
 private slots:
@@ -53,18 +64,55 @@ private slots:
     void onEditHouse();
     void onDeleteHouses();
     void onExport();
+    void onImport();
     void onFilter();
     void onClearFilters();
     void onRefresh();
     void onExit();
     void updateStatusBar();
     void onHouseSelected(int row, int column);
+    void onSearchFinished(const HouseQuery& query, const vector<House>& houses);
+    void onLoadPage(const HouseTable& page);
+    void onLoadFinished(shared_ptr<HouseSnapshot> loaded);
+    void onLoadFailed();
+    void onSharedSnapshotChanged();
+    void cancelImport();
 
 private:
     Ui::MainWindow* ui;
     DatabaseManager* dbManager;
     
     FilterSettings currentFilters;
+    QTableView* houseView;
+    // Используется одна из моделей: весь список в памяти или постраничная загрузка
+    HouseTableModel* houseModel;
+    PagedHouseModel* pagedModel;
+    AddressSearch* addressSearch;
+    
+    // Режим в памяти: все дома из базы и индексы по ним.
+    // Фильтры, поиск и сортировка работают по этому снимку без запросов к базе
+    shared_ptr<HouseSnapshot> snapshot;
+    HouseSortKeys houseSortKeys;
+    
+    // Снимок загружается в фоне; пока вид без фильтров и сортировки,
+    // страницы сразу добавляются в таблицу
+    HouseLoader* houseLoader;
+    QProgressBar* loadProgress;
+    bool streamPages;
+    // Правки, сделанные во время загрузки, применяются к готовому снимку
+    struct PendingChange {
+        House house;
+        bool removed;
+    };
+    vector<PendingChange> pendingChanges;
+    
+    // Импорт из файла в фоне: окно хода с отменой, итог приходит в поток интерфейса
+    static constexpr int IMPORT_PROGRESS_STEPS = 1000;
+    shared_ptr<QueryCanceler> importCanceler;
+    QProgressDialog* importProgress;
+    vector<future<void>> importWorkers;
+    
+    static constexpr int SORT_LEVELS = 3;
     
     struct SortColumn {
         int column;
@@ -72,12 +120,16 @@ private:
     };
     QList<SortColumn> sortColumns;
     
-    void setupUI();
+    void setupUI(HouseLoader* preloader);
     void setupTable();
     void loadHouses();
-    void loadHouses(const vector<House>& houses);
-    void applyFilters(vector<House>& houses);
-    void applySorting(vector<House>& houses);
+    void resumePreload();
+    void applyView();
+    void updateLoadedHouse(const House& house);
+    void removeLoadedHouse(int houseId);
+    void onImportProgress(size_t done, size_t total);
+    void onImportFinished(bool ok, bool canceled, const ImportResult& result, const QString& errorFileName);
+    void pruneImportWorkers();
     void showFilterDialog();
     void showAdvancedDeleteDialog();
     
@@ -85,8 +137,12 @@ private:
     void showError(const QString& message);
     void showInfo(const QString& message);
     
-    bool matchesFilters(const House& house) const;
-    bool compareHouses(const House& a, const House& b) const;
+    void startSearch(bool immediate);
+    HouseQuery currentQuery() const;
+    House houseAtRow(int row) const;
+    // Строки представления; постраничная выборка и строки снимка копируются в fetched
+    const HouseTable& visibleHouses(HouseTable& fetched) const;
+    
 };
 
 #endif
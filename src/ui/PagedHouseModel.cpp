@@ -0,0 +1,406 @@
+#include "PagedHouseModel.h"
+#include "HouseTableModel.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+namespace {
+
+// Ключ запроса следующей страницы в конец выборки
+const uint64_t APPEND_PAGE = 0;
+
+// Следующая страница запрашивается, когда до конца загруженных строк остается столько
+const int PREFETCH_ROWS = PagedHouseModel::PAGE_SIZE;
+
+}
+
+PagedHouseModel::PagedHouseModel(DatabaseManager* dbManager, QObject* parent)
+    : QAbstractTableModel(parent), dbManager(dbManager), generation(0), nextPageKey(1),
+      totalRows(0), firstPagePending(false), endReached(true), appendInFlight(false), hasTail(false),
+      memoryBudget(DEFAULT_MEMORY_BUDGET), totalBytes(0), lastAccessedRow(0) {}
+
+PagedHouseModel::~PagedHouseModel() {
+    // Потоки обращаются к модели, поэтому дожидаемся их до разрушения
+    waitWorkers();
+}
+
+int PagedHouseModel::rowCount(const QModelIndex& parent) const {
+    if (parent.isValid()) return 0;
+    // Пока первая страница в пути, выборка показана одной строкой-заглушкой
+    return firstPagePending ? 1 : totalRows;
+}
+
+int PagedHouseModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : HouseTableModel::COLUMN_COUNT;
+}
+
+QVariant PagedHouseModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid()) return QVariant();
+    if (firstPagePending && role == Qt::DisplayRole && index.row() == 0 &&
+        index.column() == HouseTableModel::COLUMN_ADDRESS) {
+        return QString("Загрузка...");
+    }
+    if (index.row() >= totalRows) return QVariant();
+    if (role != Qt::DisplayRole && role != Qt::UserRole) return QVariant();
+
+    // Обращения представления к строкам показывают, где сейчас прокрутка
+    PagedHouseModel* self = const_cast<PagedHouseModel*>(this);
+    int row = index.row();
+    self->touchRow(row);
+
+    int pageIndex = pageIndexForRow(row);
+    const Page& page = pages[pageIndex];
+    if (!page.loaded) {
+        self->requestPage(pageIndex);
+        if (role == Qt::DisplayRole && index.column() == HouseTableModel::COLUMN_ADDRESS) {
+            return QString("Загрузка...");
+        }
+        return QVariant();
+    }
+
+    const House& house = page.rows[row - page.firstRow];
+    if (role == Qt::UserRole) {
+        return house.id;
+    }
+
+    return HouseTableModel::displayValue(house, index.column());
+}
+
+QVariant PagedHouseModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole) return QVariant();
+    if (orientation == Qt::Vertical) return section + 1;
+    return HouseTableModel::columnTitle(section);
+}
+
+bool PagedHouseModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && !endReached;
+}
+
+void PagedHouseModel::fetchMore(const QModelIndex& parent) {
+    if (parent.isValid()) return;
+    requestNextPage();
+}
+
+bool PagedHouseModel::removeRows(int row, int count, const QModelIndex& parent) {
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > totalRows) return false;
+
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+    for (int current = row + count - 1; current >= row; --current) {
+        int pageIndex = pageIndexForRow(current);
+        Page& page = pages[pageIndex];
+
+        if (page.loaded) {
+            size_t bytes = houseBytes(page.rows[current - page.firstRow]);
+            page.bytes -= bytes;
+            totalBytes -= bytes;
+            page.rows.erase(page.rows.begin() + (current - page.firstRow));
+            page.lastId = page.rows.empty() ? 0 : page.rows.back().id;
+        } else {
+            // Неизвестно, была ли удаленная строка последней
+            page.lastId = 0;
+        }
+        page.rowCount--;
+        for (size_t i = pageIndex + 1; i < pages.size(); ++i) {
+            pages[i].firstRow--;
+        }
+
+        // Ключ after следующей страницы хранится в ней самой, поэтому
+        // пустую страницу можно просто убрать
+        if (page.rowCount == 0) {
+            totalBytes -= page.bytes;
+            pages.erase(pages.begin() + pageIndex);
+        }
+        totalRows--;
+    }
+    endRemoveRows();
+    return true;
+}
+
+void PagedHouseModel::setQuery(const HouseQuery& newQuery) {
+    // Первая страница загружается в фоне, как и остальные: поток интерфейса
+    // не ждет сервер; до ее прихода видна строка "Загрузка..."
+    beginResetModel();
+    resetPages(newQuery);
+    firstPagePending = true;
+    appendInFlight = true;
+    endResetModel();
+
+    startLoad(APPEND_PAGE, false, House());
+}
+
+void PagedHouseModel::setQuery(const HouseQuery& newQuery, const vector<House>& firstPage) {
+    beginResetModel();
+    resetPages(newQuery);
+
+    vector<House> rows(firstPage.begin(),
+                       firstPage.begin() + min<size_t>(firstPage.size(), PAGE_SIZE));
+    addPage(move(rows));
+    endResetModel();
+
+    requestNextPage();
+}
+
+void PagedHouseModel::resetPages(const HouseQuery& newQuery) {
+    generation++;
+    query = newQuery;
+    pages.clear();
+    totalRows = 0;
+    totalBytes = 0;
+    firstPagePending = false;
+    endReached = false;
+    appendInFlight = false;
+    hasTail = false;
+    lastAccessedRow = 0;
+}
+
+void PagedHouseModel::reload() {
+    HouseQuery current = query;
+    setQuery(current);
+}
+
+void PagedHouseModel::updateHouse(int row, const House& house) {
+    if (row < 0 || row >= totalRows) return;
+
+    Page& page = pages[pageIndexForRow(row)];
+    if (!page.loaded) return;
+
+    House& stored = page.rows[row - page.firstRow];
+    size_t oldBytes = houseBytes(stored);
+    stored = house;
+    size_t newBytes = houseBytes(stored);
+    page.bytes = page.bytes - oldBytes + newBytes;
+    totalBytes = totalBytes - oldBytes + newBytes;
+    emit dataChanged(index(row, 0), index(row, HouseTableModel::COLUMN_COUNT - 1));
+}
+
+int PagedHouseModel::houseId(int row) const {
+    return houseAt(row).id;
+}
+
+House PagedHouseModel::houseAt(int row) const {
+    if (row < 0 || row >= totalRows) return House();
+
+    int pageIndex = pageIndexForRow(row);
+    const Page& page = pages[pageIndex];
+    if (!page.loaded) {
+        // Страница загружается в фоне, как для представления
+        const_cast<PagedHouseModel*>(this)->requestPage(pageIndex);
+        return House();
+    }
+    return page.rows[row - page.firstRow];
+}
+
+HouseTable PagedHouseModel::houses() const {
+    HouseTable result;
+    dbManager->fetchHousePage(query, nullptr, 0, result);
+    return result;
+}
+
+bool PagedHouseModel::allRowsLoaded() const {
+    return endReached;
+}
+
+size_t PagedHouseModel::cachedBytes() const {
+    return totalBytes;
+}
+
+void PagedHouseModel::setMemoryBudget(size_t bytes) {
+    memoryBudget = bytes;
+    evictPages();
+}
+
+int PagedHouseModel::pageIndexForRow(int row) const {
+    auto it = upper_bound(pages.begin(), pages.end(), row,
+                          [](int value, const Page& page) { return value < page.firstRow; });
+    return static_cast<int>(it - pages.begin()) - 1;
+}
+
+int PagedHouseModel::pageIndexForKey(uint64_t key) const {
+    for (size_t i = 0; i < pages.size(); ++i) {
+        if (pages[i].key == key) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void PagedHouseModel::requestNextPage() {
+    if (endReached || appendInFlight || !hasTail) return;
+
+    appendInFlight = true;
+    startLoad(APPEND_PAGE, true, tail);
+}
+
+void PagedHouseModel::requestPage(int pageIndex) {
+    Page& page = pages[pageIndex];
+    if (page.loaded || page.loading) return;
+
+    page.loading = true;
+    startLoad(page.key, page.hasAfter, page.after);
+}
+
+void PagedHouseModel::startLoad(uint64_t pageKey, bool hasAfter, const House& after) {
+    pruneWorkers();
+
+    uint64_t loadGeneration = generation;
+    HouseQuery loadQuery = query;
+    workers.push_back(async(launch::async, [this, loadGeneration, loadQuery, pageKey, hasAfter, after]() {
+        vector<House> rows;
+        bool ok = dbManager->fetchHousePage(loadQuery, hasAfter ? &after : nullptr, PAGE_SIZE, rows);
+
+        // Результат применяется в потоке интерфейса
+        QMetaObject::invokeMethod(this, [this, loadGeneration, pageKey, ok, rows]() {
+            onPageLoaded(loadGeneration, pageKey, ok, rows);
+        }, Qt::QueuedConnection);
+    }));
+}
+
+void PagedHouseModel::onPageLoaded(uint64_t loadGeneration, uint64_t pageKey, bool ok, vector<House> rows) {
+    // Ответ на запрос по прежним фильтрам или сортировке
+    if (loadGeneration != generation) return;
+
+    if (pageKey == APPEND_PAGE) {
+        appendInFlight = false;
+        if (firstPagePending) {
+            // Заглушка заменяется первой страницей; при ошибке выборка пуста
+            beginResetModel();
+            firstPagePending = false;
+            if (ok) addPage(move(rows));
+            else endReached = true;
+            endResetModel();
+            if (ok) requestNextPage();
+            return;
+        }
+        if (!ok) return;
+
+        appendPage(move(rows));
+        evictPages();
+        if (lastAccessedRow >= totalRows - PREFETCH_ROWS) {
+            requestNextPage();
+        }
+        return;
+    }
+
+    int pageIndex = pageIndexForKey(pageKey);
+    if (pageIndex < 0) return;
+
+    Page& page = pages[pageIndex];
+    page.loading = false;
+    if (!ok) return;
+
+    // На сервере строки удалили или добавили: номера строк ниже уже неверны
+    if (!matchPage(page, rows)) {
+        reload();
+        return;
+    }
+    storeRows(page, move(rows));
+    emit dataChanged(index(page.firstRow, 0),
+                     index(page.firstRow + page.rowCount - 1, HouseTableModel::COLUMN_COUNT - 1));
+    evictPages();
+}
+
+void PagedHouseModel::addPage(vector<House>&& rows) {
+    if (rows.size() < static_cast<size_t>(PAGE_SIZE)) endReached = true;
+    if (rows.empty()) return;
+
+    Page page;
+    page.key = nextPageKey++;
+    page.firstRow = totalRows;
+    page.rowCount = static_cast<int>(rows.size());
+    page.hasAfter = hasTail;
+    page.after = tail;
+    page.loaded = false;
+    page.loading = false;
+    page.bytes = 0;
+    page.lastId = 0;
+
+    tail = rows.back();
+    hasTail = true;
+    totalRows += page.rowCount;
+    storeRows(page, move(rows));
+    pages.push_back(move(page));
+}
+
+void PagedHouseModel::appendPage(vector<House>&& rows) {
+    if (rows.empty()) {
+        endReached = true;
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), totalRows, totalRows + static_cast<int>(rows.size()) - 1);
+    addPage(move(rows));
+    endInsertRows();
+}
+
+void PagedHouseModel::storeRows(Page& page, vector<House>&& rows) {
+    if (page.loaded) totalBytes -= page.bytes;
+
+    page.bytes = 0;
+    for (const auto& house : rows) {
+        page.bytes += houseBytes(house);
+    }
+    totalBytes += page.bytes;
+    page.rows = move(rows);
+    page.lastId = page.rows.empty() ? 0 : page.rows.back().id;
+    page.loaded = true;
+}
+
+bool PagedHouseModel::matchPage(const Page& page, vector<House>& rows) {
+    // Страница после выгрузки совпадает с прежней, если она не короче и
+    // кончается той же строкой; строки сверх нее - начало следующей страницы
+    if (rows.size() < static_cast<size_t>(page.rowCount)) return false;
+    rows.resize(page.rowCount);
+    return page.lastId == 0 || rows.back().id == page.lastId;
+}
+
+void PagedHouseModel::evictPages() {
+    while (totalBytes > memoryBudget) {
+        // Выгружаем страницу, дальше всех отстоящую от просматриваемой строки
+        int victim = -1;
+        int victimDistance = 0;
+        for (size_t i = 0; i < pages.size(); ++i) {
+            const Page& page = pages[i];
+            if (!page.loaded) continue;
+
+            int lastRow = page.firstRow + page.rowCount - 1;
+            int distance = lastAccessedRow < page.firstRow ? page.firstRow - lastAccessedRow
+                         : lastAccessedRow > lastRow ? lastAccessedRow - lastRow : 0;
+            if (distance > victimDistance) {
+                victim = static_cast<int>(i);
+                victimDistance = distance;
+            }
+        }
+        if (victim < 0) break;
+
+        Page& page = pages[victim];
+        totalBytes -= page.bytes;
+        page.bytes = 0;
+        page.loaded = false;
+        vector<House>().swap(page.rows);
+    }
+}
+
+void PagedHouseModel::pruneWorkers() {
+    workers.erase(remove_if(workers.begin(), workers.end(), [](const future<void>& worker) {
+        return worker.wait_for(chrono::seconds(0)) == future_status::ready;
+    }), workers.end());
+}
+
+void PagedHouseModel::waitWorkers() {
+    for (auto& worker : workers) {
+        worker.wait();
+    }
+    workers.clear();
+}
+
+void PagedHouseModel::touchRow(int row) {
+    lastAccessedRow = row;
+    if (row >= totalRows - PREFETCH_ROWS) {
+        requestNextPage();
+    }
+}
+
+size_t PagedHouseModel::houseBytes(const House& house) {
+    // Короткие адреса хранятся внутри string без отдельного выделения
+    size_t heap = house.address.capacity() > 15 ? house.address.capacity() : 0;
+    return sizeof(House) + heap;
+}
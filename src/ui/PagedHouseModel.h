@@ -0,0 +1,102 @@
+#ifndef PAGEDHOUSEMODEL_H
+#define PAGEDHOUSEMODEL_H
+
+#include <QAbstractTableModel>
+#include <vector>
+#include <future>
+#include <cstdint>
+#include "../database/DatabaseManager.h"
+#include "../models/House.h"
+
+using namespace std;
+
+// Модель таблицы, которая подгружает дома страницами по мере прокрутки.
+// Страницы выбираются по ключу сортировки (keyset), следующая страница
+// загружается заранее в фоне, дальние от просматриваемой строки страницы
+// выгружаются при превышении бюджета памяти и загружаются снова по запросу
+class PagedHouseModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    static constexpr int PAGE_SIZE = 500;
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 32 * 1024 * 1024;
+
+    explicit PagedHouseModel(DatabaseManager* dbManager, QObject* parent = nullptr);
+    ~PagedHouseModel();
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+    bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
+
+    // Новая выборка: первая страница загружается в фоне сразу, остальные по прокрутке
+    void setQuery(const HouseQuery& query);
+    // Выборка с уже загруженной первой страницей (например, из фонового поиска)
+    void setQuery(const HouseQuery& query, const vector<House>& firstPage);
+    void reload();
+
+    void updateHouse(int row, const House& house);
+    int houseId(int row) const;
+    // Строка выгруженной или еще не полученной страницы - House() с id 0;
+    // страница запрашивается в фоне, как при прокрутке
+    House houseAt(int row) const;
+    // Все строки выборки (запрос без ограничения)
+    HouseTable houses() const;
+
+    bool allRowsLoaded() const;
+    size_t cachedBytes() const;
+    void setMemoryBudget(size_t bytes);
+
+private:
+    struct Page {
+        uint64_t key;           // не меняется при удалении строк выше
+        int firstRow;
+        int rowCount;
+        bool hasAfter;
+        House after;            // последняя строка предыдущей страницы
+        bool loaded;
+        bool loading;
+        vector<House> rows;
+        size_t bytes;
+        int lastId;             // id последней строки; 0 - неизвестен
+    };
+
+    DatabaseManager* dbManager;
+    HouseQuery query;
+    uint64_t generation;
+    uint64_t nextPageKey;
+    vector<Page> pages;
+    int totalRows;
+    bool firstPagePending;      // первая страница выборки еще загружается
+    bool endReached;
+    bool appendInFlight;
+    bool hasTail;
+    House tail;                 // последняя загруженная строка выборки
+    size_t memoryBudget;
+    size_t totalBytes;
+    int lastAccessedRow;
+    vector<future<void>> workers;
+
+    void resetPages(const HouseQuery& newQuery);
+    int pageIndexForRow(int row) const;
+    int pageIndexForKey(uint64_t key) const;
+    void requestNextPage();
+    void requestPage(int pageIndex);
+    void startLoad(uint64_t pageKey, bool hasAfter, const House& after);
+    void onPageLoaded(uint64_t loadGeneration, uint64_t pageKey, bool ok, vector<House> rows);
+    void addPage(vector<House>&& rows);
+    void appendPage(vector<House>&& rows);
+    void storeRows(Page& page, vector<House>&& rows);
+    static bool matchPage(const Page& page, vector<House>& rows);
+    void evictPages();
+    void pruneWorkers();
+    void waitWorkers();
+    void touchRow(int row);
+
+    static size_t houseBytes(const House& house);
+};
+
+#endif
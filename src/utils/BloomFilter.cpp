@@ -0,0 +1,110 @@
+#include "BloomFilter.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+BloomFilter::BloomFilter()
+    : numBits(0), numHashes(0), numItems(0) {}
+
+void BloomFilter::reset(size_t expectedItems, double targetFalsePositiveRate) {
+    if (expectedItems < 1024) expectedItems = 1024;
+    if (targetFalsePositiveRate <= 0.0 || targetFalsePositiveRate >= 1.0) {
+        targetFalsePositiveRate = 0.01;
+    }
+
+    // m = -n * ln(p) / ln(2)^2, k = m / n * ln(2)
+    const double ln2 = log(2.0);
+    double m = -static_cast<double>(expectedItems) * log(targetFalsePositiveRate) / (ln2 * ln2);
+    size_t words = static_cast<size_t>(ceil(m / 64.0));
+
+    bits.assign(max<size_t>(words, 1), 0);
+    numBits = bits.size() * 64;
+    numHashes = static_cast<size_t>(round(static_cast<double>(numBits) / expectedItems * ln2));
+    numHashes = min<size_t>(max<size_t>(numHashes, 1), 16);
+    numItems = 0;
+}
+
+void BloomFilter::clear() {
+    fill(bits.begin(), bits.end(), 0);
+    numItems = 0;
+}
+
+void BloomFilter::add(const string& key) {
+    addHash(hashKey(key));
+}
+
+void BloomFilter::addHash(uint64_t keyHash) {
+    if (numBits == 0) return;
+
+    for (size_t i = 0; i < numHashes; ++i) {
+        size_t bit = bitIndex(keyHash, i);
+        bits[bit >> 6] |= (uint64_t(1) << (bit & 63));
+    }
+    ++numItems;
+}
+
+bool BloomFilter::mightContain(const string& key) const {
+    return mightContainHash(hashKey(key));
+}
+
+bool BloomFilter::mightContainHash(uint64_t keyHash) const {
+    // Пустой (не построенный) фильтр ничего не отсекает
+    if (numBits == 0) return true;
+
+    for (size_t i = 0; i < numHashes; ++i) {
+        size_t bit = bitIndex(keyHash, i);
+        if (!(bits[bit >> 6] & (uint64_t(1) << (bit & 63)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BloomFilter::isEmpty() const {
+    return numItems == 0;
+}
+
+size_t BloomFilter::itemCount() const {
+    return numItems;
+}
+
+size_t BloomFilter::bitCount() const {
+    return numBits;
+}
+
+size_t BloomFilter::hashCount() const {
+    return numHashes;
+}
+
+size_t BloomFilter::memoryBytes() const {
+    return bits.capacity() * sizeof(uint64_t);
+}
+
+double BloomFilter::estimatedFalsePositiveRate() const {
+    if (numBits == 0) return 1.0;
+
+    // p = (1 - e^(-k * n / m))^k
+    double exponent = -static_cast<double>(numHashes) * numItems / numBits;
+    return pow(1.0 - exp(exponent), static_cast<double>(numHashes));
+}
+
+uint64_t BloomFilter::hashKey(const string& key) {
+    // FNV-1a 64
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+size_t BloomFilter::bitIndex(uint64_t keyHash, size_t i) const {
+    // Двойное хеширование: h1 + i * h2, второй хеш получаем перемешиванием первого
+    uint64_t h2 = keyHash;
+    h2 ^= h2 >> 33;
+    h2 *= 0xff51afd7ed558ccdULL;
+    h2 ^= h2 >> 33;
+    h2 |= 1;
+    return static_cast<size_t>((keyHash + i * h2) % numBits);
+}
@@ -0,0 +1,44 @@
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Вероятностное множество строк: ответ "нет" точный,
+// ответ "возможно" требует проверки на сервере
+class BloomFilter {
+public:
+    BloomFilter();
+
+    // Пересоздает пустой фильтр под ожидаемое количество элементов
+    void reset(size_t expectedItems, double targetFalsePositiveRate = 0.01);
+    void clear();
+
+    void add(const string& key);
+    void addHash(uint64_t keyHash);
+    bool mightContain(const string& key) const;
+    bool mightContainHash(uint64_t keyHash) const;
+
+    bool isEmpty() const;
+    size_t itemCount() const;
+    size_t bitCount() const;
+    size_t hashCount() const;
+    size_t memoryBytes() const;
+    double estimatedFalsePositiveRate() const;
+
+    static uint64_t hashKey(const string& key);
+
+private:
+    vector<uint64_t> bits;
+    size_t numBits;
+    size_t numHashes;
+    size_t numItems;
+
+    size_t bitIndex(uint64_t keyHash, size_t i) const;
+};
+
+#endif
@@ -0,0 +1,160 @@
+#include "BufferedFileWriter.h"
+#include "GzipCompressor.h"
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+BufferedFileWriter::BufferedFileWriter(size_t bufferSize)
+    : fd(-1), capacity(bufferSize > 0 ? bufferSize : DEFAULT_BUFFER_SIZE),
+      used(0), written(0), failed(false) {
+    buffer.resize(capacity);
+}
+
+BufferedFileWriter::~BufferedFileWriter() {
+    close();
+}
+
+bool BufferedFileWriter::open(const string& filename, int compressionLevel) {
+    close();
+
+    fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    used = 0;
+    written = 0;
+    failed = fd < 0;
+
+    if (!failed && compressionLevel > 0) {
+        compressor.reset(new GzipCompressor(fd, compressionLevel > 9 ? 9 : compressionLevel));
+        compressor->start();
+    }
+    return !failed;
+}
+
+bool BufferedFileWriter::openAt(const string& filename, uint64_t offset) {
+    close();
+
+    fd = ::open(filename.c_str(), O_WRONLY | O_CREAT, 0644);
+    used = 0;
+    written = offset;
+    
+    // Файл короче offset дополнять нулями нельзя
+    struct stat st;
+    failed = fd < 0 || fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < offset ||
+             ftruncate(fd, static_cast<off_t>(offset)) != 0 ||
+             lseek(fd, static_cast<off_t>(offset), SEEK_SET) < 0;
+    return !failed;
+}
+
+bool BufferedFileWriter::write(const char* data, size_t size) {
+    if (fd < 0 || failed) return false;
+
+    if (used + size <= capacity) {
+        memcpy(buffer.data() + used, data, size);
+        used += size;
+        return true;
+    }
+
+    // Крупный блок без сжатия пишем напрямую, минуя буфер
+    if (!compressor && size >= capacity) {
+        return flush() && writeAll(data, size);
+    }
+
+    while (size > 0) {
+        size_t part = min(size, capacity - used);
+        memcpy(buffer.data() + used, data, part);
+        used += part;
+        data += part;
+        size -= part;
+        if (used == capacity && !flush()) return false;
+    }
+    return true;
+}
+
+bool BufferedFileWriter::write(string_view text) {
+    return write(text.data(), text.size());
+}
+
+bool BufferedFileWriter::put(char c) {
+    if (used < capacity && fd >= 0 && !failed) {
+        buffer[used++] = c;
+        return true;
+    }
+    return write(&c, 1);
+}
+
+bool BufferedFileWriter::flush() {
+    if (fd < 0 || failed) return false;
+    if (used == 0) return true;
+
+    if (compressor) {
+        // Заполненный буфер уходит потоку сжатия, взамен берем свободный
+        buffer.resize(used);
+        written += used;
+        used = 0;
+        if (!compressor->submit(move(buffer))) {
+            failed = true;
+            return false;
+        }
+        buffer = compressor->takeFreeBuffer();
+        buffer.resize(capacity);
+        return true;
+    }
+
+    bool ok = writeAll(buffer.data(), used);
+    used = 0;
+    return ok;
+}
+
+bool BufferedFileWriter::sync() {
+    if (compressor) return false;
+    if (!flush()) return false;
+    if (fdatasync(fd) != 0) {
+        failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool BufferedFileWriter::close() {
+    if (fd < 0) return !failed;
+
+    bool ok = flush();
+    if (compressor) {
+        if (!compressor->finish()) ok = false;
+        compressor.reset();
+    }
+    if (::close(fd) != 0) ok = false;
+    fd = -1;
+    if (!ok) failed = true;
+    return ok;
+}
+
+bool BufferedFileWriter::isOpen() const {
+    return fd >= 0;
+}
+
+bool BufferedFileWriter::hasFailed() const {
+    return failed;
+}
+
+uint64_t BufferedFileWriter::bytesWritten() const {
+    return written + used;
+}
+
+bool BufferedFileWriter::writeAll(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            failed = true;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        written += static_cast<uint64_t>(n);
+    }
+    return true;
+}
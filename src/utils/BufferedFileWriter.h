@@ -0,0 +1,55 @@
+#ifndef BUFFEREDFILEWRITER_H
+#define BUFFEREDFILEWRITER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+class GzipCompressor;
+
+// Запись в файл крупными блоками без потоков iostream
+class BufferedFileWriter {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 4 * 1024 * 1024;
+
+    explicit BufferedFileWriter(size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    ~BufferedFileWriter();
+
+    BufferedFileWriter(const BufferedFileWriter&) = delete;
+    BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+    // compressionLevel: 0 - без сжатия, 1-9 - gzip в фоновом потоке
+    bool open(const string& filename, int compressionLevel = 0);
+    // Дописывает несжатый файл, предварительно обрезав его до offset байт
+    bool openAt(const string& filename, uint64_t offset);
+    bool write(const char* data, size_t size);
+    bool write(string_view text);
+    bool put(char c);
+    bool flush();
+    // flush и fdatasync: данные до bytesWritten() на диске (только без сжатия)
+    bool sync();
+    bool close();
+
+    bool isOpen() const;
+    bool hasFailed() const;
+    // Объем данных до сжатия
+    uint64_t bytesWritten() const;
+
+private:
+    int fd;
+    vector<char> buffer;
+    size_t capacity;
+    size_t used;
+    uint64_t written;
+    bool failed;
+    unique_ptr<GzipCompressor> compressor;
+
+    bool writeAll(const char* data, size_t size);
+};
+
+#endif
@@ -0,0 +1,461 @@
+#include "ColumnarFormat.h"
+#include "HouseFields.h"
+#include "ExportCheckpoint.h"
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <unordered_map>
+
+using namespace std;
+using namespace ColumnarFormat;
+
+namespace {
+
+// Размер записи о блоке столбца в оглавлении
+const size_t CHUNK_META_SIZE = 40;
+const size_t TAIL_SIZE = 16;
+
+// Последовательное чтение из отображения с проверкой границ
+class Cursor {
+public:
+    Cursor(const char* data, size_t size, size_t offset)
+        : data(data), size(size), offset(offset), ok(offset <= size) {}
+
+    template <typename T>
+    T read() {
+        T value{};
+        if (!ok || size - offset < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    string readString(size_t length) {
+        if (!ok || size - offset < length) {
+            ok = false;
+            return string();
+        }
+        string value(data + offset, length);
+        offset += length;
+        return value;
+    }
+
+    void skip(size_t length) {
+        if (!ok || size - offset < length) ok = false;
+        else offset += length;
+    }
+
+    void align() {
+        skip((8 - offset % 8) % 8);
+    }
+
+    bool isOk() const { return ok; }
+
+private:
+    const char* data;
+    size_t size;
+    size_t offset;
+    bool ok;
+};
+
+// Тип столбца файла по типу значения поля
+template <typename T> struct ColumnTypeOf;
+template <> struct ColumnTypeOf<int> {
+    static constexpr ColumnType TYPE = INT32;
+    static constexpr uint8_t SCALE = 0;
+};
+template <> struct ColumnTypeOf<Area> {
+    static constexpr ColumnType TYPE = FIXED64;
+    static constexpr uint8_t SCALE = 2;
+};
+template <> struct ColumnTypeOf<string> {
+    static constexpr ColumnType TYPE = DICT_STRING;
+    static constexpr uint8_t SCALE = 0;
+};
+
+}
+
+// ЗАПИСЬ
+ColumnarWriter::ColumnarWriter(const vector<string>& fields, uint32_t rowGroupSize)
+    : rowGroupSize(rowGroupSize > 0 ? rowGroupSize : DEFAULT_ROW_GROUP_SIZE),
+      pendingRows(0), totalRows(0), valid(!fields.empty()) {
+    time_t now = time(nullptr);
+    currentYear = localtime(&now)->tm_year + 1900;
+
+    for (const auto& field : fields) {
+        Column column;
+        column.name = field;
+        column.type = INT32;
+        column.scale = 0;
+        column.append = nullptr;
+
+        bool known = HouseFields::Exported::find(field, [&column](auto descriptor) {
+            typedef decltype(descriptor) Field;
+            typedef ColumnTypeOf<typename Field::Type> Traits;
+            column.type = Traits::TYPE;
+            column.scale = Traits::SCALE;
+            column.append = appendField<Field>;
+        });
+        if (!known) valid = false;
+        columns.push_back(move(column));
+    }
+}
+
+bool ColumnarWriter::isValid() const {
+    return valid;
+}
+
+bool ColumnarWriter::open(const string& target) {
+    if (!valid || !writer.open(ExportCheckpoint::partPath(target))) return false;
+
+    filename = target;
+    rowGroups.clear();
+    pendingRows = 0;
+    totalRows = 0;
+
+    bool ok = writer.write(FILE_MAGIC, sizeof(FILE_MAGIC)) &&
+              writeValue<uint32_t>(VERSION) &&
+              writeValue<uint32_t>(static_cast<uint32_t>(columns.size()));
+    for (const auto& column : columns) {
+        ok = ok && writeValue<uint8_t>(column.type) &&
+                   writeValue<uint8_t>(column.scale) &&
+                   writeValue<uint16_t>(static_cast<uint16_t>(column.name.size())) &&
+                   writer.write(column.name);
+    }
+    return ok && pad();
+}
+
+bool ColumnarWriter::addRow(const HouseTable& houses, size_t row) {
+    if (!writer.isOpen()) return false;
+
+    for (auto& column : columns) {
+        column.append(column, houses, row, currentYear);
+    }
+
+    totalRows++;
+    if (++pendingRows >= rowGroupSize) {
+        return flushRowGroup();
+    }
+    return true;
+}
+
+template <typename Field>
+void ColumnarWriter::appendField(Column& column, const HouseTable& houses, size_t row, int currentYear) {
+    appendValue(column, Field::value(houses, row, currentYear));
+}
+
+void ColumnarWriter::appendValue(Column& column, int value) {
+    column.int32Values.push_back(value);
+}
+
+void ColumnarWriter::appendValue(Column& column, Area value) {
+    column.int64Values.push_back(value.hundredths);
+}
+
+void ColumnarWriter::appendValue(Column& column, string_view value) {
+    column.stringValues.emplace_back(value);
+}
+
+bool ColumnarWriter::close() {
+    if (!writer.isOpen()) return false;
+
+    bool ok = pendingRows == 0 || flushRowGroup();
+
+    // Оглавление
+    uint64_t footerOffset = writer.bytesWritten();
+    ok = ok && writeValue<uint64_t>(totalRows) &&
+               writeValue<uint64_t>(rowGroups.size());
+    for (const auto& group : rowGroups) {
+        ok = ok && writeValue<uint32_t>(group.rowCount) && writeValue<uint32_t>(0);
+        for (const auto& meta : group.chunks) {
+            const char zeros[7] = {};
+            ok = ok && writeValue<uint64_t>(meta.offset) &&
+                       writeValue<uint64_t>(meta.size) &&
+                       writeValue<uint8_t>(meta.stats.hasStats ? 1 : 0) &&
+                       writer.write(zeros, sizeof(zeros)) &&
+                       writeValue<int64_t>(meta.stats.min) &&
+                       writeValue<int64_t>(meta.stats.max);
+        }
+    }
+
+    ok = ok && writeValue<uint64_t>(footerOffset) &&
+               writer.write(TAIL_MAGIC, sizeof(TAIL_MAGIC));
+    ok = writer.close() && ok;
+    if (!ok) {
+        remove(ExportCheckpoint::partPath(filename).c_str());
+        return false;
+    }
+    return ExportCheckpoint::commit(filename);
+}
+
+void ColumnarWriter::discard() {
+    if (!writer.isOpen()) return;
+    writer.close();
+    remove(ExportCheckpoint::partPath(filename).c_str());
+}
+
+uint64_t ColumnarWriter::rowCount() const {
+    return totalRows;
+}
+
+bool ColumnarWriter::flushRowGroup() {
+    RowGroupMeta group;
+    group.rowCount = pendingRows;
+    group.chunks.resize(columns.size());
+
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (!writeChunk(columns[i], group.chunks[i])) return false;
+    }
+
+    rowGroups.push_back(move(group));
+    pendingRows = 0;
+    return true;
+}
+
+bool ColumnarWriter::writeChunk(Column& column, ChunkMeta& meta) {
+    meta.offset = writer.bytesWritten();
+    bool ok = true;
+
+    switch (column.type) {
+        case INT32: {
+            const auto& values = column.int32Values;
+            auto [minIt, maxIt] = minmax_element(values.begin(), values.end());
+            meta.stats = {true, *minIt, *maxIt};
+            ok = writer.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(int32_t));
+            column.int32Values.clear();
+            break;
+        }
+        case FIXED64: {
+            const auto& values = column.int64Values;
+            auto [minIt, maxIt] = minmax_element(values.begin(), values.end());
+            meta.stats = {true, *minIt, *maxIt};
+            ok = writer.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(int64_t));
+            column.int64Values.clear();
+            break;
+        }
+        case DICT_STRING: {
+            // Словарь группы строк: одинаковые адреса хранятся один раз
+            unordered_map<string_view, uint32_t> codesByValue;
+            vector<string_view> dictionary;
+            vector<uint32_t> codes;
+            codes.reserve(column.stringValues.size());
+
+            for (const auto& value : column.stringValues) {
+                auto it = codesByValue.find(value);
+                if (it == codesByValue.end()) {
+                    it = codesByValue.emplace(value, static_cast<uint32_t>(dictionary.size())).first;
+                    dictionary.push_back(value);
+                }
+                codes.push_back(it->second);
+            }
+
+            vector<uint32_t> offsets;
+            offsets.reserve(dictionary.size() + 1);
+            uint32_t bytes = 0;
+            for (const auto& value : dictionary) {
+                offsets.push_back(bytes);
+                bytes += static_cast<uint32_t>(value.size());
+            }
+            offsets.push_back(bytes);
+
+            ok = writeValue<uint32_t>(static_cast<uint32_t>(dictionary.size())) &&
+                 writeValue<uint32_t>(bytes) &&
+                 writer.write(reinterpret_cast<const char*>(codes.data()), codes.size() * sizeof(uint32_t)) &&
+                 writer.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+            for (const auto& value : dictionary) {
+                ok = ok && writer.write(value);
+            }
+
+            meta.stats = ColumnStats();
+            column.stringValues.clear();
+            break;
+        }
+    }
+
+    meta.size = writer.bytesWritten() - meta.offset;
+    return ok && pad();
+}
+
+bool ColumnarWriter::pad() {
+    static const char zeros[8] = {};
+    size_t padding = (8 - writer.bytesWritten() % 8) % 8;
+    return padding == 0 || writer.write(zeros, padding);
+}
+
+template <typename T>
+bool ColumnarWriter::writeValue(const T& value) {
+    return writer.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// ЧТЕНИЕ
+ColumnarReader::ColumnarReader()
+    : totalRows(0) {}
+
+bool ColumnarReader::open(const string& filename) {
+    close();
+    if (!file.open(filename)) return false;
+
+    const char* data = file.data();
+    size_t size = file.size();
+    if (size < sizeof(FILE_MAGIC) + TAIL_SIZE ||
+        memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+        memcmp(data + size - sizeof(TAIL_MAGIC), TAIL_MAGIC, sizeof(TAIL_MAGIC)) != 0) {
+        close();
+        return false;
+    }
+
+    Cursor header(data, size, sizeof(FILE_MAGIC));
+    uint32_t version = header.read<uint32_t>();
+    uint32_t columnCount = header.read<uint32_t>();
+    if (version != VERSION) {
+        close();
+        return false;
+    }
+    for (uint32_t i = 0; i < columnCount && header.isOk(); ++i) {
+        ColumnInfo info;
+        info.type = static_cast<ColumnType>(header.read<uint8_t>());
+        info.scale = header.read<uint8_t>();
+        info.name = header.readString(header.read<uint16_t>());
+        columns.push_back(move(info));
+    }
+
+    uint64_t footerOffset;
+    memcpy(&footerOffset, data + size - TAIL_SIZE, sizeof(footerOffset));
+    Cursor footer(data, size - TAIL_SIZE, footerOffset);
+    totalRows = footer.read<uint64_t>();
+    uint64_t groupCount = footer.read<uint64_t>();
+    if (!footer.isOk() || groupCount > size / CHUNK_META_SIZE) {
+        close();
+        return false;
+    }
+
+    for (uint64_t g = 0; g < groupCount && footer.isOk(); ++g) {
+        RowGroupInfo group;
+        group.rowCount = footer.read<uint32_t>();
+        footer.skip(4);
+        for (size_t c = 0; c < columns.size(); ++c) {
+            ChunkInfo info;
+            info.offset = footer.read<uint64_t>();
+            info.size = footer.read<uint64_t>();
+            info.stats.hasStats = footer.read<uint8_t>() != 0;
+            footer.skip(7);
+            info.stats.min = footer.read<int64_t>();
+            info.stats.max = footer.read<int64_t>();
+            if (info.offset > footerOffset || info.size > footerOffset - info.offset) {
+                close();
+                return false;
+            }
+            group.chunks.push_back(info);
+        }
+        rowGroups.push_back(move(group));
+    }
+
+    if (!header.isOk() || !footer.isOk()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ColumnarReader::close() {
+    file.close();
+    columns.clear();
+    rowGroups.clear();
+    totalRows = 0;
+}
+
+bool ColumnarReader::isOpen() const {
+    return file.isOpen();
+}
+
+size_t ColumnarReader::columnCount() const {
+    return columns.size();
+}
+
+const string& ColumnarReader::columnName(size_t column) const {
+    return columns[column].name;
+}
+
+ColumnType ColumnarReader::columnType(size_t column) const {
+    return columns[column].type;
+}
+
+uint8_t ColumnarReader::columnScale(size_t column) const {
+    return columns[column].scale;
+}
+
+int ColumnarReader::findColumn(const string& name) const {
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (columns[i].name == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+uint64_t ColumnarReader::rowCount() const {
+    return totalRows;
+}
+
+size_t ColumnarReader::rowGroupCount() const {
+    return rowGroups.size();
+}
+
+uint32_t ColumnarReader::rowGroupRows(size_t group) const {
+    return rowGroups[group].rowCount;
+}
+
+ColumnStats ColumnarReader::columnStats(size_t group, size_t column) const {
+    return rowGroups[group].chunks[column].stats;
+}
+
+bool ColumnarReader::rowGroupMayMatch(size_t group, size_t column, int64_t minValue, int64_t maxValue) const {
+    const ColumnStats& stats = rowGroups[group].chunks[column].stats;
+    if (!stats.hasStats) return true;
+    return stats.max >= minValue && stats.min <= maxValue;
+}
+
+const int32_t* ColumnarReader::int32Column(size_t group, size_t column) const {
+    const ChunkInfo* info = chunk(group, column, INT32);
+    if (!info || info->size < uint64_t(rowGroups[group].rowCount) * sizeof(int32_t)) return nullptr;
+    return reinterpret_cast<const int32_t*>(file.data() + info->offset);
+}
+
+const int64_t* ColumnarReader::int64Column(size_t group, size_t column) const {
+    const ChunkInfo* info = chunk(group, column, FIXED64);
+    if (!info || info->size < uint64_t(rowGroups[group].rowCount) * sizeof(int64_t)) return nullptr;
+    return reinterpret_cast<const int64_t*>(file.data() + info->offset);
+}
+
+string_view ColumnarReader::stringValue(size_t group, size_t column, uint32_t row) const {
+    const ChunkInfo* info = chunk(group, column, DICT_STRING);
+    uint32_t rows = rowGroups[group].rowCount;
+    if (!info || row >= rows) return string_view();
+
+    const char* base = file.data() + info->offset;
+    uint32_t dictSize, bytes;
+    memcpy(&dictSize, base, sizeof(dictSize));
+    memcpy(&bytes, base + 4, sizeof(bytes));
+
+    uint64_t needed = 8 + (uint64_t(rows) + dictSize + 1) * sizeof(uint32_t) + bytes;
+    if (needed > info->size) return string_view();
+
+    const uint32_t* codes = reinterpret_cast<const uint32_t*>(base + 8);
+    const uint32_t* offsets = codes + rows;
+    const char* strings = reinterpret_cast<const char*>(offsets + dictSize + 1);
+
+    uint32_t code = codes[row];
+    if (code >= dictSize || offsets[code + 1] > bytes || offsets[code] > offsets[code + 1]) {
+        return string_view();
+    }
+    return string_view(strings + offsets[code], offsets[code + 1] - offsets[code]);
+}
+
+const ColumnarReader::ChunkInfo* ColumnarReader::chunk(size_t group, size_t column, ColumnType type) const {
+    if (group >= rowGroups.size() || column >= columns.size() || columns[column].type != type) {
+        return nullptr;
+    }
+    return &rowGroups[group].chunks[column];
+}
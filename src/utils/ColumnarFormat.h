@@ -0,0 +1,155 @@
+#ifndef COLUMNARFORMAT_H
+#define COLUMNARFORMAT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "../models/House.h"
+#include "HouseTable.h"
+#include "BufferedFileWriter.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+// Колоночный бинарный формат экспорта (.hfc)
+//
+// [заголовок: magic, версия, описания столбцов]
+// [группа строк 0: блоки столбцов, каждый выровнен на 8 байт] ...
+// [оглавление: для каждой группы смещения блоков и min/max]
+// [хвост: смещение оглавления, magic]
+//
+// Все числа little-endian. Блоки int32/int64 читаются прямо из отображения файла.
+namespace ColumnarFormat {
+    constexpr char FILE_MAGIC[8] = {'H', 'F', 'C', 'O', 'L', 'S', '0', '1'};
+    constexpr char TAIL_MAGIC[8] = {'H', 'F', 'C', 'E', 'N', 'D', '0', '1'};
+    constexpr uint32_t VERSION = 1;
+    constexpr uint32_t DEFAULT_ROW_GROUP_SIZE = 65536;
+
+    enum ColumnType : uint8_t {
+        INT32 = 1,          // int32 на строку
+        FIXED64 = 2,        // int64 на строку, значение * 10^scale
+        DICT_STRING = 3     // словарь группы + uint32 код на строку
+    };
+
+    struct ColumnStats {
+        bool hasStats = false;
+        int64_t min = 0;
+        int64_t max = 0;
+    };
+}
+
+// Потоковая запись: в памяти только текущая группа строк
+class ColumnarWriter {
+public:
+    explicit ColumnarWriter(const vector<string>& fields,
+                            uint32_t rowGroupSize = ColumnarFormat::DEFAULT_ROW_GROUP_SIZE);
+
+    bool isValid() const;
+    // Данные пишутся в <файл>.part; close при успехе переименовывает его в filename
+    bool open(const string& filename);
+    bool addRow(const HouseTable& houses, size_t row);
+    bool close();
+    // Закрывает и удаляет <файл>.part: файл назначения не меняется
+    void discard();
+
+    uint64_t rowCount() const;
+
+private:
+    struct Column;
+    // Запись значения поля в столбец группы; выбирается по имени один раз в конструкторе
+    typedef void (*Appender)(Column& column, const HouseTable& houses, size_t row, int currentYear);
+
+    struct Column {
+        string name;
+        ColumnarFormat::ColumnType type;
+        uint8_t scale;
+        Appender append;
+        vector<int32_t> int32Values;
+        vector<int64_t> int64Values;
+        vector<string> stringValues;
+    };
+    struct ChunkMeta {
+        uint64_t offset;
+        uint64_t size;
+        ColumnarFormat::ColumnStats stats;
+    };
+    struct RowGroupMeta {
+        uint32_t rowCount;
+        vector<ChunkMeta> chunks;
+    };
+
+    vector<Column> columns;
+    vector<RowGroupMeta> rowGroups;
+    BufferedFileWriter writer;
+    string filename;
+    uint32_t rowGroupSize;
+    uint32_t pendingRows;
+    uint64_t totalRows;
+    int currentYear;
+    bool valid;
+
+    template <typename Field>
+    static void appendField(Column& column, const HouseTable& houses, size_t row, int currentYear);
+    static void appendValue(Column& column, int value);
+    static void appendValue(Column& column, Area value);
+    static void appendValue(Column& column, string_view value);
+    bool flushRowGroup();
+    bool writeChunk(Column& column, ChunkMeta& meta);
+    bool pad();
+    template <typename T> bool writeValue(const T& value);
+};
+
+// Чтение .hfc через mmap; группы строк можно пропускать по статистике
+class ColumnarReader {
+public:
+    ColumnarReader();
+
+    bool open(const string& filename);
+    void close();
+    bool isOpen() const;
+
+    size_t columnCount() const;
+    const string& columnName(size_t column) const;
+    ColumnarFormat::ColumnType columnType(size_t column) const;
+    uint8_t columnScale(size_t column) const;
+    int findColumn(const string& name) const;
+
+    uint64_t rowCount() const;
+    size_t rowGroupCount() const;
+    uint32_t rowGroupRows(size_t group) const;
+    ColumnarFormat::ColumnStats columnStats(size_t group, size_t column) const;
+
+    // false, если по min/max группа заведомо не содержит значений из [minValue, maxValue]
+    bool rowGroupMayMatch(size_t group, size_t column, int64_t minValue, int64_t maxValue) const;
+
+    // Указатели на значения группы внутри отображения файла (без копирования)
+    const int32_t* int32Column(size_t group, size_t column) const;
+    const int64_t* int64Column(size_t group, size_t column) const;
+    string_view stringValue(size_t group, size_t column, uint32_t row) const;
+
+private:
+    struct ColumnInfo {
+        string name;
+        ColumnarFormat::ColumnType type;
+        uint8_t scale;
+    };
+    struct ChunkInfo {
+        uint64_t offset;
+        uint64_t size;
+        ColumnarFormat::ColumnStats stats;
+    };
+    struct RowGroupInfo {
+        uint32_t rowCount;
+        vector<ChunkInfo> chunks;
+    };
+
+    MappedFile file;
+    vector<ColumnInfo> columns;
+    vector<RowGroupInfo> rowGroups;
+    uint64_t totalRows;
+
+    const ChunkInfo* chunk(size_t group, size_t column, ColumnarFormat::ColumnType type) const;
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "DelimitedParser.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+string_view trimmed(string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+}
+
+DelimitedParser::DelimitedParser(char delimiter)
+    : delimiter(delimiter) {}
+
+ImportLayout DelimitedParser::layoutFromHeader(string_view headerLine) const {
+    ImportLayout layout;
+    vector<DelimitedField> names;
+    if (!splitLine(headerLine, names)) return layout;
+
+    for (size_t i = 0; i < names.size(); ++i) {
+        string_view name = trimmed(names[i].text);
+        int column = static_cast<int>(i);
+
+        if (name == "address") layout.address = column;
+        else if (name == "apartments") layout.apartments = column;
+        else if (name == "total_area") layout.totalArea = column;
+        else if (name == "build_year") layout.buildYear = column;
+        else if (name == "floors") layout.floors = column;
+        // id и age вычисляются базой, при импорте игнорируются
+    }
+    return layout;
+}
+
+ImportLayout DelimitedParser::defaultLayout() {
+    // id, address, apartments, total_area, build_year, floors, age
+    ImportLayout layout;
+    layout.address = 1;
+    layout.apartments = 2;
+    layout.totalArea = 3;
+    layout.buildYear = 4;
+    layout.floors = 5;
+    return layout;
+}
+
+bool DelimitedParser::splitLine(string_view line, vector<DelimitedField>& fields) const {
+    fields.clear();
+
+    const char* p = line.data();
+    const char* end = p + line.size();
+    if (p < end && end[-1] == '\r') --end;
+    if (p == end) return false;
+
+    while (true) {
+        if (p < end && *p == '"') {
+            // Поле в кавычках: разделители внутри него не считаются
+            const char* start = ++p;
+            bool escaped = false;
+            while (true) {
+                const char* quote = static_cast<const char*>(memchr(p, '"', end - p));
+                if (!quote) return false;
+                if (quote + 1 < end && quote[1] == '"') {
+                    escaped = true;
+                    p = quote + 2;
+                    continue;
+                }
+                fields.push_back({string_view(start, quote - start), escaped});
+                p = quote + 1;
+                break;
+            }
+            if (p == end) return true;
+            if (*p != delimiter) return false;
+            ++p;
+            continue;
+        }
+
+        // Кавычка в середине поля без кавычек - обычный символ
+        const char* stop = findSpecial(p, end, delimiter);
+        while (stop < end && *stop == '"') {
+            stop = findSpecial(stop + 1, end, delimiter);
+        }
+        fields.push_back({string_view(p, stop - p), false});
+        if (stop == end) return true;
+        p = stop + 1;
+    }
+}
+
+bool DelimitedParser::parseHouse(const vector<DelimitedField>& fields, const ImportLayout& layout,
+                                 House& house, string& error) const {
+    auto field = [&fields](int column) -> const DelimitedField* {
+        return column >= 0 && column < static_cast<int>(fields.size()) ? &fields[column] : nullptr;
+    };
+
+    const DelimitedField* address = field(layout.address);
+    const DelimitedField* apartments = field(layout.apartments);
+    const DelimitedField* totalArea = field(layout.totalArea);
+    const DelimitedField* buildYear = field(layout.buildYear);
+    const DelimitedField* floors = field(layout.floors);
+
+    if (!address || !apartments || !totalArea || !buildYear || !floors) {
+        error = "недостаточно полей в строке";
+        return false;
+    }
+
+    house = House();
+    if (address->hasEscapedQuotes) {
+        house.address = fieldToString(*address);
+    } else {
+        string_view text = trimmed(address->text);
+        house.address.assign(text.data(), text.size());
+    }
+
+    if (!parseInt(apartments->text, house.apartments)) {
+        error = "некорректное количество квартир";
+        return false;
+    }
+    if (!Area::parse(totalArea->text, house.totalArea)) {
+        error = "некорректная площадь";
+        return false;
+    }
+    if (!parseInt(buildYear->text, house.buildYear)) {
+        error = "некорректный год постройки";
+        return false;
+    }
+    if (!parseInt(floors->text, house.floors)) {
+        error = "некорректная этажность";
+        return false;
+    }
+    if (!house.isValid()) {
+        error = "данные дома не прошли проверку";
+        return false;
+    }
+    return true;
+}
+
+const char* DelimitedParser::findSpecial(const char* begin, const char* end, char delimiter) {
+    const char* p = begin;
+
+#if defined(__SSE2__)
+    // По 16 байт за шаг: сравниваем сразу с разделителем, '\n' и '"'
+    const __m128i delimiterMask = _mm_set1_epi8(delimiter);
+    const __m128i newlineMask = _mm_set1_epi8('\n');
+    const __m128i quoteMask = _mm_set1_epi8('"');
+
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, delimiterMask), _mm_cmpeq_epi8(chunk, newlineMask)),
+            _mm_cmpeq_epi8(chunk, quoteMask));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+        p += 16;
+    }
+#endif
+
+    for (; p < end; ++p) {
+        if (*p == delimiter || *p == '\n' || *p == '"') return p;
+    }
+    return end;
+}
+
+const char* DelimitedParser::findRecordEnd(const char* begin, const char* from, const char* end) const {
+    // memchr в glibc уже векторизован. Кавычки ищутся только до ближайшего
+    // перевода строки: запись без кавычек проходится за два вызова memchr
+    const char* p = begin;
+    while (true) {
+        const char* scan = max(p, from);
+        const char* newline = scan < end ? static_cast<const char*>(memchr(scan, '\n', end - scan)) : nullptr;
+        const char* limit = newline ? newline : end;
+        const char* quote = p < limit ? static_cast<const char*>(memchr(p, '"', limit - p)) : nullptr;
+        if (!quote) return limit;
+
+        // Как в splitLine: кавычка открывает поле только в его начале
+        p = quote + 1;
+        bool fieldStart = quote == begin || quote[-1] == delimiter || quote[-1] == '\n';
+        if (!fieldStart) continue;
+
+        // Переводы строк до закрывающей кавычки принадлежат полю
+        while (true) {
+            const char* closing = static_cast<const char*>(memchr(p, '"', end - p));
+            if (!closing) return end;
+            p = closing + 1;
+            if (p < end && *p == '"') {
+                ++p;
+                continue;
+            }
+            break;
+        }
+    }
+}
+
+bool DelimitedParser::parseInt(string_view text, int& value) {
+    text = trimmed(text);
+    if (text.empty()) return false;
+    if (text.front() == '+') text.remove_prefix(1);
+
+    auto [ptr, ec] = from_chars(text.data(), text.data() + text.size(), value);
+    return ec == errc() && ptr == text.data() + text.size();
+}
+
+string DelimitedParser::fieldToString(const DelimitedField& field) {
+    if (!field.hasEscapedQuotes) {
+        return string(field.text);
+    }
+
+    string result;
+    result.reserve(field.text.size());
+    for (size_t i = 0; i < field.text.size(); ++i) {
+        result += field.text[i];
+        if (field.text[i] == '"' && i + 1 < field.text.size() && field.text[i + 1] == '"') {
+            ++i;
+        }
+    }
+    return result;
+}
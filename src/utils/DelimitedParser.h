@@ -0,0 +1,61 @@
+#ifndef DELIMITEDPARSER_H
+#define DELIMITEDPARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../models/House.h"
+
+using namespace std;
+
+// Номера столбцов файла, из которых берутся поля дома
+struct ImportLayout {
+    int address = -1;
+    int apartments = -1;
+    int totalArea = -1;
+    int buildYear = -1;
+    int floors = -1;
+
+    bool isComplete() const {
+        return address >= 0 && apartments >= 0 && totalArea >= 0 &&
+               buildYear >= 0 && floors >= 0;
+    }
+};
+
+// Поле строки; кавычки CSV снимаются, удвоенные кавычки внутри остаются
+struct DelimitedField {
+    string_view text;
+    bool hasEscapedQuotes = false;
+};
+
+// Разбор текстовых файлов с разделителями (формат экспорта TXT)
+class DelimitedParser {
+public:
+    explicit DelimitedParser(char delimiter);
+
+    // Раскладка по строке заголовка (имена полей как в экспорте)
+    ImportLayout layoutFromHeader(string_view headerLine) const;
+    // Раскладка файла без заголовка: все поля экспорта в исходном порядке
+    static ImportLayout defaultLayout();
+
+    // Разбивает одну запись (без завершающего перевода строки) на поля;
+    // поле в кавычках может содержать переводы строк
+    bool splitLine(string_view line, vector<DelimitedField>& fields) const;
+    // Заполняет дом из полей строки; при ошибке возвращает причину
+    bool parseHouse(const vector<DelimitedField>& fields, const ImportLayout& layout,
+                    House& house, string& error) const;
+
+    // Первый разделитель, перевод строки или кавычка в [begin, end)
+    static const char* findSpecial(const char* begin, const char* end, char delimiter);
+    // Конец записи: первый '\n' не раньше from вне полей в кавычках, или end.
+    // begin - начало записи, от него отслеживается, открыта ли кавычка
+    const char* findRecordEnd(const char* begin, const char* from, const char* end) const;
+
+    static bool parseInt(string_view text, int& value);
+    static string fieldToString(const DelimitedField& field);
+
+private:
+    char delimiter;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "ExportCheckpoint.h"
+#include <fstream>
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const char CHECKPOINT_MAGIC[] = "HFCKPT01";
+
+bool writeAll(int fd, const string& data) {
+    const char* p = data.data();
+    size_t left = data.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+}
+
+string ExportCheckpoint::partPath(const string& filename) {
+    return filename + ".part";
+}
+
+string ExportCheckpoint::checkpointPath(const string& filename) {
+    return filename + ".ckpt";
+}
+
+bool ExportCheckpoint::load(const string& filename, ExportCheckpoint& checkpoint) {
+    ifstream in(checkpointPath(filename));
+    if (!in) return false;
+
+    string magic;
+    ExportCheckpoint loaded;
+    if (!getline(in, magic) || magic != CHECKPOINT_MAGIC) return false;
+    if (!getline(in, loaded.signature)) return false;
+    if (!(in >> loaded.lastId >> loaded.byteOffset >> loaded.rowCount)) return false;
+
+    checkpoint = loaded;
+    return true;
+}
+
+bool ExportCheckpoint::save(const string& filename) const {
+    string path = checkpointPath(filename);
+    string tmpPath = path + ".tmp";
+    string content = string(CHECKPOINT_MAGIC) + "\n" + signature + "\n" +
+                     to_string(lastId) + " " + to_string(byteOffset) + " " + to_string(rowCount) + "\n";
+
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, content) && fsync(fd) == 0;
+    if (::close(fd) != 0) ok = false;
+
+    // Старая точка заменяется целиком: после сбоя читается либо она, либо новая
+    return ok && rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+void ExportCheckpoint::remove(const string& filename) {
+    string path = checkpointPath(filename);
+    ::unlink(path.c_str());
+    ::unlink((path + ".tmp").c_str());
+}
+
+bool ExportCheckpoint::commit(const string& filename) {
+    if (rename(partPath(filename).c_str(), filename.c_str()) != 0) return false;
+    remove(filename);
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef EXPORTCHECKPOINT_H
+#define EXPORTCHECKPOINT_H
+
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+// Контрольная точка возобновляемого экспорта.
+// Данные пишутся в <файл>.part, точка хранится в <файл>.ckpt;
+// после завершения .part атомарно переименовывается в <файл>
+struct ExportCheckpoint {
+    string signature;       // параметры экспорта; при расхождении экспорт начинается заново
+    long long lastId = 0;   // последний выгруженный id
+    uint64_t byteOffset = 0;// длина .part, соответствующая lastId
+    uint64_t rowCount = 0;
+
+    static string partPath(const string& filename);
+    static string checkpointPath(const string& filename);
+
+    static bool load(const string& filename, ExportCheckpoint& checkpoint);
+    // Записывает точку во временный файл, fsync и rename поверх старой
+    bool save(const string& filename) const;
+    static void remove(const string& filename);
+
+    // Переименовывает .part в итоговый файл и удаляет точку
+    static bool commit(const string& filename);
+};
+
+#endif
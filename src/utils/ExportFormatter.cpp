@@ -0,0 +1,142 @@
+#include "ExportFormatter.h"
+#include "BufferedFileWriter.h"
+#include "ExportCheckpoint.h"
+#include "HouseFields.h"
+#include <charconv>
+#include <ctime>
+
+using namespace std;
+
+namespace {
+
+// Блок, после заполнения которого данные уходят в файл
+const size_t FLUSH_THRESHOLD = 1024 * 1024;
+
+void appendInt(int value, string& out) {
+    char digits[16];
+    auto result = to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr - digits);
+}
+
+// Запись значения выбирается по его типу при компиляции
+void appendValue(int value, const ExportFormatter::Context&, string& out) {
+    appendInt(value, out);
+}
+
+void appendValue(Area value, const ExportFormatter::Context&, string& out) {
+    value.appendTo(out);
+}
+
+void appendValue(string_view value, const ExportFormatter::Context& context, string& out) {
+    ExportFormatter::appendQuoted(value, context.delimiter, out);
+}
+
+template <typename Field>
+void writeField(const HouseTable& houses, size_t row, const ExportFormatter::Context& context, string& out) {
+    appendValue(Field::value(houses, row, context.currentYear), context, out);
+}
+
+}
+
+ExportFormatter::ExportFormatter(const vector<string>& fields, char delimiter)
+    : names(fields), valid(!fields.empty()) {
+    // Текущий год определяется один раз на весь экспорт, а не для каждой строки
+    time_t now = time(nullptr);
+    tm* nowTm = localtime(&now);
+    context.delimiter = delimiter;
+    context.currentYear = nowTm->tm_year + 1900;
+    
+    columns.reserve(fields.size());
+    for (const auto& field : fields) {
+        ColumnWriter writer = writerFor(field);
+        if (!writer) valid = false;
+        columns.push_back(writer);
+    }
+}
+
+bool ExportFormatter::isValid() const {
+    return valid;
+}
+
+void ExportFormatter::appendHeader(string& out) const {
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (i > 0) out += context.delimiter;
+        out += names[i];
+    }
+    out += '\n';
+}
+
+void ExportFormatter::appendRow(const HouseTable& houses, size_t row, string& out) const {
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (i > 0) out += context.delimiter;
+        columns[i](houses, row, context, out);
+    }
+    out += '\n';
+}
+
+bool ExportFormatter::writeFile(const HouseTable& houses, const string& filename, bool includeHeader,
+                                int compressionLevel) const {
+    if (!valid) return false;
+    
+    // Итоговый файл появляется только полностью записанным
+    string partFile = ExportCheckpoint::partPath(filename);
+    BufferedFileWriter writer;
+    bool ok = writer.open(partFile, compressionLevel) && write(houses, writer, includeHeader);
+    ok = writer.close() && ok;
+    if (!ok) {
+        remove(partFile.c_str());
+        return false;
+    }
+    return ExportCheckpoint::commit(filename);
+}
+
+bool ExportFormatter::write(const HouseTable& houses, BufferedFileWriter& writer, bool includeHeader) const {
+    if (!valid) return false;
+    
+    string buffer;
+    buffer.reserve(FLUSH_THRESHOLD + 4096);
+    
+    if (includeHeader) {
+        appendHeader(buffer);
+    }
+    
+    for (size_t row = 0; row < houses.size(); ++row) {
+        appendRow(houses, row, buffer);
+        if (buffer.size() >= FLUSH_THRESHOLD) {
+            if (!writer.write(buffer)) return false;
+            buffer.clear();
+        }
+    }
+    
+    return writer.write(buffer);
+}
+
+void ExportFormatter::appendQuoted(string_view value, char delimiter, string& out) {
+    bool needsQuotes = value.empty();
+    for (char c : value) {
+        if (c == delimiter || c == '"' || c == '\n' || c == '\r') {
+            needsQuotes = true;
+            break;
+        }
+    }
+    
+    if (!needsQuotes) {
+        out.append(value.data(), value.size());
+        return;
+    }
+    
+    out += '"';
+    for (char c : value) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+ExportFormatter::ColumnWriter ExportFormatter::writerFor(const string& field) {
+    ColumnWriter writer = nullptr;
+    HouseFields::Exported::find(field, [&writer](auto descriptor) {
+        writer = writeField<decltype(descriptor)>;
+    });
+    return writer;
+}
@@ -0,0 +1,48 @@
+#ifndef EXPORTFORMATTER_H
+#define EXPORTFORMATTER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../models/House.h"
+#include "HouseTable.h"
+
+using namespace std;
+
+class BufferedFileWriter;
+
+// Форматирование домов в TXT/CSV без сравнения имен полей на каждой ячейке:
+// список полей один раз превращается в массив типизированных функций записи
+class ExportFormatter {
+public:
+    struct Context {
+        char delimiter;
+        int currentYear;
+    };
+    typedef void (*ColumnWriter)(const HouseTable& houses, size_t row, const Context& context, string& out);
+    
+    ExportFormatter(const vector<string>& fields, char delimiter);
+    
+    // false, если в списке есть неизвестное поле
+    bool isValid() const;
+    
+    void appendHeader(string& out) const;
+    void appendRow(const HouseTable& houses, size_t row, string& out) const;
+    
+    bool writeFile(const HouseTable& houses, const string& filename, bool includeHeader,
+                   int compressionLevel = 0) const;
+    bool write(const HouseTable& houses, BufferedFileWriter& writer, bool includeHeader) const;
+    
+    // Значение в кавычках CSV, если оно содержит разделитель, кавычку или перевод строки
+    static void appendQuoted(string_view value, char delimiter, string& out);
+
+private:
+    vector<ColumnWriter> columns;
+    vector<string> names;
+    Context context;
+    bool valid;
+    
+    static ColumnWriter writerFor(const string& field);
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include "GzipCompressor.h"
+#include <zlib.h>
+#include <cerrno>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const size_t OUTPUT_BUFFER_SIZE = 256 * 1024;
+
+}
+
+GzipCompressor::GzipCompressor(int fd, int level, size_t queueCapacity)
+    : fd(fd), level(level), queueCapacity(queueCapacity > 0 ? queueCapacity : 1),
+      finishing(false), started(false), failed(false), outputBytes(0) {}
+
+GzipCompressor::~GzipCompressor() {
+    finish();
+}
+
+bool GzipCompressor::start() {
+    if (started) return true;
+    started = true;
+    worker = thread(&GzipCompressor::run, this);
+    return true;
+}
+
+bool GzipCompressor::submit(vector<char>&& block) {
+    unique_lock<mutex> lock(queueMutex);
+    queueChanged.wait(lock, [this]() {
+        return queue.size() < queueCapacity || failed;
+    });
+    if (failed) return false;
+
+    queue.push_back(move(block));
+    queueChanged.notify_all();
+    return true;
+}
+
+vector<char> GzipCompressor::takeFreeBuffer() {
+    lock_guard<mutex> lock(queueMutex);
+    if (freeBuffers.empty()) return vector<char>();
+
+    vector<char> buffer = move(freeBuffers.back());
+    freeBuffers.pop_back();
+    return buffer;
+}
+
+bool GzipCompressor::finish() {
+    if (!started) return !failed;
+
+    {
+        lock_guard<mutex> lock(queueMutex);
+        finishing = true;
+    }
+    queueChanged.notify_all();
+
+    if (worker.joinable()) {
+        worker.join();
+    }
+    return !failed;
+}
+
+bool GzipCompressor::hasFailed() const {
+    return failed;
+}
+
+uint64_t GzipCompressor::compressedBytes() const {
+    return outputBytes;
+}
+
+void GzipCompressor::run() {
+    z_stream stream{};
+    // windowBits 15 + 16: формат gzip вместо "сырого" zlib
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        fail();
+        return;
+    }
+
+    vector<unsigned char> output(OUTPUT_BUFFER_SIZE);
+    bool done = false;
+
+    while (!done) {
+        vector<char> block;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueChanged.wait(lock, [this]() { return !queue.empty() || finishing; });
+            if (!queue.empty()) {
+                block = move(queue.front());
+                queue.pop_front();
+                queueChanged.notify_all();
+            } else {
+                done = true;
+            }
+        }
+
+        stream.next_in = reinterpret_cast<Bytef*>(block.data());
+        stream.avail_in = static_cast<uInt>(block.size());
+        int flush = done ? Z_FINISH : Z_NO_FLUSH;
+
+        do {
+            stream.next_out = output.data();
+            stream.avail_out = static_cast<uInt>(output.size());
+            int status = deflate(&stream, flush);
+            if (status == Z_STREAM_ERROR) {
+                fail();
+                break;
+            }
+            size_t produced = output.size() - stream.avail_out;
+            if (produced > 0 && !writeAll(output.data(), produced)) {
+                fail();
+                break;
+            }
+        } while (stream.avail_out == 0);
+
+        if (failed) break;
+
+        if (!done) {
+            block.clear();
+            lock_guard<mutex> lock(queueMutex);
+            freeBuffers.push_back(move(block));
+        }
+    }
+
+    deflateEnd(&stream);
+}
+
+void GzipCompressor::fail() {
+    // Флаг ставится под мьютексом: иначе submit() может проверить условие,
+    // пропустить уведомление и ждать места в очереди вечно
+    lock_guard<mutex> lock(queueMutex);
+    failed = true;
+    queueChanged.notify_all();
+}
+
+bool GzipCompressor::writeAll(const unsigned char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        outputBytes += static_cast<uint64_t>(n);
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef GZIPCOMPRESSOR_H
+#define GZIPCOMPRESSOR_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+// Сжатие gzip в отдельном потоке: заполненные блоки передаются через
+// ограниченную очередь, поэтому форматирование и сжатие идут параллельно
+class GzipCompressor {
+public:
+    GzipCompressor(int fd, int level, size_t queueCapacity = 4);
+    ~GzipCompressor();
+
+    GzipCompressor(const GzipCompressor&) = delete;
+    GzipCompressor& operator=(const GzipCompressor&) = delete;
+
+    bool start();
+    // Передает блок на сжатие; ждет, если очередь заполнена
+    bool submit(vector<char>&& block);
+    // Освободившийся после сжатия буфер (или пустой, если таких нет)
+    vector<char> takeFreeBuffer();
+    // Дожимает поток, записывает хвост gzip и останавливает поток сжатия
+    bool finish();
+
+    bool hasFailed() const;
+    uint64_t compressedBytes() const;
+
+private:
+    int fd;
+    int level;
+    size_t queueCapacity;
+
+    thread worker;
+    mutex queueMutex;
+    condition_variable queueChanged;
+    deque<vector<char>> queue;
+    vector<vector<char>> freeBuffers;
+    bool finishing;
+    bool started;
+    atomic<bool> failed;
+    atomic<uint64_t> outputBytes;
+
+    void run();
+    void fail();
+    bool writeAll(const unsigned char* data, size_t size);
+};
+
+#endif
@@ -0,0 +1,253 @@
+#include "HouseColumnStore.h"
+#include <functional>
+#include <algorithm>
+
+using namespace std;
+
+HouseColumnStore::HouseColumnStore() {
+    clear();
+}
+
+void HouseColumnStore::clear() {
+    for (PackedColumn& column : columns) column.clear();
+    addressCodes.clear();
+    dictionaryData.clear();
+    dictionaryOffsets.clear();
+    dictionaryOffsets.mutate().push_back(0);
+    dictionarySlots.clear();
+    addedData.clear();
+    addedOffsets.assign(1, 0);
+    addedCodes.clear();
+}
+
+void HouseColumnStore::assign(const HouseTable& houses) {
+    clear();
+
+    // Ширину каждого столбца определяет его диапазон, поэтому упаковка - одним проходом
+    vector<int64_t> values(houses.size());
+    auto pack = [&](Column column, auto field) {
+        for (size_t i = 0; i < houses.size(); ++i) values[i] = field(i);
+        columns[column].assign(values);
+    };
+    pack(BUILD_YEAR, [&](size_t i) { return int64_t(houses.buildYear(i)); });
+    pack(APARTMENTS, [&](size_t i) { return int64_t(houses.apartments(i)); });
+    pack(TOTAL_AREA, [&](size_t i) { return houses.totalArea(i).hundredths; });
+    pack(FLOORS, [&](size_t i) { return int64_t(houses.floors(i)); });
+    pack(ID, [&](size_t i) { return int64_t(houses.id(i)); });
+    for (size_t i = 0; i < houses.size(); ++i) values[i] = internBuilding(houses.address(i));
+    addressCodes.assign(values);
+}
+
+void HouseColumnStore::append(const House& house) {
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        columns[c].push_back(fieldValue(house, static_cast<Column>(c)));
+    }
+    addressCodes.push_back(internAddress(house.address));
+}
+
+void HouseColumnStore::set(uint32_t row, const House& house) {
+    if (row >= size()) return;
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        columns[c].set(row, fieldValue(house, static_cast<Column>(c)));
+    }
+    // Прежний адрес остается в словаре до следующей загрузки
+    if (address(row) != house.address) {
+        addressCodes.set(row, internAddress(house.address));
+    }
+}
+
+size_t HouseColumnStore::size() const {
+    return addressCodes.size();
+}
+
+House HouseColumnStore::house(uint32_t row) const {
+    House house;
+    house.id = static_cast<int>(columns[ID].get(row));
+    house.address = string(address(row));
+    house.apartments = static_cast<int>(columns[APARTMENTS].get(row));
+    house.totalArea = Area(columns[TOTAL_AREA].get(row));
+    house.buildYear = static_cast<int>(columns[BUILD_YEAR].get(row));
+    house.floors = static_cast<int>(columns[FLOORS].get(row));
+    return house;
+}
+
+void HouseColumnStore::extract(const vector<uint32_t>& rows, HouseTable& houses) const {
+    size_t bytes = 0;
+    for (uint32_t row : rows) bytes += address(row).size();
+    houses.reserve(houses.size() + rows.size(), houses.addressBytes() + bytes);
+
+    for (uint32_t row : rows) {
+        houses.append(static_cast<int>(columns[ID].get(row)), address(row),
+                      static_cast<int>(columns[APARTMENTS].get(row)), Area(columns[TOTAL_AREA].get(row)),
+                      static_cast<int>(columns[BUILD_YEAR].get(row)), static_cast<int>(columns[FLOORS].get(row)));
+    }
+}
+
+int64_t HouseColumnStore::value(uint32_t row, Column column) const {
+    return columns[column].get(row);
+}
+
+string_view HouseColumnStore::address(uint32_t row) const {
+    return dictionaryEntry(addressCode(row));
+}
+
+uint32_t HouseColumnStore::addressCode(uint32_t row) const {
+    return static_cast<uint32_t>(addressCodes.get(row));
+}
+
+size_t HouseColumnStore::dictionarySize() const {
+    return builtSize() + addedOffsets.size() - 1;
+}
+
+string_view HouseColumnStore::dictionaryEntry(uint32_t code) const {
+    size_t built = builtSize();
+    if (code >= built) {
+        code -= static_cast<uint32_t>(built);
+        return string_view(addedData.data() + addedOffsets[code], addedOffsets[code + 1] - addedOffsets[code]);
+    }
+    return string_view(dictionaryData.data() + dictionaryOffsets[code],
+                       dictionaryOffsets[code + 1] - dictionaryOffsets[code]);
+}
+
+void HouseColumnStore::scan(const vector<Range>& ranges, vector<uint64_t>& rowBits) const {
+    rowBits.assign((size() + 63) / 64, ~uint64_t(0));
+    if (size() % 64 != 0) rowBits.back() = (uint64_t(1) << (size() % 64)) - 1;
+
+    for (const Range& range : ranges) {
+        columns[range.column].andRange(range.min, range.max, rowBits);
+    }
+}
+
+void HouseColumnStore::select(const vector<Range>& ranges, vector<uint32_t>& selection) const {
+    vector<uint64_t> rowBits;
+    scan(ranges, rowBits);
+
+    selection.clear();
+    for (size_t w = 0; w < rowBits.size(); ++w) {
+        for (uint64_t word = rowBits[w]; word != 0; word &= word - 1) {
+            selection.push_back(static_cast<uint32_t>(w * 64 + __builtin_ctzll(word)));
+        }
+    }
+}
+
+bool HouseColumnStore::matches(uint32_t row, const Range& range) const {
+    int64_t v = columns[range.column].get(row);
+    return v >= range.min && v <= range.max;
+}
+
+size_t HouseColumnStore::memoryBytes() const {
+    size_t bytes = addressCodes.memoryBytes() + dictionaryData.memoryBytes() +
+                   dictionaryOffsets.memoryBytes() + dictionarySlots.memoryBytes() +
+                   addedData.capacity() + addedOffsets.capacity() * sizeof(uint32_t) +
+                   addedCodes.size() * (sizeof(string) + sizeof(uint32_t));
+    for (const PackedColumn& column : columns) bytes += column.memoryBytes();
+    return bytes;
+}
+
+void HouseColumnStore::write(ImageWriter& out) const {
+    for (const PackedColumn& column : columns) column.write(out);
+    addressCodes.write(out);
+    out.array(dictionaryData);
+    out.array(dictionaryOffsets);
+    out.array(dictionarySlots);
+}
+
+bool HouseColumnStore::read(ImageReader& in) {
+    clear();
+    for (PackedColumn& column : columns) {
+        if (!column.read(in)) return false;
+    }
+    if (!addressCodes.read(in) || !in.array(dictionaryData) || !in.array(dictionaryOffsets) ||
+        !in.array(dictionarySlots)) {
+        return false;
+    }
+
+    // Содержимое образа не проверяется построчно: сегмент принадлежит издателю.
+    // Проверяются размеры, от которых зависят границы чтения
+    for (const PackedColumn& column : columns) {
+        if (column.size() != addressCodes.size()) return false;
+    }
+    size_t slots = dictionarySlots.size();
+    return !dictionaryOffsets.empty() && dictionaryOffsets.back() == dictionaryData.size() &&
+           (slots & (slots - 1)) == 0 && (slots > builtSize() || (slots == 0 && builtSize() == 0));
+}
+
+uint32_t HouseColumnStore::internBuilding(string_view address) {
+    // Заполнение не больше половины: цепочки проб остаются короткими
+    if ((builtSize() + 1) * 2 > dictionarySlots.size()) {
+        rehashDictionary(max<size_t>(1024, dictionarySlots.size() * 2));
+    }
+
+    vector<uint32_t>& slots = dictionarySlots.mutate();
+    size_t mask = slots.size() - 1;
+    size_t slot = std::hash<string_view>()(address) & mask;
+    while (slots[slot] != 0) {
+        uint32_t code = slots[slot] - 1;
+        if (dictionaryEntry(code) == address) return code;
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t code = static_cast<uint32_t>(builtSize());
+    vector<char>& data = dictionaryData.mutate();
+    data.insert(data.end(), address.begin(), address.end());
+    dictionaryOffsets.mutate().push_back(static_cast<uint32_t>(data.size()));
+    slots[slot] = code + 1;
+    return code;
+}
+
+uint32_t HouseColumnStore::internAddress(string_view address) {
+    uint32_t code = 0;
+    if (findBuilt(address, code)) return code;
+
+    string key(address);
+    auto added = addedCodes.find(key);
+    if (added != addedCodes.end()) return added->second;
+
+    code = static_cast<uint32_t>(dictionarySize());
+    addedData.append(address.data(), address.size());
+    addedOffsets.push_back(static_cast<uint32_t>(addedData.size()));
+    addedCodes.emplace(move(key), code);
+    return code;
+}
+
+bool HouseColumnStore::findBuilt(string_view address, uint32_t& code) const {
+    if (dictionarySlots.empty()) return false;
+
+    const uint32_t* slots = dictionarySlots.data();
+    size_t mask = dictionarySlots.size() - 1;
+    size_t slot = std::hash<string_view>()(address) & mask;
+    while (slots[slot] != 0) {
+        if (dictionaryEntry(slots[slot] - 1) == address) {
+            code = slots[slot] - 1;
+            return true;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return false;
+}
+
+size_t HouseColumnStore::builtSize() const {
+    return dictionaryOffsets.size() - 1;
+}
+
+void HouseColumnStore::rehashDictionary(size_t slotCount) {
+    vector<uint32_t>& slots = dictionarySlots.mutate();
+    slots.assign(slotCount, 0);
+    size_t mask = slotCount - 1;
+    for (uint32_t code = 0; code < builtSize(); ++code) {
+        size_t slot = std::hash<string_view>()(dictionaryEntry(code)) & mask;
+        while (slots[slot] != 0) slot = (slot + 1) & mask;
+        slots[slot] = code + 1;
+    }
+}
+
+int64_t HouseColumnStore::fieldValue(const House& house, Column column) {
+    switch (column) {
+        case BUILD_YEAR: return house.buildYear;
+        case APARTMENTS: return house.apartments;
+        case TOTAL_AREA: return house.totalArea.hundredths;
+        case FLOORS: return house.floors;
+        case ID: return house.id;
+        default: return 0;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef HOUSECOLUMNSTORE_H
+#define HOUSECOLUMNSTORE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "../models/House.h"
+#include "PackedColumn.h"
+#include "HouseTable.h"
+#include "SharedArray.h"
+#include "SnapshotImage.h"
+
+using namespace std;
+
+// Снимок домов по столбцам: числа упакованы по минимальной ширине
+// (этажность - 7 бит, год - около 10), площадь хранится в сотых долях м²,
+// адреса - словарем: строка добавляется один раз, у дома - ее код.
+// Фильтры по диапазонам проверяются прямо на упакованных данных.
+// Словарь, собранный assign или прочитанный из образа, не меняется:
+// адреса, появившиеся после этого, хранятся отдельно
+class HouseColumnStore {
+public:
+    enum Column {
+        BUILD_YEAR = 0,
+        APARTMENTS,
+        TOTAL_AREA,
+        FLOORS,
+        ID,
+        COLUMN_COUNT
+    };
+
+    // Включительный диапазон в значениях столбца; площадь - в сотых долях м²
+    struct Range {
+        Column column;
+        int64_t min;
+        int64_t max;
+    };
+
+    HouseColumnStore();
+
+    void clear();
+    void assign(const HouseTable& houses);
+    void append(const House& house);
+    void set(uint32_t row, const House& house);
+
+    size_t size() const;
+    House house(uint32_t row) const;
+    // Дописывает строки rows в таблицу без промежуточных House
+    void extract(const vector<uint32_t>& rows, HouseTable& houses) const;
+    // Значение столбца; площадь - в сотых долях м²
+    int64_t value(uint32_t row, Column column) const;
+    string_view address(uint32_t row) const;
+
+    uint32_t addressCode(uint32_t row) const;
+    size_t dictionarySize() const;
+    string_view dictionaryEntry(uint32_t code) const;
+
+    // Маска строк (бит на строку), попавших во все диапазоны
+    void scan(const vector<Range>& ranges, vector<uint64_t>& rowBits) const;
+    // То же списком номеров строк по возрастанию
+    void select(const vector<Range>& ranges, vector<uint32_t>& selection) const;
+    bool matches(uint32_t row, const Range& range) const;
+
+    size_t memoryBytes() const;
+
+    // Столбцы и словарь читаются из образа на месте
+    void write(ImageWriter& out) const;
+    bool read(ImageReader& in);
+
+    // Значение поля дома в представлении столбца
+    static int64_t fieldValue(const House& house, Column column);
+
+private:
+    PackedColumn columns[COLUMN_COUNT];
+    PackedColumn addressCodes;
+    SharedArray<char> dictionaryData;
+    SharedArray<uint32_t> dictionaryOffsets;
+    // Открытая адресация по хешу адреса: код + 1, 0 - пустая ячейка
+    SharedArray<uint32_t> dictionarySlots;
+    // Адреса после сборки словаря, коды с dictionaryOffsets.size() - 1
+    string addedData;
+    vector<uint32_t> addedOffsets;
+    unordered_map<string, uint32_t> addedCodes;
+
+    // Адрес при сборке словаря в assign
+    uint32_t internBuilding(string_view address);
+    // Адрес правки: поиск в собранном словаре, иначе в добавленных
+    uint32_t internAddress(string_view address);
+    bool findBuilt(string_view address, uint32_t& code) const;
+    size_t builtSize() const;
+    void rehashDictionary(size_t slotCount);
+};
+
+#endif
@@ -0,0 +1,195 @@
+#ifndef HOUSEFIELDS_H
+#define HOUSEFIELDS_H
+
+#include <string>
+#include <string_view>
+#include <array>
+#include <cstddef>
+#include "../models/House.h"
+#include "HouseTable.h"
+#include "HouseColumnStore.h"
+
+using namespace std;
+
+// Описания полей дома. Поле - тип с constexpr-метаданными и доступом к
+// значению; экспорт, декодеры и модели перебирают списки полей шаблонами,
+// поэтому имя поля сравнивается только при настройке, а не в цикле по строкам.
+//
+// NAME - имя в экспорте и заголовке файла, TITLE - заголовок столбца таблицы,
+// LABEL - подпись в диалоге экспорта, SQL - выражение по таблице houses,
+// SORT_SQL/SQL_CAST - ключ keyset-выборки и тип его параметра,
+// PROCEDURE_COLUMN - столбец процедур get_all_houses() и др.,
+// MASK - хранимые поля, нужные для значения.
+// У хранимых полей MEMBER - указатель на поле House, value читает значение
+// и из таблицы, и из столбцов снимка
+namespace HouseFields {
+
+struct Id {
+    typedef int Type;
+    static constexpr const char* NAME = "id";
+    static constexpr const char* TITLE = "ID";
+    static constexpr const char* LABEL = "ID";
+    static constexpr const char* SQL = "id";
+    static constexpr const char* SORT_SQL = "id";
+    static constexpr const char* SQL_CAST = "::int";
+    static constexpr const char* PROCEDURE_COLUMN = "house_id";
+    static constexpr unsigned MASK = HOUSE_FIELD_ID;
+    static constexpr Type House::* MEMBER = &House::id;
+    static Type value(const HouseTable& houses, size_t row, int) { return houses.id(row); }
+    static Type value(const HouseColumnStore& store, size_t row, int) {
+        return static_cast<Type>(store.value(static_cast<uint32_t>(row), HouseColumnStore::ID));
+    }
+};
+
+struct Address {
+    typedef string Type;
+    static constexpr const char* NAME = "address";
+    static constexpr const char* TITLE = "Адрес";
+    static constexpr const char* LABEL = "Адрес";
+    static constexpr const char* SQL = "address";
+    // Русское сопоставление ICU с числами и без учета регистра, как QCollator
+    // в HouseSortKeys; правило housing_address создает setup_database.sql
+    static constexpr const char* SORT_SQL = "address COLLATE housing_address";
+    static constexpr const char* SQL_CAST = "::text";
+    static constexpr const char* PROCEDURE_COLUMN = "house_address";
+    static constexpr unsigned MASK = HOUSE_FIELD_ADDRESS;
+    static constexpr Type House::* MEMBER = &House::address;
+    static string_view value(const HouseTable& houses, size_t row, int) { return houses.address(row); }
+    static string_view value(const HouseColumnStore& store, size_t row, int) {
+        return store.address(static_cast<uint32_t>(row));
+    }
+};
+
+struct Apartments {
+    typedef int Type;
+    static constexpr const char* NAME = "apartments";
+    static constexpr const char* TITLE = "Квартир";
+    static constexpr const char* LABEL = "Количество квартир";
+    static constexpr const char* SQL = "apartments";
+    static constexpr const char* SORT_SQL = "apartments";
+    static constexpr const char* SQL_CAST = "::int";
+    static constexpr const char* PROCEDURE_COLUMN = "house_apartments";
+    static constexpr unsigned MASK = HOUSE_FIELD_APARTMENTS;
+    static constexpr Type House::* MEMBER = &House::apartments;
+    static Type value(const HouseTable& houses, size_t row, int) { return houses.apartments(row); }
+    static Type value(const HouseColumnStore& store, size_t row, int) {
+        return static_cast<Type>(store.value(static_cast<uint32_t>(row), HouseColumnStore::APARTMENTS));
+    }
+};
+
+struct TotalArea {
+    typedef Area Type;
+    static constexpr const char* NAME = "total_area";
+    static constexpr const char* TITLE = "Площадь";
+    static constexpr const char* LABEL = "Общая площадь";
+    static constexpr const char* SQL = "total_area";
+    static constexpr const char* SORT_SQL = "total_area";
+    static constexpr const char* SQL_CAST = "::numeric";
+    static constexpr const char* PROCEDURE_COLUMN = "house_total_area";
+    static constexpr unsigned MASK = HOUSE_FIELD_TOTAL_AREA;
+    static constexpr Type House::* MEMBER = &House::totalArea;
+    static Type value(const HouseTable& houses, size_t row, int) { return houses.totalArea(row); }
+    static Type value(const HouseColumnStore& store, size_t row, int) {
+        return Area(store.value(static_cast<uint32_t>(row), HouseColumnStore::TOTAL_AREA));
+    }
+};
+
+struct BuildYear {
+    typedef int Type;
+    static constexpr const char* NAME = "build_year";
+    static constexpr const char* TITLE = "Год постройки";
+    static constexpr const char* LABEL = "Год постройки";
+    static constexpr const char* SQL = "build_year";
+    static constexpr const char* SORT_SQL = "build_year";
+    static constexpr const char* SQL_CAST = "::int";
+    static constexpr const char* PROCEDURE_COLUMN = "house_build_year";
+    static constexpr unsigned MASK = HOUSE_FIELD_BUILD_YEAR;
+    static constexpr Type House::* MEMBER = &House::buildYear;
+    static Type value(const HouseTable& houses, size_t row, int) { return houses.buildYear(row); }
+    static Type value(const HouseColumnStore& store, size_t row, int) {
+        return static_cast<Type>(store.value(static_cast<uint32_t>(row), HouseColumnStore::BUILD_YEAR));
+    }
+};
+
+struct Floors {
+    typedef int Type;
+    static constexpr const char* NAME = "floors";
+    static constexpr const char* TITLE = "Этажей";
+    static constexpr const char* LABEL = "Этажность";
+    static constexpr const char* SQL = "floors";
+    static constexpr const char* SORT_SQL = "floors";
+    static constexpr const char* SQL_CAST = "::int";
+    static constexpr const char* PROCEDURE_COLUMN = "house_floors";
+    static constexpr unsigned MASK = HOUSE_FIELD_FLOORS;
+    static constexpr Type House::* MEMBER = &House::floors;
+    static Type value(const HouseTable& houses, size_t row, int) { return houses.floors(row); }
+    static Type value(const HouseColumnStore& store, size_t row, int) {
+        return static_cast<Type>(store.value(static_cast<uint32_t>(row), HouseColumnStore::FLOORS));
+    }
+};
+
+// Вычисляемое поле экспорта: в базе и в House не хранится
+struct Age {
+    typedef int Type;
+    static constexpr const char* NAME = "age";
+    static constexpr const char* LABEL = "Возраст дома";
+    static constexpr const char* SQL = "EXTRACT(YEAR FROM CURRENT_DATE)::int - build_year";
+    static constexpr unsigned MASK = HOUSE_FIELD_BUILD_YEAR;
+    static Type value(const HouseTable& houses, size_t row, int currentYear) {
+        return currentYear - houses.buildYear(row);
+    }
+};
+
+template <typename... Fields>
+struct List {
+    static constexpr size_t COUNT = sizeof...(Fields);
+
+    // visitor вызывается с пустым значением каждого поля по порядку
+    template <typename Visitor>
+    static void forEach(Visitor&& visitor) {
+        (visitor(Fields()), ...);
+    }
+
+    // Массив Make<Field>::VALUE по всем полям, построенный при компиляции:
+    // по нему номер столбца переводится в функцию или строку без switch
+    template <typename T, template <typename> class Make>
+    static constexpr array<T, COUNT> table() {
+        return {{Make<Fields>::VALUE...}};
+    }
+
+    // Поле с именем name; false, если такого нет
+    template <typename Visitor>
+    static bool find(string_view name, Visitor&& visitor) {
+        bool found = false;
+        forEach([&](auto field) {
+            if (!found && name == decltype(field)::NAME) {
+                found = true;
+                visitor(field);
+            }
+        });
+        return found;
+    }
+
+    // Поле с номером index в списке
+    template <typename Visitor>
+    static bool at(size_t index, Visitor&& visitor) {
+        size_t i = 0;
+        bool found = false;
+        forEach([&](auto field) {
+            if (i++ == index) {
+                found = true;
+                visitor(field);
+            }
+        });
+        return found;
+    }
+};
+
+// Хранимые поля: порядок столбцов таблицы домов и процедур get_all_houses() и др.
+typedef List<Id, Address, Apartments, TotalArea, BuildYear, Floors> Stored;
+// Поля экспорта в порядке диалога и файла по умолчанию
+typedef List<Id, Address, Apartments, TotalArea, BuildYear, Floors, Age> Exported;
+
+}
+
+#endif
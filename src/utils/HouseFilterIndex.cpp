@@ -0,0 +1,299 @@
+#include "HouseFilterIndex.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+typedef pair<int64_t, uint32_t> Entry;
+
+RowBitmap allRows(size_t rows) {
+    vector<uint64_t> words((rows + 63) / 64, ~uint64_t(0));
+    if (rows % 64 != 0) words.back() = (uint64_t(1) << (rows % 64)) - 1;
+    return RowBitmap::fromWords(words);
+}
+
+// Пары со значениями в [low, high]
+pair<vector<Entry>::const_iterator, vector<Entry>::const_iterator>
+entriesInRange(const vector<Entry>& entries, int64_t low, int64_t high) {
+    auto first = lower_bound(entries.begin(), entries.end(), Entry(low, 0));
+    auto last = upper_bound(first, entries.end(), Entry(high, UINT32_MAX));
+    return {first, last};
+}
+
+}
+
+HouseFilterIndex::HouseFilterIndex()
+    : store(nullptr) {}
+
+void HouseFilterIndex::clear() {
+    for (ColumnIndex& index : columns) index = ColumnIndex();
+    liveRows.clear();
+    store = nullptr;
+}
+
+void HouseFilterIndex::build(const HouseColumnStore& source) {
+    clear();
+    store = &source;
+    const size_t rows = source.size();
+    liveRows = allRows(rows);
+
+    for (int c = 0; c < INDEXED_COLUMNS; ++c) {
+        HouseColumnStore::Column column = static_cast<HouseColumnStore::Column>(c);
+        ColumnIndex& index = columns[c];
+
+        // Пары (значение, строка) рядом в памяти: сортировка без обращений к снимку
+        vector<pair<int64_t, uint32_t>> pairs(rows);
+        for (uint32_t row = 0; row < rows; ++row) pairs[row] = {source.value(row, column), row};
+        sort(pairs.begin(), pairs.end());
+
+        vector<int64_t>& values = index.sortedValues.mutate();
+        vector<uint32_t>& sortedRows = index.sortedRows.mutate();
+        values.reserve(rows);
+        sortedRows.reserve(rows);
+        for (const auto& entry : pairs) {
+            values.push_back(entry.first);
+            sortedRows.push_back(entry.second);
+        }
+        indexValues(index, rows);
+    }
+}
+
+void HouseFilterIndex::insert(uint32_t row, const House& house) {
+    if (liveRows.contains(row)) return;
+    for (int c = 0; c < INDEXED_COLUMNS; ++c) {
+        insertValue(columns[c], row, HouseColumnStore::fieldValue(house, static_cast<HouseColumnStore::Column>(c)));
+    }
+    liveRows.add(row);
+}
+
+void HouseFilterIndex::update(uint32_t row, const House& before, const House& after) {
+    if (!liveRows.contains(row)) return;
+    for (int c = 0; c < INDEXED_COLUMNS; ++c) {
+        HouseColumnStore::Column column = static_cast<HouseColumnStore::Column>(c);
+        int64_t oldValue = HouseColumnStore::fieldValue(before, column);
+        int64_t newValue = HouseColumnStore::fieldValue(after, column);
+        if (oldValue == newValue) continue;
+        eraseValue(columns[c], row, oldValue);
+        insertValue(columns[c], row, newValue);
+    }
+}
+
+void HouseFilterIndex::remove(uint32_t row, const House& house) {
+    if (!liveRows.contains(row)) return;
+    for (int c = 0; c < INDEXED_COLUMNS; ++c) {
+        eraseValue(columns[c], row, HouseColumnStore::fieldValue(house, static_cast<HouseColumnStore::Column>(c)));
+    }
+    liveRows.remove(row);
+}
+
+size_t HouseFilterIndex::rowCount() const {
+    return entryCount(columns[0]);
+}
+
+bool HouseFilterIndex::contains(uint32_t row) const {
+    return liveRows.contains(row);
+}
+
+size_t HouseFilterIndex::countInRange(const Range& range) const {
+    if (range.column >= INDEXED_COLUMNS) return rowCount();
+    const ColumnIndex& index = columns[range.column];
+    auto begin = lower_bound(index.sortedValues.begin(), index.sortedValues.end(), range.min);
+    auto end = upper_bound(begin, index.sortedValues.end(), range.max);
+    auto added = entriesInRange(index.added, range.min, range.max);
+    auto dropped = entriesInRange(index.dropped, range.min, range.max);
+    return (end - begin) + (added.second - added.first) - (dropped.second - dropped.first);
+}
+
+RowBitmap HouseFilterIndex::match(const vector<Range>& ranges) const {
+    // Диапазоны, не отсекающие ни одной строки, пропускаются
+    vector<pair<size_t, Range>> active;
+    for (const Range& range : ranges) {
+        size_t count = countInRange(range);
+        if (count == 0) return RowBitmap();
+        if (count < rowCount()) active.push_back({count, range});
+    }
+    if (active.empty() || !store) return liveRows;
+
+    sort(active.begin(), active.end(),
+         [](const pair<size_t, Range>& a, const pair<size_t, Range>& b) { return a.first < b.first; });
+
+    vector<uint64_t> words;
+    if (active[0].first * SCAN_RATIO < rowCount()) {
+        // Узкий диапазон: строки из индекса, остальные условия - по снимку
+        const Range& narrowest = active[0].second;
+        words.assign((store->size() + 63) / 64, 0);
+        rangeRows(columns[narrowest.column], narrowest.min, narrowest.max, words);
+
+        for (size_t w = 0; w < words.size() && active.size() > 1; ++w) {
+            for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                uint32_t row = static_cast<uint32_t>(w * 64 + __builtin_ctzll(word));
+                for (size_t i = 1; i < active.size(); ++i) {
+                    if (!store->matches(row, active[i].second)) {
+                        words[w] &= ~(uint64_t(1) << (row & 63));
+                        break;
+                    }
+                }
+            }
+        }
+        return RowBitmap::fromWords(words);
+    }
+
+    // Широкие диапазоны: сканирование упакованных столбцов, затем без удаленных строк
+    vector<Range> scanned;
+    for (const auto& entry : active) scanned.push_back(entry.second);
+    store->scan(scanned, words);
+    if (liveRows.count() < store->size()) {
+        vector<uint64_t> live;
+        liveRows.orInto(live);
+        live.resize(words.size(), 0);
+        for (size_t w = 0; w < words.size(); ++w) words[w] &= live[w];
+    }
+    return RowBitmap::fromWords(words);
+}
+
+size_t HouseFilterIndex::memoryBytes() const {
+    size_t bytes = liveRows.memoryBytes();
+    for (const ColumnIndex& index : columns) {
+        bytes += index.sortedValues.memoryBytes() + index.sortedRows.memoryBytes();
+        bytes += (index.added.capacity() + index.dropped.capacity()) * sizeof(Entry);
+        bytes += index.distinctValues.capacity() * sizeof(int64_t);
+        for (const RowBitmap& rows : index.valueRows) bytes += rows.memoryBytes();
+    }
+    return bytes;
+}
+
+void HouseFilterIndex::write(ImageWriter& out) const {
+    for (const ColumnIndex& index : columns) {
+        out.array(index.sortedValues);
+        out.array(index.sortedRows);
+    }
+}
+
+bool HouseFilterIndex::read(ImageReader& in, const HouseColumnStore& source) {
+    clear();
+    store = &source;
+    const size_t rows = source.size();
+    liveRows = allRows(rows);
+
+    for (ColumnIndex& index : columns) {
+        if (!in.array(index.sortedValues) || !in.array(index.sortedRows) ||
+            index.sortedValues.size() != rows || index.sortedRows.size() != rows) {
+            return false;
+        }
+        indexValues(index, rows);
+    }
+    return true;
+}
+
+void HouseFilterIndex::indexValues(ColumnIndex& index, size_t rows) {
+    const int64_t* values = index.sortedValues.data();
+    const uint32_t* sortedRows = index.sortedRows.data();
+    const size_t count = index.sortedValues.size();
+
+    size_t distinct = 0;
+    for (size_t i = 0; i < count && distinct <= LOW_CARDINALITY; ++i) {
+        if (i == 0 || values[i] != values[i - 1]) distinct++;
+    }
+    index.lowCardinality = distinct <= LOW_CARDINALITY;
+    if (!index.lowCardinality) return;
+
+    // Строки одного значения уже идут подряд и по возрастанию. После каждого
+    // значения обнуляются только заполненные им слова
+    vector<uint64_t> words((rows + 63) / 64, 0);
+    for (size_t begin = 0; begin < count;) {
+        size_t end = begin;
+        while (end < count && values[end] == values[begin]) {
+            uint32_t row = sortedRows[end++];
+            words[row >> 6] |= uint64_t(1) << (row & 63);
+        }
+        index.distinctValues.push_back(values[begin]);
+        index.valueRows.push_back(RowBitmap::fromWords(words));
+        for (size_t i = begin; i < end; ++i) words[sortedRows[i] >> 6] = 0;
+        begin = end;
+    }
+}
+
+void HouseFilterIndex::insertValue(ColumnIndex& index, uint32_t row, int64_t value) {
+    // Пара сборки, выбывшая ранее, возвращается; иначе пара добавляется
+    Entry entry(value, row);
+    auto dropped = lower_bound(index.dropped.begin(), index.dropped.end(), entry);
+    if (dropped != index.dropped.end() && *dropped == entry) {
+        index.dropped.erase(dropped);
+    } else {
+        index.added.insert(lower_bound(index.added.begin(), index.added.end(), entry), entry);
+    }
+
+    if (!index.lowCardinality) return;
+    auto distinct = lower_bound(index.distinctValues.begin(), index.distinctValues.end(), value);
+    size_t slot = distinct - index.distinctValues.begin();
+    if (distinct == index.distinctValues.end() || *distinct != value) {
+        index.distinctValues.insert(distinct, value);
+        index.valueRows.insert(index.valueRows.begin() + slot, RowBitmap());
+    }
+    index.valueRows[slot].add(row);
+}
+
+void HouseFilterIndex::eraseValue(ColumnIndex& index, uint32_t row, int64_t value) {
+    Entry entry(value, row);
+    auto added = lower_bound(index.added.begin(), index.added.end(), entry);
+    auto dropped = lower_bound(index.dropped.begin(), index.dropped.end(), entry);
+    if (added != index.added.end() && *added == entry) {
+        index.added.erase(added);
+    } else if ((dropped == index.dropped.end() || *dropped != entry) && builtContains(index, row, value)) {
+        index.dropped.insert(dropped, entry);
+    } else {
+        return;
+    }
+
+    if (!index.lowCardinality) return;
+    auto distinct = lower_bound(index.distinctValues.begin(), index.distinctValues.end(), value);
+    if (distinct == index.distinctValues.end() || *distinct != value) return;
+    size_t slot = distinct - index.distinctValues.begin();
+    index.valueRows[slot].remove(row);
+    if (index.valueRows[slot].isEmpty()) {
+        index.distinctValues.erase(distinct);
+        index.valueRows.erase(index.valueRows.begin() + slot);
+    }
+}
+
+bool HouseFilterIndex::builtContains(const ColumnIndex& index, uint32_t row, int64_t value) {
+    auto first = lower_bound(index.sortedValues.begin(), index.sortedValues.end(), value);
+    auto last = upper_bound(first, index.sortedValues.end(), value);
+    const uint32_t* rows = index.sortedRows.data();
+    return binary_search(rows + (first - index.sortedValues.begin()), rows + (last - index.sortedValues.begin()), row);
+}
+
+size_t HouseFilterIndex::entryCount(const ColumnIndex& index) {
+    return index.sortedRows.size() + index.added.size() - index.dropped.size();
+}
+
+void HouseFilterIndex::rangeRows(const ColumnIndex& index, int64_t low, int64_t high, vector<uint64_t>& rowBits) const {
+    if (index.lowCardinality) {
+        // Объединение битмапов значений диапазона
+        auto begin = lower_bound(index.distinctValues.begin(), index.distinctValues.end(), low);
+        auto end = upper_bound(begin, index.distinctValues.end(), high);
+        for (auto it = begin; it != end; ++it) {
+            index.valueRows[it - index.distinctValues.begin()].orInto(rowBits);
+        }
+        return;
+    }
+
+    // Срез отсортированной перестановки
+    auto begin = lower_bound(index.sortedValues.begin(), index.sortedValues.end(), low);
+    auto end = upper_bound(begin, index.sortedValues.end(), high);
+    for (auto it = begin; it != end; ++it) {
+        uint32_t row = index.sortedRows[it - index.sortedValues.begin()];
+        rowBits[row >> 6] |= uint64_t(1) << (row & 63);
+    }
+    // Выбывшие пары снимаются раньше добавленных: строка, чье новое значение
+    // в том же диапазоне, остается
+    auto dropped = entriesInRange(index.dropped, low, high);
+    for (auto it = dropped.first; it != dropped.second; ++it) {
+        rowBits[it->second >> 6] &= ~(uint64_t(1) << (it->second & 63));
+    }
+    auto added = entriesInRange(index.added, low, high);
+    for (auto it = added.first; it != added.second; ++it) {
+        rowBits[it->second >> 6] |= uint64_t(1) << (it->second & 63);
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef HOUSEFILTERINDEX_H
+#define HOUSEFILTERINDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../models/House.h"
+#include "HouseColumnStore.h"
+#include "RowBitmap.h"
+#include "SharedArray.h"
+#include "SnapshotImage.h"
+
+using namespace std;
+
+// Индексы числовых столбцов снимка домов для фильтров по диапазонам.
+// Каждый столбец хранит перестановку строк, отсортированную по значению
+// (диапазон и число его строк находятся двоичным поиском); для столбцов с
+// небольшим числом различных значений дополнительно хранится битмап строк
+// каждого значения. Узкий фильтр берется из индекса, широкий - сканированием
+// упакованных столбцов снимка.
+//
+// Отсортированные пары не меняются после сборки и читаются из образа на
+// месте: правки хранятся отдельно списками добавленных и выбывших пар
+class HouseFilterIndex {
+public:
+    typedef HouseColumnStore::Range Range;
+
+    // Не больше стольких различных значений - битмап на каждое значение
+    static const size_t LOW_CARDINALITY = 1024;
+    // Диапазон, оставляющий больше 1/SCAN_RATIO строк, выгоднее сканировать
+    static const size_t SCAN_RATIO = 8;
+
+    HouseFilterIndex();
+
+    void clear();
+    // Индекс ссылается на store до следующего build или clear
+    void build(const HouseColumnStore& store);
+    // Строка, дописанная в store после build
+    void insert(uint32_t row, const House& house);
+    void update(uint32_t row, const House& before, const House& after);
+    void remove(uint32_t row, const House& house);
+
+    size_t rowCount() const;
+    // Строка есть в индексе: не удалена после сборки
+    bool contains(uint32_t row) const;
+    size_t countInRange(const Range& range) const;
+    // Строки, попавшие во все диапазоны; пустой список - все строки
+    RowBitmap match(const vector<Range>& ranges) const;
+    size_t memoryBytes() const;
+
+    // Образ собранного индекса: правки после build в него не попадают.
+    // Битмапы значений строятся при чтении по отсортированным парам
+    void write(ImageWriter& out) const;
+    bool read(ImageReader& in, const HouseColumnStore& store);
+
+private:
+    static const int INDEXED_COLUMNS = HouseColumnStore::FLOORS + 1;
+
+    typedef pair<int64_t, uint32_t> Entry;
+
+    struct ColumnIndex {
+        // Пары (значение, строка) сборки по возрастанию
+        SharedArray<int64_t> sortedValues;
+        SharedArray<uint32_t> sortedRows;
+        // Пары, добавленные после сборки, и выбывшие пары сборки, по возрастанию
+        vector<Entry> added;
+        vector<Entry> dropped;
+        bool lowCardinality = false;
+        vector<int64_t> distinctValues;
+        vector<RowBitmap> valueRows;
+    };
+
+    const HouseColumnStore* store;
+    ColumnIndex columns[INDEXED_COLUMNS];
+    RowBitmap liveRows;
+
+    static void indexValues(ColumnIndex& index, size_t rows);
+    static void insertValue(ColumnIndex& index, uint32_t row, int64_t value);
+    static void eraseValue(ColumnIndex& index, uint32_t row, int64_t value);
+    static bool builtContains(const ColumnIndex& index, uint32_t row, int64_t value);
+    static size_t entryCount(const ColumnIndex& index);
+    void rangeRows(const ColumnIndex& index, int64_t low, int64_t high, vector<uint64_t>& rowBits) const;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "HouseSnapshot.h"
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+HouseSnapshot::HouseSnapshot()
+    : orderedRows(0) {}
+
+void HouseSnapshot::build(const HouseTable& table) {
+    houses.assign(table);
+    orderedRows = 0;
+    laterRows.clear();
+    while (orderedRows < table.size() && (orderedRows == 0 || table.id(orderedRows - 1) < table.id(orderedRows))) {
+        orderedRows++;
+    }
+
+    vector<string_view> addresses;
+    addresses.reserve(table.size());
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (i >= orderedRows) laterRows[table.id(i)] = static_cast<uint32_t>(i);
+        addresses.push_back(table.address(i));
+    }
+    addressIndex.build(addresses);
+    filterIndex.build(houses);
+}
+
+void HouseSnapshot::insert(const House& house) {
+    uint32_t row = 0;
+    if (rowOf(house.id, row)) {
+        update(house);
+        return;
+    }
+
+    row = static_cast<uint32_t>(houses.size());
+    houses.append(house);
+    laterRows[house.id] = row;
+    addressIndex.add(row, house.address);
+    filterIndex.insert(row, house);
+}
+
+void HouseSnapshot::update(const House& house) {
+    uint32_t row = 0;
+    if (!rowOf(house.id, row)) {
+        insert(house);
+        return;
+    }
+
+    filterIndex.update(row, houses.house(row), house);
+    houses.set(row, house);
+    addressIndex.update(row, house.address);
+}
+
+void HouseSnapshot::remove(int houseId) {
+    uint32_t row = 0;
+    if (!rowOf(houseId, row)) return;
+
+    filterIndex.remove(row, houses.house(row));
+    addressIndex.remove(row);
+    laterRows.erase(houseId);
+}
+
+bool HouseSnapshot::rowOf(int houseId, uint32_t& row) const {
+    auto later = laterRows.find(houseId);
+    if (later != laterRows.end()) {
+        row = later->second;
+        return true;
+    }
+
+    size_t low = 0;
+    size_t high = orderedRows;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (houses.value(static_cast<uint32_t>(middle), HouseColumnStore::ID) < houseId) low = middle + 1;
+        else high = middle;
+    }
+    if (low == orderedRows || houses.value(static_cast<uint32_t>(low), HouseColumnStore::ID) != houseId) return false;
+    row = static_cast<uint32_t>(low);
+    return filterIndex.contains(row);
+}
+
+void HouseSnapshot::write(ImageWriter& out) const {
+    out.value<uint64_t>(orderedRows);
+    houses.write(out);
+    addressIndex.write(out);
+    filterIndex.write(out);
+}
+
+bool HouseSnapshot::read(ImageReader& in) {
+    uint64_t ordered = 0;
+    laterRows.clear();
+    if (!in.value(ordered) || !houses.read(in) || ordered > houses.size() ||
+        !addressIndex.read(in) || addressIndex.documentCount() != houses.size() ||
+        !filterIndex.read(in, houses)) {
+        return false;
+    }
+
+    // Образ пишется сразу после сборки: все строки вне порядка id - из сборки
+    orderedRows = ordered;
+    for (size_t row = orderedRows; row < houses.size(); ++row) {
+        laterRows[static_cast<int>(houses.value(static_cast<uint32_t>(row), HouseColumnStore::ID))] =
+            static_cast<uint32_t>(row);
+    }
+    return true;
+}
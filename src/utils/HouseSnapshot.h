@@ -0,0 +1,51 @@
+#ifndef HOUSESNAPSHOT_H
+#define HOUSESNAPSHOT_H
+
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "../models/House.h"
+#include "HouseTable.h"
+#include "HouseColumnStore.h"
+#include "TrigramIndex.h"
+#include "HouseFilterIndex.h"
+#include "SnapshotImage.h"
+
+using namespace std;
+
+// Все дома для работы в памяти: столбцы и индексы поиска и фильтров.
+// Строится целиком в рабочем потоке и передается окну готовым либо читается
+// из образа общего снимка: тогда массивы остаются в сегменте, а правки
+// поверх них хранятся отдельно. Индекс фильтров ссылается на столбцы,
+// поэтому снимок не копируется
+struct HouseSnapshot {
+    HouseColumnStore houses;
+    TrigramIndex addressIndex;
+    HouseFilterIndex filterIndex;
+    // Строки [0, orderedRows) идут по возрастанию id: их строка ищется делением пополам
+    size_t orderedRows;
+    // Строки после них: добавленные правками или сборка не по порядку id
+    unordered_map<int, uint32_t> laterRows;
+
+    HouseSnapshot();
+    HouseSnapshot(const HouseSnapshot&) = delete;
+    HouseSnapshot& operator=(const HouseSnapshot&) = delete;
+
+    void build(const HouseTable& table);
+    // Новый дом дописывается в конец столбцов и индексов
+    void insert(const House& house);
+    // Правка дома; неизвестный id добавляется как новый дом
+    void update(const House& house);
+    // Строка остается до следующей сборки, но исключается из индексов
+    void remove(int houseId);
+
+    // Строка дома; false, если его нет или он удален
+    bool rowOf(int houseId, uint32_t& row) const;
+
+    // Образ собранного снимка; снимок после правок записывать нельзя
+    void write(ImageWriter& out) const;
+    // Массивы снимка ссылаются на образ; false, если образ поврежден
+    bool read(ImageReader& in);
+};
+
+#endif
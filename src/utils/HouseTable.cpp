@@ -0,0 +1,177 @@
+#include "HouseTable.h"
+#include <algorithm>
+
+using namespace std;
+
+HouseTable::HouseTable() {}
+
+HouseTable HouseTable::fromHouses(const vector<House>& houses) {
+    size_t bytes = 0;
+    for (const House& house : houses) bytes += house.address.size();
+
+    HouseTable table;
+    table.reserve(houses.size(), bytes);
+    for (const House& house : houses) table.append(house);
+    return table;
+}
+
+size_t HouseTable::size() const {
+    return ids.size();
+}
+
+bool HouseTable::empty() const {
+    return ids.empty();
+}
+
+void HouseTable::clear() {
+    ids.clear();
+    apartmentCounts.clear();
+    totalAreas.clear();
+    buildYears.clear();
+    floorCounts.clear();
+    addressData.clear();
+    addressOffsets.clear();
+    addressLengths.clear();
+}
+
+void HouseTable::reserve(size_t rows, size_t addressBytes) {
+    ids.reserve(rows);
+    apartmentCounts.reserve(rows);
+    totalAreas.reserve(rows);
+    buildYears.reserve(rows);
+    floorCounts.reserve(rows);
+    addressOffsets.reserve(rows);
+    addressLengths.reserve(rows);
+    addressData.reserve(addressBytes);
+}
+
+void HouseTable::append(const House& house) {
+    append(house.id, house.address, house.apartments, house.totalArea, house.buildYear, house.floors);
+}
+
+void HouseTable::append(int id, string_view address, int apartments, Area totalArea, int buildYear, int floors) {
+    ids.push_back(id);
+    apartmentCounts.push_back(apartments);
+    totalAreas.push_back(totalArea.hundredths);
+    buildYears.push_back(buildYear);
+    floorCounts.push_back(floors);
+    addressOffsets.push_back(0);
+    addressLengths.push_back(0);
+    storeAddress(ids.size() - 1, address);
+}
+
+void HouseTable::append(const HouseTable& other, size_t row) {
+    append(other.id(row), other.address(row), other.apartments(row), other.totalArea(row),
+           other.buildYear(row), other.floors(row));
+}
+
+void HouseTable::append(const HouseTable& other) {
+    // Без reserve: при дозаписи страницами столбцы растут геометрически
+    for (size_t row = 0; row < other.size(); ++row) {
+        append(other, row);
+    }
+}
+
+void HouseTable::set(size_t row, const House& house) {
+    if (row >= size()) return;
+
+    ids[row] = house.id;
+    apartmentCounts[row] = house.apartments;
+    totalAreas[row] = house.totalArea.hundredths;
+    buildYears[row] = house.buildYear;
+    floorCounts[row] = house.floors;
+    if (address(row) != house.address) {
+        storeAddress(row, house.address);
+    }
+}
+
+void HouseTable::erase(size_t row, size_t count) {
+    if (row >= size() || count == 0) return;
+    count = min(count, size() - row);
+
+    // Байты адресов удаленных строк остаются в буфере до clear()
+    auto eraseRange = [row, count](auto& column) {
+        column.erase(column.begin() + row, column.begin() + row + count);
+    };
+    eraseRange(ids);
+    eraseRange(apartmentCounts);
+    eraseRange(totalAreas);
+    eraseRange(buildYears);
+    eraseRange(floorCounts);
+    eraseRange(addressOffsets);
+    eraseRange(addressLengths);
+}
+
+HouseTable::Columns HouseTable::columns() const {
+    Columns result;
+    result.rows = size();
+    result.ids = ids.data();
+    result.apartments = apartmentCounts.data();
+    result.totalAreas = totalAreas.data();
+    result.buildYears = buildYears.data();
+    result.floors = floorCounts.data();
+    result.addressOffsets = addressOffsets.data();
+    result.addressLengths = addressLengths.data();
+    result.addressData = addressData.data();
+    result.addressBytes = addressData.size();
+    return result;
+}
+
+bool HouseTable::assign(const Columns& columns) {
+    for (size_t row = 0; row < columns.rows; ++row) {
+        if (columns.addressOffsets[row] > columns.addressBytes ||
+            columns.addressLengths[row] > columns.addressBytes - columns.addressOffsets[row]) {
+            return false;
+        }
+    }
+
+    size_t rows = columns.rows;
+    ids.assign(columns.ids, columns.ids + rows);
+    apartmentCounts.assign(columns.apartments, columns.apartments + rows);
+    totalAreas.assign(columns.totalAreas, columns.totalAreas + rows);
+    buildYears.assign(columns.buildYears, columns.buildYears + rows);
+    floorCounts.assign(columns.floors, columns.floors + rows);
+    addressOffsets.assign(columns.addressOffsets, columns.addressOffsets + rows);
+    addressLengths.assign(columns.addressLengths, columns.addressLengths + rows);
+    addressData.assign(columns.addressData, columns.addressBytes);
+    return true;
+}
+
+House HouseTable::house(size_t row) const {
+    House house;
+    if (row >= size()) return house;
+
+    house.id = ids[row];
+    house.address.assign(address(row));
+    house.apartments = apartmentCounts[row];
+    house.totalArea = Area(totalAreas[row]);
+    house.buildYear = buildYears[row];
+    house.floors = floorCounts[row];
+    return house;
+}
+
+vector<House> HouseTable::toHouses() const {
+    vector<House> houses;
+    houses.reserve(size());
+    for (size_t row = 0; row < size(); ++row) {
+        houses.push_back(house(row));
+    }
+    return houses;
+}
+
+size_t HouseTable::addressBytes() const {
+    return addressData.size();
+}
+
+size_t HouseTable::memoryBytes() const {
+    return (ids.capacity() + apartmentCounts.capacity() + buildYears.capacity() + floorCounts.capacity()) * sizeof(int) +
+           totalAreas.capacity() * sizeof(int64_t) +
+           (addressOffsets.capacity() + addressLengths.capacity()) * sizeof(uint32_t) +
+           addressData.capacity();
+}
+
+void HouseTable::storeAddress(size_t row, string_view address) {
+    addressOffsets[row] = static_cast<uint32_t>(addressData.size());
+    addressLengths[row] = static_cast<uint32_t>(address.size());
+    addressData.append(address.data(), address.size());
+}
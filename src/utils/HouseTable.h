@@ -0,0 +1,88 @@
+#ifndef HOUSETABLE_H
+#define HOUSETABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../models/House.h"
+
+using namespace std;
+
+// Набор домов по столбцам. Адреса лежат подряд в одном буфере, у строки -
+// смещение и длина, поэтому таблица из миллиона домов занимает несколько
+// выделений памяти вместо миллиона. Таблица только перемещается: копия
+// большого набора должна быть явной (append по строкам)
+class HouseTable {
+public:
+    // Столбцы таблицы как есть: файл снимка пишется и читается блоками, без разбора по строкам
+    struct Columns {
+        size_t rows = 0;
+        const int* ids = nullptr;
+        const int* apartments = nullptr;
+        const int64_t* totalAreas = nullptr;
+        const int* buildYears = nullptr;
+        const int* floors = nullptr;
+        const uint32_t* addressOffsets = nullptr;
+        const uint32_t* addressLengths = nullptr;
+        const char* addressData = nullptr;
+        size_t addressBytes = 0;
+    };
+
+    HouseTable();
+    HouseTable(HouseTable&&) noexcept = default;
+    HouseTable& operator=(HouseTable&&) noexcept = default;
+    HouseTable(const HouseTable&) = delete;
+    HouseTable& operator=(const HouseTable&) = delete;
+
+    static HouseTable fromHouses(const vector<House>& houses);
+
+    size_t size() const;
+    bool empty() const;
+    void clear();
+    // Память под строки и байты адресов заранее, чтобы декодер не перевыделял буферы
+    void reserve(size_t rows, size_t addressBytes = 0);
+
+    void append(const House& house);
+    void append(int id, string_view address, int apartments, Area totalArea, int buildYear, int floors);
+    void append(const HouseTable& other, size_t row);
+    // Все строки other в конец таблицы
+    void append(const HouseTable& other);
+    // Новый адрес дописывается в конец буфера, прежний остается до clear()
+    void set(size_t row, const House& house);
+    void erase(size_t row, size_t count);
+
+    int id(size_t row) const { return ids[row]; }
+    string_view address(size_t row) const {
+        return string_view(addressData.data() + addressOffsets[row], addressLengths[row]);
+    }
+    int apartments(size_t row) const { return apartmentCounts[row]; }
+    Area totalArea(size_t row) const { return Area(totalAreas[row]); }
+    int buildYear(size_t row) const { return buildYears[row]; }
+    int floors(size_t row) const { return floorCounts[row]; }
+
+    Columns columns() const;
+    // Заменяет содержимое копией столбцов; false, если адрес строки выходит за addressData
+    bool assign(const Columns& columns);
+
+    House house(size_t row) const;
+    vector<House> toHouses() const;
+
+    size_t addressBytes() const;
+    size_t memoryBytes() const;
+
+private:
+    vector<int> ids;
+    vector<int> apartmentCounts;
+    vector<int64_t> totalAreas;     // сотые доли м²
+    vector<int> buildYears;
+    vector<int> floorCounts;
+    string addressData;
+    vector<uint32_t> addressOffsets;
+    vector<uint32_t> addressLengths;
+
+    void storeAddress(size_t row, string_view address);
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "MappedFile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+MappedFile::MappedFile()
+    : mappedData(nullptr), mappedSize(0), opened(false) {}
+
+MappedFile::MappedFile(const string& filename)
+    : MappedFile() {
+    open(filename);
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : mappedData(other.mappedData), mappedSize(other.mappedSize), opened(other.opened) {
+    other.mappedData = nullptr;
+    other.mappedSize = 0;
+    other.opened = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        mappedData = other.mappedData;
+        mappedSize = other.mappedSize;
+        opened = other.opened;
+        other.mappedData = nullptr;
+        other.mappedSize = 0;
+        other.opened = false;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const string& filename) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    mappedSize = static_cast<size_t>(st.st_size);
+    if (mappedSize > 0) {
+        void* addr = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            mappedSize = 0;
+            return false;
+        }
+        // Файл читается последовательно от начала до конца
+        madvise(addr, mappedSize, MADV_SEQUENTIAL);
+        mappedData = static_cast<const char*>(addr);
+    }
+
+    // Отображение остается валидным и после закрытия дескриптора
+    ::close(fd);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (mappedData) {
+        munmap(const_cast<char*>(mappedData), mappedSize);
+    }
+    mappedData = nullptr;
+    mappedSize = 0;
+    opened = false;
+}
+
+bool MappedFile::isOpen() const {
+    return opened;
+}
+
+const char* MappedFile::data() const {
+    return mappedData;
+}
+
+size_t MappedFile::size() const {
+    return mappedSize;
+}
@@ -0,0 +1,257 @@
+#include "PackedColumn.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PACKED_COLUMN_PEXT_DISPATCH 1
+#endif
+
+using namespace std;
+
+namespace {
+
+unsigned bitsFor(uint64_t range) {
+    unsigned bits = 1;
+    while (bits < 62 && (range >> bits) != 0) bits++;
+    return bits;
+}
+
+// PEXT есть на процессоре, где программа запущена. На Zen 1 и Zen 2 инструкция
+// микрокодовая и медленнее цикла по значениям, там она не используется
+bool pextAvailable() {
+#if defined(__BMI2__)
+    return true;
+#elif defined(PACKED_COLUMN_PEXT_DISPATCH)
+    static const bool available = __builtin_cpu_supports("bmi2") &&
+                                  !__builtin_cpu_is("znver1") && !__builtin_cpu_is("znver2");
+    return available;
+#else
+    return false;
+#endif
+}
+
+// Биты-разделители слова (по одному на значение) подряд в младших битах
+template <bool PEXT>
+inline uint64_t compactLanes(uint64_t hits, uint64_t delimiters, unsigned lanes, unsigned fieldBits, unsigned width) {
+    if (PEXT) {
+#if defined(__BMI2__)
+        return _pext_u64(hits, delimiters);
+#elif defined(PACKED_COLUMN_PEXT_DISPATCH)
+        // Без -mbmi2 встроенная функция недоступна; инструкция выполняется,
+        // только если pextAvailable()
+        uint64_t compact;
+        __asm__("pextq %2, %1, %0" : "=r"(compact) : "r"(hits), "rm"(delimiters));
+        return compact;
+#endif
+    }
+    uint64_t compact = 0;
+    for (unsigned lane = 0; lane < lanes; ++lane) {
+        compact |= ((hits >> (lane * fieldBits + width)) & 1) << lane;
+    }
+    return compact;
+}
+
+}
+
+PackedColumn::PackedColumn()
+    : count(0), base(0), width(1), lanes(32) {}
+
+void PackedColumn::clear() {
+    words.clear();
+    count = 0;
+    base = 0;
+    width = 1;
+    lanes = 32;
+}
+
+void PackedColumn::assign(const vector<int64_t>& values) {
+    if (values.empty()) {
+        clear();
+        return;
+    }
+    auto range = minmax_element(values.begin(), values.end());
+    pack(values, *range.first, *range.second);
+}
+
+void PackedColumn::push_back(int64_t value) {
+    if (count == 0 || value < base || static_cast<uint64_t>(value - base) > laneMask()) {
+        vector<int64_t> values;
+        values.reserve(count + 1);
+        for (size_t row = 0; row < count; ++row) values.push_back(get(row));
+        values.push_back(value);
+        // Ширина покрывает диапазон до следующей степени двойки, поэтому
+        // при возрастающих значениях (id) перепаковок всего O(log n)
+        int64_t minValue = count == 0 ? value : min(base, value);
+        int64_t maxValue = count == 0 ? value : max(base + static_cast<int64_t>(laneMask()), value);
+        pack(values, minValue, maxValue);
+        return;
+    }
+
+    vector<uint64_t>& packed = words.mutate();
+    if (count % lanes == 0) packed.push_back(0);
+    packed.back() |= static_cast<uint64_t>(value - base) << ((count % lanes) * (width + 1));
+    count++;
+}
+
+void PackedColumn::set(size_t row, int64_t value) {
+    // Без изменения значения слова не копируются из образа
+    if (row >= count || get(row) == value) return;
+    if (value < base || static_cast<uint64_t>(value - base) > laneMask()) {
+        vector<int64_t> values;
+        values.reserve(count);
+        for (size_t i = 0; i < count; ++i) values.push_back(get(i));
+        values[row] = value;
+        pack(values, min(base, value), max(base + static_cast<int64_t>(laneMask()), value));
+        return;
+    }
+
+    unsigned shift = (row % lanes) * (width + 1);
+    uint64_t& word = words.mutate()[row / lanes];
+    word = (word & ~(laneMask() << shift)) | (static_cast<uint64_t>(value - base) << shift);
+}
+
+int64_t PackedColumn::get(size_t row) const {
+    uint64_t word = words[row / lanes];
+    return base + static_cast<int64_t>((word >> ((row % lanes) * (width + 1))) & laneMask());
+}
+
+size_t PackedColumn::size() const {
+    return count;
+}
+
+unsigned PackedColumn::bitWidth() const {
+    return width;
+}
+
+size_t PackedColumn::memoryBytes() const {
+    return words.memoryBytes();
+}
+
+void PackedColumn::andRange(int64_t minValue, int64_t maxValue, vector<uint64_t>& rowBits) const {
+    // Границы в смещениях от base, обрезанные до [0, 2^width]
+    const int64_t top = static_cast<int64_t>(laneMask()) + 1;
+    int64_t low = minValue <= base ? 0 : min(minValue - base, top);
+    int64_t high = maxValue < base ? 0 : min(maxValue - base + 1, top);
+    if (low >= high) {
+        fill(rowBits.begin(), rowBits.end(), 0);
+        return;
+    }
+
+    // x >= c  <=>  в разделителе x + (2^width - c) появляется перенос
+    const uint64_t addLow = replicate(static_cast<uint64_t>(top - low));
+    const uint64_t addHigh = replicate(static_cast<uint64_t>(top - high));
+    if (pextAvailable()) {
+        andWords<true>(addLow, addHigh, rowBits);
+    } else {
+        andWords<false>(addLow, addHigh, rowBits);
+    }
+}
+
+template <bool PEXT>
+void PackedColumn::andWords(uint64_t addLow, uint64_t addHigh, vector<uint64_t>& rowBits) const {
+    const unsigned fieldBits = width + 1;
+    const uint64_t delimiters = replicate(uint64_t(1) << width);
+
+    uint64_t accumulator = 0;
+    unsigned accumulated = 0;
+    size_t outWord = 0;
+    auto emit = [&](uint64_t hits, unsigned rows) {
+        uint64_t bits = compactLanes<PEXT>(hits, delimiters, lanes, fieldBits, width);
+        accumulator |= bits << accumulated;
+        accumulated += rows;
+        if (accumulated >= 64) {
+            rowBits[outWord++] &= accumulator;
+            accumulated -= 64;
+            accumulator = accumulated > 0 ? bits >> (rows - accumulated) : 0;
+        }
+    };
+
+    const uint64_t* data = words.data();
+    const size_t fullWords = count / lanes;
+    size_t w = 0;
+#if defined(__SSE2__)
+    // По два слова за шаг: 64-битные сложения не переносят биты между словами
+    const __m128i delimiterMask = _mm_set1_epi64x(static_cast<long long>(delimiters));
+    const __m128i lowAdd = _mm_set1_epi64x(static_cast<long long>(addLow));
+    const __m128i highAdd = _mm_set1_epi64x(static_cast<long long>(addHigh));
+    alignas(16) uint64_t hits[2];
+    for (; w + 2 <= fullWords; w += 2) {
+        __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + w));
+        __m128i atLeastLow = _mm_and_si128(_mm_add_epi64(packed, lowAdd), delimiterMask);
+        __m128i atLeastHigh = _mm_and_si128(_mm_add_epi64(packed, highAdd), delimiterMask);
+        _mm_store_si128(reinterpret_cast<__m128i*>(hits), _mm_andnot_si128(atLeastHigh, atLeastLow));
+        emit(hits[0], lanes);
+        emit(hits[1], lanes);
+    }
+#endif
+    for (; w < fullWords; ++w) {
+        uint64_t packed = data[w];
+        emit(((packed + addLow) & delimiters) & ~((packed + addHigh) & delimiters), lanes);
+    }
+    if (count % lanes != 0) {
+        uint64_t packed = data[fullWords];
+        uint64_t hits = ((packed + addLow) & delimiters) & ~((packed + addHigh) & delimiters);
+        unsigned rows = count % lanes;
+        emit(hits & ((uint64_t(1) << (rows * fieldBits)) - 1), rows);
+    }
+    if (accumulated > 0) {
+        rowBits[outWord++] &= accumulator;
+    }
+}
+
+void PackedColumn::write(ImageWriter& out) const {
+    out.value<uint64_t>(count);
+    out.value<int64_t>(base);
+    out.value<uint32_t>(width);
+    out.array(words);
+}
+
+bool PackedColumn::read(ImageReader& in) {
+    uint64_t rows = 0;
+    int64_t minValue = 0;
+    uint32_t bits = 0;
+    if (!in.value(rows) || !in.value(minValue) || !in.value(bits) || bits == 0 || bits > 62 ||
+        !in.array(words)) {
+        return false;
+    }
+    unsigned rowLanes = 64 / (bits + 1);
+    if (words.size() != (rows + rowLanes - 1) / rowLanes) return false;
+
+    count = rows;
+    base = minValue;
+    width = bits;
+    lanes = rowLanes;
+    return true;
+}
+
+void PackedColumn::pack(const vector<int64_t>& values, int64_t minValue, int64_t maxValue) {
+    base = minValue;
+    width = bitsFor(static_cast<uint64_t>(maxValue - minValue));
+    lanes = 64 / (width + 1);
+    count = values.size();
+
+    // Прежние слова не копируются: значения уже в values
+    words.clear();
+    vector<uint64_t>& packed = words.mutate();
+    packed.assign((count + lanes - 1) / lanes, 0);
+    for (size_t row = 0; row < count; ++row) {
+        packed[row / lanes] |= static_cast<uint64_t>(values[row] - base) << ((row % lanes) * (width + 1));
+    }
+}
+
+uint64_t PackedColumn::laneMask() const {
+    return (uint64_t(1) << width) - 1;
+}
+
+uint64_t PackedColumn::replicate(uint64_t laneValue) const {
+    uint64_t result = 0;
+    for (unsigned lane = 0; lane < lanes; ++lane) {
+        result |= laneValue << (lane * (width + 1));
+    }
+    return result;
+}
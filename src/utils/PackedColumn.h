@@ -0,0 +1,54 @@
+#ifndef PACKEDCOLUMN_H
+#define PACKEDCOLUMN_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "SharedArray.h"
+#include "SnapshotImage.h"
+
+using namespace std;
+
+// Столбец целых, упакованных в 64-битные слова: значение хранится как
+// (value - base) в width битах, над ним - нулевой бит-разделитель. Сравнение
+// с константой выполняется сразу для всех значений слова сложением: перенос
+// в бит-разделитель означает value >= константы (схема BitWeaving/H)
+class PackedColumn {
+public:
+    PackedColumn();
+
+    void clear();
+    // Ширина подбирается по минимуму и максимуму значений
+    void assign(const vector<int64_t>& values);
+    void push_back(int64_t value);
+    // Значение вне текущего диапазона перепаковывает столбец
+    void set(size_t row, int64_t value);
+    int64_t get(size_t row) const;
+
+    size_t size() const;
+    unsigned bitWidth() const;
+    size_t memoryBytes() const;
+
+    // rowBits[row / 64] сохраняет бит строки, только если значение в [minValue, maxValue]
+    void andRange(int64_t minValue, int64_t maxValue, vector<uint64_t>& rowBits) const;
+
+    // Слова читаются из образа на месте; первое изменение копирует их
+    void write(ImageWriter& out) const;
+    bool read(ImageReader& in);
+
+private:
+    SharedArray<uint64_t> words;
+    size_t count;
+    int64_t base;
+    unsigned width;
+    unsigned lanes;
+
+    void pack(const vector<int64_t>& values, int64_t minValue, int64_t maxValue);
+    uint64_t laneMask() const;
+    uint64_t replicate(uint64_t laneValue) const;
+    // Проход andRange; PEXT - сжатие разделителей инструкцией BMI2
+    template <bool PEXT>
+    void andWords(uint64_t addLow, uint64_t addHigh, vector<uint64_t>& rowBits) const;
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include "RowBitmap.h"
+#include <algorithm>
+
+using namespace std;
+
+RowBitmap::RowBitmap() {}
+
+void RowBitmap::clear() {
+    containers.clear();
+}
+
+bool RowBitmap::isEmpty() const {
+    return containers.empty();
+}
+
+size_t RowBitmap::count() const {
+    size_t total = 0;
+    for (const Container& container : containers) total += container.cardinality;
+    return total;
+}
+
+void RowBitmap::add(uint32_t row) {
+    uint16_t key = static_cast<uint16_t>(row >> 16);
+    uint16_t low = static_cast<uint16_t>(row);
+
+    size_t index = lowerBound(key);
+    if (index == containers.size() || containers[index].key != key) {
+        Container container;
+        container.key = key;
+        container.cardinality = 0;
+        containers.insert(containers.begin() + index, move(container));
+    }
+
+    Container& container = containers[index];
+    if (container.isBitset()) {
+        uint64_t mask = uint64_t(1) << (low & 63);
+        if (container.bits[low >> 6] & mask) return;
+        container.bits[low >> 6] |= mask;
+    } else {
+        auto pos = lower_bound(container.values.begin(), container.values.end(), low);
+        if (pos != container.values.end() && *pos == low) return;
+        container.values.insert(pos, low);
+    }
+    container.cardinality++;
+    if (!container.isBitset() && container.cardinality > ARRAY_LIMIT) toBitset(container);
+}
+
+void RowBitmap::remove(uint32_t row) {
+    uint16_t key = static_cast<uint16_t>(row >> 16);
+    uint16_t low = static_cast<uint16_t>(row);
+
+    size_t index = lowerBound(key);
+    if (index == containers.size() || containers[index].key != key) return;
+
+    Container& container = containers[index];
+    if (container.isBitset()) {
+        uint64_t mask = uint64_t(1) << (low & 63);
+        if (!(container.bits[low >> 6] & mask)) return;
+        container.bits[low >> 6] &= ~mask;
+    } else {
+        auto pos = lower_bound(container.values.begin(), container.values.end(), low);
+        if (pos == container.values.end() || *pos != low) return;
+        container.values.erase(pos);
+    }
+    container.cardinality--;
+
+    if (container.cardinality == 0) {
+        containers.erase(containers.begin() + index);
+    } else if (container.isBitset() && container.cardinality <= ARRAY_LIMIT) {
+        toArray(container);
+    }
+}
+
+bool RowBitmap::contains(uint32_t row) const {
+    const Container* container = find(static_cast<uint16_t>(row >> 16));
+    if (!container) return false;
+
+    uint16_t low = static_cast<uint16_t>(row);
+    if (container->isBitset()) {
+        return (container->bits[low >> 6] >> (low & 63)) & 1;
+    }
+    return binary_search(container->values.begin(), container->values.end(), low);
+}
+
+void RowBitmap::intersectWith(const RowBitmap& other) {
+    size_t kept = 0;
+    size_t j = 0;
+    for (size_t i = 0; i < containers.size(); ++i) {
+        while (j < other.containers.size() && other.containers[j].key < containers[i].key) j++;
+        if (j == other.containers.size()) break;
+        if (other.containers[j].key != containers[i].key) continue;
+
+        if (intersect(containers[i], other.containers[j])) {
+            if (kept != i) containers[kept] = move(containers[i]);
+            kept++;
+        }
+    }
+    containers.resize(kept);
+}
+
+void RowBitmap::orInto(vector<uint64_t>& words) const {
+    if (containers.empty()) return;
+    size_t needed = (static_cast<size_t>(containers.back().key) + 1) * BLOCK_WORDS;
+    if (words.size() < needed) words.resize(needed, 0);
+
+    for (const Container& container : containers) {
+        uint64_t* block = words.data() + static_cast<size_t>(container.key) * BLOCK_WORDS;
+        if (container.isBitset()) {
+            for (size_t w = 0; w < BLOCK_WORDS; ++w) block[w] |= container.bits[w];
+        } else {
+            for (uint16_t low : container.values) block[low >> 6] |= uint64_t(1) << (low & 63);
+        }
+    }
+}
+
+RowBitmap RowBitmap::fromWords(const vector<uint64_t>& words) {
+    RowBitmap bitmap;
+    for (size_t start = 0; start < words.size(); start += BLOCK_WORDS) {
+        size_t end = min(words.size(), start + BLOCK_WORDS);
+        uint32_t cardinality = 0;
+        for (size_t w = start; w < end; ++w) cardinality += __builtin_popcountll(words[w]);
+        if (cardinality == 0) continue;
+
+        Container container;
+        container.key = static_cast<uint16_t>(start / BLOCK_WORDS);
+        container.cardinality = cardinality;
+        if (cardinality > ARRAY_LIMIT) {
+            container.bits.assign(BLOCK_WORDS, 0);
+            copy(words.begin() + start, words.begin() + end, container.bits.begin());
+        } else {
+            container.values.reserve(cardinality);
+            for (size_t w = start; w < end; ++w) {
+                for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                    container.values.push_back(static_cast<uint16_t>((w - start) * 64 + __builtin_ctzll(word)));
+                }
+            }
+        }
+        bitmap.containers.push_back(move(container));
+    }
+    return bitmap;
+}
+
+void RowBitmap::toRows(vector<uint32_t>& rows) const {
+    rows.clear();
+    rows.reserve(count());
+    for (const Container& container : containers) {
+        uint32_t high = static_cast<uint32_t>(container.key) << 16;
+        if (container.isBitset()) {
+            for (size_t w = 0; w < BLOCK_WORDS; ++w) {
+                for (uint64_t word = container.bits[w]; word != 0; word &= word - 1) {
+                    rows.push_back(high | static_cast<uint32_t>(w * 64 + __builtin_ctzll(word)));
+                }
+            }
+        } else {
+            for (uint16_t low : container.values) rows.push_back(high | low);
+        }
+    }
+}
+
+size_t RowBitmap::memoryBytes() const {
+    size_t bytes = containers.capacity() * sizeof(Container);
+    for (const Container& container : containers) {
+        bytes += container.values.capacity() * sizeof(uint16_t) + container.bits.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+size_t RowBitmap::lowerBound(uint16_t key) const {
+    auto pos = lower_bound(containers.begin(), containers.end(), key,
+                           [](const Container& container, uint16_t value) { return container.key < value; });
+    return pos - containers.begin();
+}
+
+const RowBitmap::Container* RowBitmap::find(uint16_t key) const {
+    size_t index = lowerBound(key);
+    return index < containers.size() && containers[index].key == key ? &containers[index] : nullptr;
+}
+
+void RowBitmap::toBitset(Container& container) {
+    container.bits.assign(BLOCK_WORDS, 0);
+    for (uint16_t low : container.values) container.bits[low >> 6] |= uint64_t(1) << (low & 63);
+    vector<uint16_t>().swap(container.values);
+}
+
+void RowBitmap::toArray(Container& container) {
+    container.values.clear();
+    container.values.reserve(container.cardinality);
+    for (size_t w = 0; w < BLOCK_WORDS; ++w) {
+        for (uint64_t word = container.bits[w]; word != 0; word &= word - 1) {
+            container.values.push_back(static_cast<uint16_t>(w * 64 + __builtin_ctzll(word)));
+        }
+    }
+    vector<uint64_t>().swap(container.bits);
+}
+
+// Пересечение блоков с одним ключом; false - блок опустел
+bool RowBitmap::intersect(Container& target, const Container& other) {
+    if (target.isBitset() && other.isBitset()) {
+        uint32_t cardinality = 0;
+        for (size_t w = 0; w < BLOCK_WORDS; ++w) {
+            target.bits[w] &= other.bits[w];
+            cardinality += __builtin_popcountll(target.bits[w]);
+        }
+        target.cardinality = cardinality;
+        if (cardinality > 0 && cardinality <= ARRAY_LIMIT) toArray(target);
+    } else if (target.isBitset()) {
+        // Результат не больше массива другого блока
+        vector<uint16_t> values;
+        values.reserve(other.values.size());
+        for (uint16_t low : other.values) {
+            if ((target.bits[low >> 6] >> (low & 63)) & 1) values.push_back(low);
+        }
+        vector<uint64_t>().swap(target.bits);
+        target.values = move(values);
+        target.cardinality = static_cast<uint32_t>(target.values.size());
+    } else if (other.isBitset()) {
+        size_t kept = 0;
+        for (uint16_t low : target.values) {
+            if ((other.bits[low >> 6] >> (low & 63)) & 1) target.values[kept++] = low;
+        }
+        target.values.resize(kept);
+        target.cardinality = static_cast<uint32_t>(kept);
+    } else {
+        // Запись идет не дальше чтения, поэтому пересекаем на месте
+        size_t kept = 0;
+        size_t j = 0;
+        for (uint16_t low : target.values) {
+            while (j < other.values.size() && other.values[j] < low) j++;
+            if (j == other.values.size()) break;
+            if (other.values[j] == low) target.values[kept++] = low;
+        }
+        target.values.resize(kept);
+        target.cardinality = static_cast<uint32_t>(kept);
+    }
+    return target.cardinality > 0;
+}
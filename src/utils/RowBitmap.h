@@ -0,0 +1,58 @@
+#ifndef ROWBITMAP_H
+#define ROWBITMAP_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Сжатое множество номеров строк в духе Roaring: номера делятся на блоки
+// по 65536, блок хранится отсортированным массивом младших 16 бит, пока
+// в нем не больше ARRAY_LIMIT значений, иначе - битовой картой на 8 КБ
+class RowBitmap {
+public:
+    static const uint32_t ARRAY_LIMIT = 4096;
+
+    RowBitmap();
+
+    void clear();
+    bool isEmpty() const;
+    size_t count() const;
+
+    void add(uint32_t row);
+    void remove(uint32_t row);
+    bool contains(uint32_t row) const;
+
+    void intersectWith(const RowBitmap& other);
+    // Объединение многих множеств дешевле через плотный массив слов:
+    // orInto в общий массив, затем fromWords
+    void orInto(vector<uint64_t>& words) const;
+    static RowBitmap fromWords(const vector<uint64_t>& words);
+
+    // Номера строк по возрастанию
+    void toRows(vector<uint32_t>& rows) const;
+    size_t memoryBytes() const;
+
+private:
+    static const size_t BLOCK_WORDS = 65536 / 64;
+
+    struct Container {
+        uint16_t key;
+        uint32_t cardinality;
+        vector<uint16_t> values;   // пока cardinality <= ARRAY_LIMIT
+        vector<uint64_t> bits;     // иначе BLOCK_WORDS слов
+
+        bool isBitset() const { return !bits.empty(); }
+    };
+
+    vector<Container> containers;
+
+    size_t lowerBound(uint16_t key) const;
+    const Container* find(uint16_t key) const;
+    static void toBitset(Container& container);
+    static void toArray(Container& container);
+    static bool intersect(Container& target, const Container& other);
+};
+
+#endif
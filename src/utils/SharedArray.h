@@ -0,0 +1,66 @@
+#ifndef SHAREDARRAY_H
+#define SHAREDARRAY_H
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+using namespace std;
+
+// Массив, элементы которого либо принадлежат ему, либо лежат в чужой
+// неизменяемой памяти (сегмент общего снимка). Чтение одинаково в обоих
+// случаях; первое изменение копирует чужие элементы в свой вектор
+template <typename T>
+class SharedArray {
+public:
+    SharedArray() : external(nullptr), externalSize(0) {}
+
+    // count элементов по адресу items; keeper удерживает память, пока массив ссылается на нее
+    void borrow(const T* items, size_t count, shared_ptr<const void> memory) {
+        owned = vector<T>();
+        external = items;
+        externalSize = count;
+        keeper = move(memory);
+    }
+
+    void clear() {
+        owned.clear();
+        external = nullptr;
+        externalSize = 0;
+        keeper.reset();
+    }
+
+    bool isBorrowed() const { return keeper != nullptr; }
+
+    const T* data() const { return keeper ? external : owned.data(); }
+    size_t size() const { return keeper ? externalSize : owned.size(); }
+    bool empty() const { return size() == 0; }
+    const T& operator[](size_t i) const { return data()[i]; }
+    const T& back() const { return data()[size() - 1]; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+
+    // Свой вектор для изменения; чужие элементы копируются при первом вызове
+    vector<T>& mutate() {
+        if (keeper) {
+            // Запас под дописывание: после копии вектор не удваивается сразу
+            owned.reserve(externalSize + externalSize / 8);
+            owned.assign(external, external + externalSize);
+            external = nullptr;
+            externalSize = 0;
+            keeper.reset();
+        }
+        return owned;
+    }
+
+    // Только своя память: чужая принадлежит сегменту и делится между программами
+    size_t memoryBytes() const { return owned.capacity() * sizeof(T); }
+
+private:
+    vector<T> owned;
+    const T* external;
+    size_t externalSize;
+    shared_ptr<const void> keeper;
+};
+
+#endif
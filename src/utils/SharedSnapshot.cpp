@@ -0,0 +1,270 @@
+#include "SharedSnapshot.h"
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pwd.h>
+#include <grp.h>
+
+using namespace std;
+using namespace SharedSnapshot;
+
+namespace {
+
+static_assert(atomic<uint64_t>::is_always_lock_free,
+              "эпоха читается и пишется разными процессами без блокировок");
+
+// Сегменты читают программы пользователей группы издателя
+const mode_t SEGMENT_MODE = 0640;
+// Повторы, если эпоха сменилась, пока читатель открывал ее сегмент
+const int READ_ATTEMPTS = 4;
+
+// Сегмент создан издателем, и никто другой не может его изменить
+bool trusted(const struct stat& st, uid_t owner) {
+    return st.st_uid == owner && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+// Отображение сегмента эпохи; снимается, когда его отпустит последний массив снимка
+struct MappedSegment {
+    void* addr;
+    size_t size;
+
+    MappedSegment(void* addr, size_t size) : addr(addr), size(size) {}
+    ~MappedSegment() { munmap(addr, size); }
+};
+
+void writeSegment(ImageWriter& out, const string& source, const string& watermark, const HouseSnapshot& snapshot) {
+    out.raw(SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    out.value<uint32_t>(VERSION);
+    out.text(source);
+    out.text(watermark);
+    snapshot.write(out);
+}
+
+bool attachSegment(const string& segment, uid_t owner, Attached& attached) {
+    int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && trusted(st, owner) && st.st_size > 0;
+    size_t size = ok ? static_cast<size_t>(st.st_size) : 0;
+    void* addr = ok ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (addr == MAP_FAILED) return false;
+
+    ImageReader in(static_cast<const char*>(addr), size, make_shared<MappedSegment>(addr, size));
+    const char* magic = in.raw(sizeof(SEGMENT_MAGIC));
+    uint32_t version = 0;
+    shared_ptr<HouseSnapshot> snapshot = make_shared<HouseSnapshot>();
+    if (!magic || memcmp(magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0 ||
+        !in.value(version) || version != VERSION ||
+        !in.text(attached.source) || !in.text(attached.watermark) || !snapshot->read(in)) {
+        return false;
+    }
+    attached.snapshot = move(snapshot);
+    return true;
+}
+
+// Управляющий сегмент издателя owner только для чтения; nullptr, если его нет или он чужой
+const ControlBlock* openControl(const string& name, uid_t owner, bool report) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(ControlBlock);
+    if (ok && !trusted(st, owner)) {
+        if (report) cerr << "Общий снимок " << name << " создан не издателем или доступен на запись, не используется" << endl;
+        ok = false;
+    }
+    void* addr = ok ? mmap(nullptr, sizeof(ControlBlock), PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (addr == MAP_FAILED) return nullptr;
+
+    const ControlBlock* control = static_cast<const ControlBlock*>(addr);
+    if (memcmp(control->magic, CONTROL_MAGIC, sizeof(CONTROL_MAGIC)) != 0 || control->version != VERSION) {
+        munmap(addr, sizeof(ControlBlock));
+        return nullptr;
+    }
+    return control;
+}
+
+void closeControl(const ControlBlock* control) {
+    munmap(const_cast<ControlBlock*>(control), sizeof(ControlBlock));
+}
+
+}
+
+string SharedSnapshot::segmentName(const string& name, uint64_t epoch) {
+    return name + "." + to_string(epoch);
+}
+
+bool SharedSnapshot::resolveUser(const string& user, uid_t& uid) {
+    if (user.empty()) return false;
+    if (struct passwd* entry = getpwnam(user.c_str())) {
+        uid = entry->pw_uid;
+        return true;
+    }
+    char* end = nullptr;
+    unsigned long value = strtoul(user.c_str(), &end, 10);
+    if (*end != '\0') return false;
+    uid = static_cast<uid_t>(value);
+    return true;
+}
+
+uint64_t SharedSnapshot::currentEpoch(const string& name, uid_t owner) {
+    const ControlBlock* control = openControl(name, owner, false);
+    if (!control) return 0;
+    uint64_t epoch = control->epoch.load(memory_order_acquire);
+    closeControl(control);
+    return epoch;
+}
+
+bool SharedSnapshot::attach(const string& name, uid_t owner, Attached& attached) {
+    const ControlBlock* control = openControl(name, owner, true);
+    if (!control) return false;
+
+    bool ok = false;
+    for (int attempt = 0; attempt < READ_ATTEMPTS && !ok; ++attempt) {
+        uint64_t current = control->epoch.load(memory_order_acquire);
+        if (current == 0) break;
+
+        ok = attachSegment(segmentName(name, current), owner, attached);
+        if (ok) attached.epoch = current;
+        // Эпоха не сменилась: сегмент не заменен, а отсутствует или поврежден
+        if (!ok && control->epoch.load(memory_order_acquire) == current) break;
+    }
+
+    closeControl(control);
+    return ok;
+}
+
+SharedSnapshotPublisher::SharedSnapshotPublisher(const string& name, const string& group)
+    : name(name), group(group), groupId(getegid()), controlFd(-1), control(nullptr), currentEpoch(0) {}
+
+SharedSnapshotPublisher::~SharedSnapshotPublisher() {
+    if (control) {
+        if (currentEpoch > 0) shm_unlink(segmentName(name, currentEpoch).c_str());
+        shm_unlink(name.c_str());
+        munmap(control, sizeof(ControlBlock));
+    }
+    // Закрытие снимает блокировку
+    if (controlFd >= 0) ::close(controlFd);
+}
+
+bool SharedSnapshotPublisher::open() {
+    if (!group.empty()) {
+        struct group* entry = getgrnam(group.c_str());
+        if (!entry) {
+            cerr << "Нет группы " << group << " для общего снимка" << endl;
+            return false;
+        }
+        groupId = entry->gr_gid;
+    }
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, SEGMENT_MODE);
+    if (fd < 0) {
+        cerr << "Ошибка открытия общей памяти " << name << ": " << strerror(errno) << endl;
+        return false;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        cerr << "Снимок " << name << " уже публикует другой процесс" << endl;
+        ::close(fd);
+        return false;
+    }
+
+    // Имя мог заранее занять другой пользователь: его сегменту программы не поверят
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_uid != geteuid()) {
+        cerr << "Общая память " << name << " принадлежит другому пользователю" << endl;
+        ::close(fd);
+        return false;
+    }
+    if (!restrict(fd)) {
+        ::close(fd);
+        return false;
+    }
+    bool ok = static_cast<size_t>(st.st_size) >= sizeof(ControlBlock) || ftruncate(fd, sizeof(ControlBlock)) == 0;
+    void* addr = ok ? mmap(nullptr, sizeof(ControlBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (addr == MAP_FAILED) {
+        cerr << "Ошибка отображения общей памяти " << name << ": " << strerror(errno) << endl;
+        ::close(fd);
+        return false;
+    }
+
+    control = static_cast<ControlBlock*>(addr);
+    if (memcmp(control->magic, CONTROL_MAGIC, sizeof(CONTROL_MAGIC)) == 0 && control->version == VERSION) {
+        // Сегмент издателя, завершившегося аварийно: нумерация эпох продолжается
+        currentEpoch = control->epoch.load(memory_order_acquire);
+    } else {
+        control->epoch.store(0, memory_order_relaxed);
+        control->version = VERSION;
+        control->reserved = 0;
+        memcpy(control->magic, CONTROL_MAGIC, sizeof(CONTROL_MAGIC));
+        currentEpoch = 0;
+    }
+    controlFd = fd;
+    return true;
+}
+
+bool SharedSnapshotPublisher::publish(const string& source, const string& watermark, const HouseSnapshot& snapshot) {
+    if (!control) return false;
+
+    uint64_t next = currentEpoch + 1;
+    string segment = segmentName(name, next);
+    // Остаток прерванной публикации
+    shm_unlink(segment.c_str());
+
+    int fd = shm_open(segment.c_str(), O_RDWR | O_CREAT | O_EXCL, SEGMENT_MODE);
+    if (fd < 0) {
+        cerr << "Ошибка создания сегмента " << segment << ": " << strerror(errno) << endl;
+        return false;
+    }
+    if (!restrict(fd)) {
+        ::close(fd);
+        shm_unlink(segment.c_str());
+        return false;
+    }
+
+    // Память выделяется заранее: при нехватке места ошибка, а не SIGBUS при записи
+    ImageWriter sizer;
+    writeSegment(sizer, source, watermark, snapshot);
+    size_t size = sizer.size();
+    bool ok = posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0;
+    void* addr = ok ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    ok = addr != MAP_FAILED;
+    if (ok) {
+        ImageWriter out(static_cast<char*>(addr));
+        writeSegment(out, source, watermark, snapshot);
+        munmap(addr, size);
+    } else {
+        cerr << "Ошибка записи сегмента " << segment << ": " << strerror(errno) << endl;
+        shm_unlink(segment.c_str());
+        return false;
+    }
+
+    // Сегмент полностью записан до того, как читатели увидят новую эпоху
+    control->epoch.store(next, memory_order_release);
+    if (currentEpoch > 0) shm_unlink(segmentName(name, currentEpoch).c_str());
+    currentEpoch = next;
+    return true;
+}
+
+uint64_t SharedSnapshotPublisher::epoch() const {
+    return currentEpoch;
+}
+
+bool SharedSnapshotPublisher::restrict(int fd) {
+    // Права не зависят от umask издателя; группа - пользователи программы
+    if ((groupId != getegid() && fchown(fd, static_cast<uid_t>(-1), groupId) != 0) ||
+        fchmod(fd, SEGMENT_MODE) != 0) {
+        cerr << "Ошибка прав общей памяти " << name << ": " << strerror(errno) << endl;
+        return false;
+    }
+    return true;
+}
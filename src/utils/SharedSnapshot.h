@@ -0,0 +1,88 @@
+#ifndef SHAREDSNAPSHOT_H
+#define SHAREDSNAPSHOT_H
+
+#include <string>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <sys/types.h>
+#include "HouseSnapshot.h"
+
+using namespace std;
+
+// Снимок домов в общей памяти POSIX для программ на одном терминальном сервере.
+//
+// Управляющий сегмент <name> хранит номер текущей эпохи, эпоха лежит в
+// сегменте <name>.<эпоха>: источник, метка и образ HouseSnapshot - столбцы,
+// словарь адресов и индексы. Издатель пишет эпоху целиком, атомарно
+// переключает номер и удаляет имя прежнего сегмента. Программа не копирует
+// эпоху, а держит ее отображение, пока показывает снимок; память прежнего
+// сегмента освобождается, когда его отпустит последняя программа.
+// name - имя в смысле shm_open, например "/housing_fund".
+//
+// Сегменты доступны на чтение только группе издателя (0640). Имя в /dev/shm
+// может занять любой пользователь, поэтому читатель принимает лишь сегменты
+// ожидаемого владельца без права записи для группы и остальных
+namespace SharedSnapshot {
+    constexpr char CONTROL_MAGIC[8] = {'H', 'S', 'H', 'M', 'C', 'T', 'L', '1'};
+    constexpr char SEGMENT_MAGIC[8] = {'H', 'S', 'H', 'M', 'S', 'N', 'P', '2'};
+    constexpr uint32_t VERSION = 2;
+
+    struct ControlBlock {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        atomic<uint64_t> epoch;     // 0 - снимок еще не опубликован
+    };
+
+    // Отображенная эпоха. Массивы снимка ссылаются на сегмент и держат его
+    // отображение, пока жив снимок; правки программы хранятся в самом снимке
+    struct Attached {
+        uint64_t epoch = 0;
+        string source;      // база, из которой получен снимок
+        string watermark;   // изменения с этой метки в снимке не учтены
+        shared_ptr<HouseSnapshot> snapshot;
+    };
+
+    string segmentName(const string& name, uint64_t epoch);
+
+    // uid по имени пользователя или числу; false, если такого пользователя нет
+    bool resolveUser(const string& user, uid_t& uid);
+
+    // Номер текущей эпохи без отображения ее сегмента; 0, если издателя нет
+    // или управляющий сегмент чужой. Дешево: годится для опроса по таймеру
+    uint64_t currentEpoch(const string& name, uid_t owner);
+    // Текущая эпоха; false, если издателя нет, сегмент чужой или поврежден
+    bool attach(const string& name, uid_t owner, Attached& attached);
+}
+
+// Единственный издатель: второй процесс не получит блокировку управляющего сегмента
+class SharedSnapshotPublisher {
+public:
+    // group - группа, которой сегменты доступны на чтение; пустая - основная группа процесса
+    explicit SharedSnapshotPublisher(const string& name, const string& group = "");
+    // Удаляет сегменты: программы снова загружают дома из базы
+    ~SharedSnapshotPublisher();
+
+    SharedSnapshotPublisher(const SharedSnapshotPublisher&) = delete;
+    SharedSnapshotPublisher& operator=(const SharedSnapshotPublisher&) = delete;
+
+    // false, если сегмент не создать или другой издатель уже работает
+    bool open();
+    // snapshot - только что собранный, без правок
+    bool publish(const string& source, const string& watermark, const HouseSnapshot& snapshot);
+    uint64_t epoch() const;
+
+private:
+    string name;
+    string group;
+    gid_t groupId;
+    int controlFd;
+    SharedSnapshot::ControlBlock* control;
+    uint64_t currentEpoch;
+
+    // Владелец-группа и права SEGMENT_MODE для созданного сегмента
+    bool restrict(int fd);
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "SnapshotCache.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <functional>
+#include <filesystem>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const size_t HEADER_SIZE = 40;
+
+size_t alignUp(size_t offset) {
+    return (offset + 7) & ~size_t(7);
+}
+
+// Смещения блоков файла; end - размер всего файла
+struct Layout {
+    size_t ids, apartments, buildYears, floors, totalAreas, addressOffsets, addressLengths, addressData, end;
+};
+
+Layout layoutFor(size_t stringBytes, size_t rows, size_t addressBytes) {
+    Layout layout;
+    layout.ids = alignUp(HEADER_SIZE + stringBytes);
+    layout.apartments = alignUp(layout.ids + rows * sizeof(int32_t));
+    layout.buildYears = alignUp(layout.apartments + rows * sizeof(int32_t));
+    layout.floors = alignUp(layout.buildYears + rows * sizeof(int32_t));
+    layout.totalAreas = alignUp(layout.floors + rows * sizeof(int32_t));
+    layout.addressOffsets = alignUp(layout.totalAreas + rows * sizeof(int64_t));
+    layout.addressLengths = alignUp(layout.addressOffsets + rows * sizeof(uint32_t));
+    layout.addressData = alignUp(layout.addressLengths + rows * sizeof(uint32_t));
+    layout.end = layout.addressData + addressBytes;
+    return layout;
+}
+
+template <typename T>
+T readAt(const char* data, size_t offset) {
+    T value;
+    memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void writeAt(char* out, size_t offset, T value) {
+    memcpy(out + offset, &value, sizeof(T));
+}
+
+// Блок столбца и нули до начала следующего блока
+void writeBlock(char* out, size_t offset, const void* values, size_t bytes, size_t nextOffset) {
+    if (bytes > 0) memcpy(out + offset, values, bytes);
+    memset(out + offset + bytes, 0, nextOffset - offset - bytes);
+}
+
+template <typename T>
+const T* blockAt(const char* data, size_t offset) {
+    return reinterpret_cast<const T*>(data + offset);
+}
+
+}
+
+bool SnapshotCache::load(const string& filename, SnapshotCache& cache) {
+    MappedFile file;
+    return file.open(filename) && decode(file.data(), file.size(), cache);
+}
+
+bool SnapshotCache::save(const string& filename) const {
+    error_code error;
+    filesystem::path directory = filesystem::path(filename).parent_path();
+    if (!directory.empty()) filesystem::create_directories(directory, error);
+
+    // Свое имя временного файла у каждого процесса: одновременные записи не смешиваются
+    string tmpPath = filename + ".tmp" + to_string(getpid());
+    int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    // Файл заполняется через отображение тем же кодом, что и общая память.
+    // Место выделяется заранее: при нехватке диска ошибка, а не SIGBUS при записи
+    size_t size = encodedSize();
+    bool ok = posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0;
+    void* addr = ok ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ok = addr != MAP_FAILED;
+    if (ok) {
+        encode(static_cast<char*>(addr));
+        ok = munmap(addr, size) == 0 && fsync(fd) == 0;
+    }
+    if (::close(fd) != 0) ok = false;
+
+    if (!ok || rename(tmpPath.c_str(), filename.c_str()) != 0) {
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+size_t SnapshotCache::encodedSize() const {
+    return layoutFor(source.size() + watermark.size(), houses.size(), houses.addressBytes()).end;
+}
+
+void SnapshotCache::encode(char* out) const {
+    HouseTable::Columns columns = houses.columns();
+    size_t rows = columns.rows;
+    Layout layout = layoutFor(source.size() + watermark.size(), rows, columns.addressBytes);
+
+    // Промежутки выравнивания заполняются нулями
+    memset(out, 0, layout.ids);
+    memcpy(out, FILE_MAGIC, sizeof(FILE_MAGIC));
+    writeAt<uint32_t>(out, 8, VERSION);
+    writeAt<uint64_t>(out, 16, rows);
+    writeAt<uint64_t>(out, 24, columns.addressBytes);
+    writeAt<uint32_t>(out, 32, static_cast<uint32_t>(source.size()));
+    writeAt<uint32_t>(out, 36, static_cast<uint32_t>(watermark.size()));
+    memcpy(out + HEADER_SIZE, source.data(), source.size());
+    memcpy(out + HEADER_SIZE + source.size(), watermark.data(), watermark.size());
+
+    writeBlock(out, layout.ids, columns.ids, rows * sizeof(int32_t), layout.apartments);
+    writeBlock(out, layout.apartments, columns.apartments, rows * sizeof(int32_t), layout.buildYears);
+    writeBlock(out, layout.buildYears, columns.buildYears, rows * sizeof(int32_t), layout.floors);
+    writeBlock(out, layout.floors, columns.floors, rows * sizeof(int32_t), layout.totalAreas);
+    writeBlock(out, layout.totalAreas, columns.totalAreas, rows * sizeof(int64_t), layout.addressOffsets);
+    writeBlock(out, layout.addressOffsets, columns.addressOffsets, rows * sizeof(uint32_t), layout.addressLengths);
+    writeBlock(out, layout.addressLengths, columns.addressLengths, rows * sizeof(uint32_t), layout.addressData);
+    writeBlock(out, layout.addressData, columns.addressData, columns.addressBytes, layout.end);
+}
+
+bool SnapshotCache::decode(const char* data, size_t size, SnapshotCache& cache) {
+    if (size < HEADER_SIZE || memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+        readAt<uint32_t>(data, 8) != VERSION) {
+        return false;
+    }
+
+    uint64_t rows = readAt<uint64_t>(data, 16);
+    uint64_t addressBytes = readAt<uint64_t>(data, 24);
+    uint32_t sourceLength = readAt<uint32_t>(data, 32);
+    uint32_t watermarkLength = readAt<uint32_t>(data, 36);
+
+    // Размеры из заголовка проверяются до вычисления смещений, чтобы они не переполнились
+    if (rows > size / sizeof(int32_t) || addressBytes > size ||
+        uint64_t(sourceLength) + watermarkLength > size) {
+        return false;
+    }
+    Layout layout = layoutFor(sourceLength + watermarkLength, rows, addressBytes);
+    if (layout.end != size) return false;
+
+    HouseTable::Columns columns;
+    columns.rows = rows;
+    columns.ids = blockAt<int>(data, layout.ids);
+    columns.apartments = blockAt<int>(data, layout.apartments);
+    columns.buildYears = blockAt<int>(data, layout.buildYears);
+    columns.floors = blockAt<int>(data, layout.floors);
+    columns.totalAreas = blockAt<int64_t>(data, layout.totalAreas);
+    columns.addressOffsets = blockAt<uint32_t>(data, layout.addressOffsets);
+    columns.addressLengths = blockAt<uint32_t>(data, layout.addressLengths);
+    columns.addressData = data + layout.addressData;
+    columns.addressBytes = addressBytes;
+
+    // Слияние с изменениями рассчитывает на порядок id
+    if (adjacent_find(columns.ids, columns.ids + rows, greater_equal<int>()) != columns.ids + rows) {
+        return false;
+    }
+    if (!cache.houses.assign(columns)) return false;
+
+    cache.source.assign(data + HEADER_SIZE, sourceLength);
+    cache.watermark.assign(data + HEADER_SIZE + sourceLength, watermarkLength);
+    return true;
+}
+
+void SnapshotCache::merge(const HouseTable& houses, const HouseTable& changed, const vector<int>& removedIds,
+                          HouseTable& merged) {
+    merged.clear();
+    merged.reserve(houses.size() + changed.size(), houses.addressBytes() + changed.addressBytes());
+
+    auto removed = [&removedIds](int id) {
+        return binary_search(removedIds.begin(), removedIds.end(), id);
+    };
+
+    // Слияние двух упорядоченных по id наборов; измененная строка заменяет прежнюю
+    size_t row = 0;
+    size_t next = 0;
+    while (row < houses.size() || next < changed.size()) {
+        bool takeChanged = next < changed.size() &&
+                           (row >= houses.size() || changed.id(next) <= houses.id(row));
+        if (takeChanged) {
+            if (row < houses.size() && houses.id(row) == changed.id(next)) ++row;
+            if (!removed(changed.id(next))) merged.append(changed, next);
+            ++next;
+        } else {
+            if (!removed(houses.id(row))) merged.append(houses, row);
+            ++row;
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef SNAPSHOTCACHE_H
+#define SNAPSHOTCACHE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "HouseTable.h"
+
+using namespace std;
+
+// Локальный кэш всех домов (.hsc) для быстрого запуска: файл отображается в
+// память и показывается сразу, с сервера догружаются только изменения после метки.
+//
+// [заголовок: magic, версия, число строк, байты адресов, длины источника и метки]
+// [источник, метка]
+// [id][квартиры][годы][этажи] int32, [площади] int64, [смещения][длины адресов] uint32, [адреса]
+//
+// Каждый блок выровнен на 8 байт. Файл локальный, числа в порядке байтов машины
+struct SnapshotCache {
+    static constexpr char FILE_MAGIC[8] = {'H', 'S', 'N', 'A', 'P', 'C', '0', '1'};
+    static constexpr uint32_t VERSION = 1;
+
+    string source;      // база, из которой получен снимок: кэш другой базы не используется
+    string watermark;   // изменения с этой метки (updated_at >= watermark) в снимке не учтены
+    HouseTable houses;  // по возрастанию id
+
+    // false, если файла нет, он другой версии или поврежден
+    static bool load(const string& filename, SnapshotCache& cache);
+    // Записывает во временный файл, fsync и rename поверх старого:
+    // программа, отобразившая прежний файл, продолжает читать его
+    bool save(const string& filename) const;
+
+    // Тот же формат в памяти: файл заполняется через отображение.
+    // out - encodedSize() байт, выровнено на 8
+    size_t encodedSize() const;
+    void encode(char* out) const;
+    static bool decode(const char* data, size_t size, SnapshotCache& cache);
+
+    // Снимок после изменений: строки changed заменяют или дополняют houses,
+    // строки removedIds исключаются. Все три набора - по возрастанию id
+    static void merge(const HouseTable& houses, const HouseTable& changed, const vector<int>& removedIds,
+                      HouseTable& merged);
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "SnapshotImage.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+size_t alignUp(size_t offset) {
+    return (offset + 7) & ~size_t(7);
+}
+
+}
+
+ImageWriter::ImageWriter(char* out)
+    : out(out), offset(0) {}
+
+void ImageWriter::text(const string& item) {
+    array(item.data(), item.size());
+}
+
+void ImageWriter::raw(const void* data, size_t bytes) {
+    put(data, bytes);
+}
+
+size_t ImageWriter::size() const {
+    return offset;
+}
+
+void ImageWriter::put(const void* data, size_t bytes) {
+    size_t next = alignUp(offset + bytes);
+    if (out) {
+        if (bytes > 0) memcpy(out + offset, data, bytes);
+        // Промежутки выравнивания заполняются нулями
+        memset(out + offset + bytes, 0, next - offset - bytes);
+    }
+    offset = next;
+}
+
+ImageReader::ImageReader(const char* data, size_t size, shared_ptr<const void> memory)
+    : data(data), size(size), offset(0), keeper(move(memory)) {
+    // Массивы читаются на месте: начало образа должно быть выровнено
+    if (reinterpret_cast<uintptr_t>(data) % 8 != 0) this->size = 0;
+}
+
+bool ImageReader::text(string& item) {
+    uint64_t length = 0;
+    if (!value(length) || length > size - offset) return false;
+    const char* at = take(length);
+    if (!at) return false;
+    item.assign(at, length);
+    return true;
+}
+
+const char* ImageReader::raw(size_t bytes) {
+    return take(bytes);
+}
+
+const char* ImageReader::take(size_t bytes) {
+    if (bytes > size - offset) return nullptr;
+    const char* at = data + offset;
+    offset = min(size, alignUp(offset + bytes));
+    return at;
+}
@@ -0,0 +1,92 @@
+#ifndef SNAPSHOTIMAGE_H
+#define SNAPSHOTIMAGE_H
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "SharedArray.h"
+
+using namespace std;
+
+// Образ неизменяемых массивов снимка одним блоком памяти, например в сегменте
+// общей памяти. Значение занимает 8 байт, массив - число элементов и сами
+// элементы, каждый блок выровнен на 8 байт. Числа в порядке байтов машины.
+//
+// Запись в два прохода: без буфера только считается размер, затем тот же код
+// заполняет буфер. Чтение не копирует массивы, а ссылается на них
+class ImageWriter {
+public:
+    // out == nullptr - только подсчет размера; иначе out выровнен на 8
+    explicit ImageWriter(char* out = nullptr);
+
+    template <typename T>
+    void value(T item) {
+        static_assert(is_trivially_copyable<T>::value && sizeof(T) <= 8, "значение образа - до 8 байт");
+        put(&item, sizeof(T));
+    }
+
+    template <typename T>
+    void array(const T* items, size_t count) {
+        static_assert(is_trivially_copyable<T>::value && alignof(T) <= 8, "элементы копируются побайтно");
+        value<uint64_t>(count);
+        put(items, count * sizeof(T));
+    }
+
+    template <typename T>
+    void array(const SharedArray<T>& items) {
+        array(items.data(), items.size());
+    }
+
+    void text(const string& item);
+    // Байты без длины, например сигнатура
+    void raw(const void* data, size_t bytes);
+
+    size_t size() const;
+
+private:
+    char* out;
+    size_t offset;
+
+    void put(const void* data, size_t bytes);
+};
+
+class ImageReader {
+public:
+    // memory удерживает data, пока на массивы образа ссылаются прочитанные структуры
+    ImageReader(const char* data, size_t size, shared_ptr<const void> memory);
+
+    template <typename T>
+    bool value(T& item) {
+        const char* at = take(sizeof(T));
+        if (!at) return false;
+        memcpy(&item, at, sizeof(T));
+        return true;
+    }
+
+    template <typename T>
+    bool array(SharedArray<T>& items) {
+        uint64_t count = 0;
+        if (!value(count) || count > (size - offset) / sizeof(T)) return false;
+        const char* at = take(count * sizeof(T));
+        if (!at) return false;
+        items.borrow(reinterpret_cast<const T*>(at), count, keeper);
+        return true;
+    }
+
+    bool text(string& item);
+    const char* raw(size_t bytes);
+
+private:
+    const char* data;
+    size_t size;
+    size_t offset;
+    shared_ptr<const void> keeper;
+
+    // Блок bytes байт с текущего места; nullptr, если образ короче
+    const char* take(size_t bytes);
+};
+
+#endif
@@ -0,0 +1,425 @@
+#include "TrigramIndex.h"
+#include <algorithm>
+#include <functional>
+
+using namespace std;
+
+namespace {
+
+// Байт некорректной последовательности UTF-8 кодируется вне диапазона Unicode
+const uint32_t INVALID_BYTE_BASE = 0x110000;
+
+// Следующий символ UTF-8; некорректный байт возвращается как отдельный код
+uint32_t decodeUtf8(string_view text, size_t& pos) {
+    unsigned char c = static_cast<unsigned char>(text[pos]);
+    size_t length = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+    if (length == 0 || pos + length > text.size()) {
+        pos++;
+        return INVALID_BYTE_BASE + c;
+    }
+    if (length == 1) {
+        pos++;
+        return c;
+    }
+
+    uint32_t code = c & (0xFF >> (length + 1));
+    for (size_t i = 1; i < length; ++i) {
+        unsigned char next = static_cast<unsigned char>(text[pos + i]);
+        if ((next & 0xC0) != 0x80) {
+            pos++;
+            return INVALID_BYTE_BASE + c;
+        }
+        code = (code << 6) | (next & 0x3F);
+    }
+    pos += length;
+    return code;
+}
+
+void encodeUtf8(uint32_t code, string& out) {
+    if (code >= INVALID_BYTE_BASE) {
+        out += static_cast<char>(code - INVALID_BYTE_BASE);
+    } else if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+// Поиск образца в множестве коротких строк: таблица сдвигов Хорспула
+// строится один раз на запрос, а не на каждую строку, как в memmem
+class SubstringMatcher {
+public:
+    explicit SubstringMatcher(const string& needle)
+        : needle(needle), searcher(this->needle.begin(), this->needle.end()) {}
+
+    bool operator()(string_view text) const {
+        return search(text.begin(), text.end(), searcher) != text.end();
+    }
+
+private:
+    string needle;
+    boyer_moore_horspool_searcher<string::const_iterator> searcher;
+};
+
+uint32_t foldCode(uint32_t code) {
+    if (code >= 'A' && code <= 'Z') return code + 32;
+    if (code >= 0xC0 && code <= 0xDE && code != 0xD7) return code + 32;      // Latin-1
+    if (code >= 0x410 && code <= 0x42F) return code + 32;                    // А-Я
+    if (code >= 0x400 && code <= 0x40F) return code + 80;                    // Ё и др.
+    return code;
+}
+
+}
+
+TrigramIndex::TrigramIndex()
+    : presentCount(0), lastValid(false) {
+    clear();
+}
+
+void TrigramIndex::clear() {
+    postingKeys.clear();
+    postingOffsets.clear();
+    postingOffsets.mutate().push_back(0);
+    postingDocuments.clear();
+    foldedData.clear();
+    foldedOffsets.clear();
+    foldedOffsets.mutate().push_back(0);
+    addedPostings.clear();
+    editedTexts.clear();
+    edited.clear();
+    present.clear();
+    presentCount = 0;
+    lastValid = false;
+}
+
+void TrigramIndex::build(const vector<string_view>& texts) {
+    clear();
+
+    vector<char>& data = foldedData.mutate();
+    vector<uint32_t>& offsets = foldedOffsets.mutate();
+    offsets.reserve(texts.size() + 1);
+    for (string_view source : texts) {
+        string folded = foldCase(source);
+        data.insert(data.end(), folded.begin(), folded.end());
+        offsets.push_back(static_cast<uint32_t>(data.size()));
+    }
+    edited.assign(texts.size(), false);
+    present.assign(texts.size(), true);
+    presentCount = texts.size();
+
+    // Два прохода: сначала число документов каждой триграммы, затем документы
+    // на свои места. Документы идут по возрастанию, поэтому списки отсортированы
+    vector<uint64_t> trigrams;
+    unordered_map<uint64_t, uint32_t> cursors;
+    for (uint32_t document = 0; document < texts.size(); ++document) {
+        collectTrigrams(text(document), trigrams);
+        for (uint64_t trigram : trigrams) cursors[trigram]++;
+    }
+
+    vector<uint64_t>& keys = postingKeys.mutate();
+    keys.reserve(cursors.size());
+    for (const auto& entry : cursors) keys.push_back(entry.first);
+    sort(keys.begin(), keys.end());
+
+    vector<uint32_t>& listOffsets = postingOffsets.mutate();
+    listOffsets.resize(keys.size() + 1);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        uint32_t& cursor = cursors[keys[i]];
+        listOffsets[i + 1] = listOffsets[i] + cursor;
+        cursor = listOffsets[i];
+    }
+
+    vector<uint32_t>& documents = postingDocuments.mutate();
+    documents.resize(listOffsets.back());
+    for (uint32_t document = 0; document < texts.size(); ++document) {
+        collectTrigrams(text(document), trigrams);
+        for (uint64_t trigram : trigrams) documents[cursors[trigram]++] = document;
+    }
+}
+
+void TrigramIndex::add(uint32_t document, const string& text) {
+    if (document < present.size() && present[document]) {
+        remove(document);
+    }
+    addEdited(document, foldCase(text));
+}
+
+void TrigramIndex::remove(uint32_t document) {
+    if (document >= present.size() || !present[document]) return;
+
+    // Собранные списки не меняются: документ отсекается по present
+    if (edited[document]) {
+        vector<uint64_t> trigrams;
+        collectTrigrams(text(document), trigrams);
+        for (uint64_t trigram : trigrams) {
+            auto it = addedPostings.find(trigram);
+            if (it == addedPostings.end()) continue;
+
+            vector<uint32_t>& list = it->second;
+            auto pos = lower_bound(list.begin(), list.end(), document);
+            if (pos != list.end() && *pos == document) list.erase(pos);
+            if (list.empty()) addedPostings.erase(it);
+        }
+        editedTexts.erase(document);
+        edited[document] = false;
+    }
+
+    present[document] = false;
+    presentCount--;
+    lastValid = false;
+}
+
+void TrigramIndex::update(uint32_t document, const string& text) {
+    remove(document);
+    addEdited(document, foldCase(text));
+}
+
+const vector<uint32_t>& TrigramIndex::find(const string& pattern) {
+    string needle = foldCase(pattern);
+    if (lastValid && needle == lastPattern) return lastResult;
+
+    vector<uint32_t> result;
+    SubstringMatcher matches(needle);
+    if (needle.empty()) {
+        result.reserve(presentCount);
+        for (size_t i = 0; i < present.size(); ++i) {
+            if (present[i]) result.push_back(static_cast<uint32_t>(i));
+        }
+    } else if (lastValid && !lastPattern.empty() && needle.find(lastPattern) != string::npos) {
+        // Запрос уточняет предыдущий: новые совпадения - подмножество прежних
+        for (uint32_t document : lastResult) {
+            if (matches(text(document))) result.push_back(document);
+        }
+    } else {
+        vector<uint64_t> trigrams;
+        collectTrigrams(needle, trigrams);
+
+        if (trigrams.empty()) {
+            // Короче трех символов: проверяем все строки
+            for (size_t i = 0; i < present.size(); ++i) {
+                uint32_t document = static_cast<uint32_t>(i);
+                if (present[i] && matches(text(document))) result.push_back(document);
+            }
+        } else {
+            // Собранный список триграммы дополняется списком правок
+            vector<PostingList> lists;
+            vector<vector<uint32_t>> merged;
+            merged.reserve(trigrams.size());
+            bool missing = false;
+            for (uint64_t trigram : trigrams) {
+                PostingList list = builtPostings(trigram);
+                auto added = addedPostings.find(trigram);
+                if (added != addedPostings.end() && list.count == 0) {
+                    list = {added->second.data(), added->second.size()};
+                } else if (added != addedPostings.end()) {
+                    merged.emplace_back(list.count + added->second.size());
+                    vector<uint32_t>& both = merged.back();
+                    auto last = std::merge(list.documents, list.documents + list.count,
+                                           added->second.begin(), added->second.end(), both.begin());
+                    both.erase(unique(both.begin(), last), both.end());
+                    list = {both.data(), both.size()};
+                }
+                if (list.count == 0) {
+                    missing = true;
+                    break;
+                }
+                lists.push_back(list);
+            }
+
+            if (!missing) {
+                // Начинаем с самого короткого списка, дальше он только сужается
+                sort(lists.begin(), lists.end(),
+                     [](const PostingList& a, const PostingList& b) { return a.count < b.count; });
+                vector<uint32_t> candidates;
+                if (lists.size() == 1) {
+                    candidates.assign(lists[0].documents, lists[0].documents + lists[0].count);
+                } else {
+                    intersect(lists[0], lists[1], candidates);
+                    for (size_t i = 2; i < lists.size() && !candidates.empty(); ++i) {
+                        intersect({candidates.data(), candidates.size()}, lists[i], candidates);
+                    }
+                }
+
+                // Образец из одной триграммы: совпадение по списку точное, кроме
+                // документов, измененных после сборки. Триграммы могут стоять
+                // в строке не подряд - тогда проверяем подстроку
+                bool exact = trigrams.size() == 1 && codePointCount(needle) == 3;
+                result.reserve(candidates.size());
+                for (uint32_t document : candidates) {
+                    if (!present[document]) continue;
+                    if ((exact && !edited[document]) || matches(text(document))) result.push_back(document);
+                }
+            }
+        }
+    }
+
+    lastPattern = move(needle);
+    lastResult = move(result);
+    lastValid = true;
+    return lastResult;
+}
+
+size_t TrigramIndex::documentCount() const {
+    return presentCount;
+}
+
+size_t TrigramIndex::trigramCount() const {
+    size_t count = postingKeys.size();
+    for (const auto& entry : addedPostings) {
+        if (builtPostings(entry.first).count == 0) count++;
+    }
+    return count;
+}
+
+size_t TrigramIndex::memoryBytes() const {
+    size_t bytes = postingKeys.memoryBytes() + postingOffsets.memoryBytes() + postingDocuments.memoryBytes() +
+                   foldedData.memoryBytes() + foldedOffsets.memoryBytes();
+    bytes += addedPostings.bucket_count() * sizeof(void*);
+    for (const auto& entry : addedPostings) {
+        bytes += sizeof(entry) + entry.second.capacity() * sizeof(uint32_t);
+    }
+    for (const auto& entry : editedTexts) {
+        bytes += sizeof(entry) + (entry.second.capacity() > 15 ? entry.second.capacity() : 0);
+    }
+    return bytes + (present.capacity() + edited.capacity()) / 8;
+}
+
+void TrigramIndex::write(ImageWriter& out) const {
+    out.array(postingKeys);
+    out.array(postingOffsets);
+    out.array(postingDocuments);
+    out.array(foldedData);
+    out.array(foldedOffsets);
+}
+
+bool TrigramIndex::read(ImageReader& in) {
+    clear();
+    if (!in.array(postingKeys) || !in.array(postingOffsets) || !in.array(postingDocuments) ||
+        !in.array(foldedData) || !in.array(foldedOffsets)) {
+        return false;
+    }
+    if (postingOffsets.size() != postingKeys.size() + 1 || postingOffsets.back() != postingDocuments.size() ||
+        foldedOffsets.empty() || foldedOffsets.back() != foldedData.size()) {
+        return false;
+    }
+
+    edited.assign(builtCount(), false);
+    present.assign(builtCount(), true);
+    presentCount = builtCount();
+    return true;
+}
+
+string TrigramIndex::foldCase(string_view text) {
+    string result;
+    result.reserve(text.size());
+    size_t pos = 0;
+    while (pos < text.size()) {
+        encodeUtf8(foldCode(decodeUtf8(text, pos)), result);
+    }
+    return result;
+}
+
+void TrigramIndex::collectTrigrams(string_view foldedText, vector<uint64_t>& trigrams) {
+    trigrams.clear();
+
+    // Три кода по 21 бит в одном 64-битном ключе
+    uint64_t window = 0;
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos < foldedText.size()) {
+        window = ((window << 21) | decodeUtf8(foldedText, pos)) & ((uint64_t(1) << 63) - 1);
+        if (++count >= 3) trigrams.push_back(window);
+    }
+
+    sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+string_view TrigramIndex::text(uint32_t document) const {
+    if (edited[document]) return editedTexts.find(document)->second;
+    return string_view(foldedData.data() + foldedOffsets[document],
+                       foldedOffsets[document + 1] - foldedOffsets[document]);
+}
+
+size_t TrigramIndex::builtCount() const {
+    return foldedOffsets.size() - 1;
+}
+
+TrigramIndex::PostingList TrigramIndex::builtPostings(uint64_t trigram) const {
+    auto it = lower_bound(postingKeys.begin(), postingKeys.end(), trigram);
+    if (it == postingKeys.end() || *it != trigram) return {nullptr, 0};
+    size_t i = it - postingKeys.begin();
+    return {postingDocuments.data() + postingOffsets[i], postingOffsets[i + 1] - postingOffsets[i]};
+}
+
+void TrigramIndex::intersect(PostingList shorter, PostingList longer, vector<uint32_t>& result) {
+    // result может совпадать с shorter: запись никогда не обгоняет чтение
+    const bool inPlace = shorter.documents == result.data();
+    if (!inPlace) result.clear();
+    size_t kept = 0;
+    size_t from = 0;
+    for (size_t i = 0; i < shorter.count; ++i) {
+        uint32_t document = shorter.documents[i];
+        // Галопирующий поиск: шаг растет, пока не перешагнем документ
+        size_t step = 1;
+        size_t hi = from;
+        while (hi < longer.count && longer.documents[hi] < document) {
+            from = hi + 1;
+            hi += step;
+            step <<= 1;
+        }
+        from = lower_bound(longer.documents + from, longer.documents + min(hi, longer.count), document) -
+               longer.documents;
+        if (from == longer.count) break;
+        if (longer.documents[from] == document) {
+            if (inPlace) result[kept] = document;
+            else result.push_back(document);
+            kept++;
+        }
+    }
+    if (inPlace) result.resize(kept);
+}
+
+size_t TrigramIndex::codePointCount(const string& text) {
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        decodeUtf8(text, pos);
+        count++;
+    }
+    return count;
+}
+
+void TrigramIndex::addEdited(uint32_t document, string&& foldedText) {
+    if (document >= present.size()) {
+        present.resize(document + 1, false);
+        edited.resize(document + 1, false);
+    }
+
+    vector<uint64_t> trigrams;
+    collectTrigrams(foldedText, trigrams);
+    for (uint64_t trigram : trigrams) {
+        vector<uint32_t>& list = addedPostings[trigram];
+        if (list.empty() || list.back() < document) {
+            list.push_back(document);
+        } else {
+            list.insert(lower_bound(list.begin(), list.end(), document), document);
+        }
+    }
+
+    editedTexts[document] = move(foldedText);
+    edited[document] = true;
+    present[document] = true;
+    presentCount++;
+    lastValid = false;
+}
@@ -0,0 +1,86 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "SharedArray.h"
+#include "SnapshotImage.h"
+
+using namespace std;
+
+// Индекс триграмм по строкам без учета регистра для поиска подстроки.
+// Документ - номер строки (например, позиция дома в снимке); списки
+// документов по каждой триграмме отсортированы и пересекаются при поиске,
+// найденные кандидаты проверяются поиском подстроки.
+//
+// Собранный индекс - несколько плоских массивов, которые не меняются до
+// следующей сборки и читаются из образа на месте. Правки после сборки
+// хранятся отдельно: списки новых текстов дополняют собранные, а лишние
+// кандидаты из прежних списков измененного документа отсекает проверка
+class TrigramIndex {
+public:
+    TrigramIndex();
+
+    void clear();
+    // Документ i - texts[i]
+    void build(const vector<string_view>& texts);
+    void add(uint32_t document, const string& text);
+    void remove(uint32_t document);
+    void update(uint32_t document, const string& text);
+
+    // Документы, содержащие pattern без учета регистра, по возрастанию номера.
+    // Если pattern продолжает предыдущий запрос, проверяется только прежний результат
+    const vector<uint32_t>& find(const string& pattern);
+
+    size_t documentCount() const;
+    size_t trigramCount() const;
+    size_t memoryBytes() const;
+
+    // Образ собранного индекса: правки после build в него не попадают
+    void write(ImageWriter& out) const;
+    bool read(ImageReader& in);
+
+    // Нижний регистр для латиницы и кириллицы, результат в UTF-8
+    static string foldCase(string_view text);
+
+private:
+    struct PostingList {
+        const uint32_t* documents;
+        size_t count;
+    };
+
+    // Ключи триграмм по возрастанию; документы ключа i -
+    // postingDocuments[postingOffsets[i]..postingOffsets[i + 1])
+    SharedArray<uint64_t> postingKeys;
+    SharedArray<uint32_t> postingOffsets;
+    SharedArray<uint32_t> postingDocuments;
+    // Тексты в нижнем регистре подряд, текст документа i начинается с foldedOffsets[i]
+    SharedArray<char> foldedData;
+    SharedArray<uint32_t> foldedOffsets;
+
+    // Правки после сборки: списки и тексты новых и измененных документов
+    unordered_map<uint64_t, vector<uint32_t>> addedPostings;
+    unordered_map<uint32_t, string> editedTexts;
+    vector<bool> edited;
+    vector<bool> present;
+    size_t presentCount;
+
+    string lastPattern;
+    vector<uint32_t> lastResult;
+    bool lastValid;
+
+    string_view text(uint32_t document) const;
+    size_t builtCount() const;
+    PostingList builtPostings(uint64_t trigram) const;
+    static void collectTrigrams(string_view foldedText, vector<uint64_t>& trigrams);
+    // Пересечение отсортированных списков; result может быть тем же массивом, что shorter
+    static void intersect(PostingList shorter, PostingList longer, vector<uint32_t>& result);
+    static size_t codePointCount(const string& text);
+    void addEdited(uint32_t document, string&& foldedText);
+};
+
+#endif